@@ -0,0 +1,136 @@
+/*
+ * Benchmark.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#ifndef PROCESSORS_BENCHMARK_H_
+#define PROCESSORS_BENCHMARK_H_
+
+#include <iostream>
+#include <new>
+#include <string>
+#include <stdlib.h>
+
+#include "Metrics.h"
+
+using namespace std;
+
+/*
+ * Replaces the global operator new to count allocations and the bytes
+ * requested, so this header
+ * must be included by exactly one translation unit of each benchmark.
+ */
+
+/* Number of calls to operator new since the program started */
+static long allocations = 0;
+
+/* Number of bytes requested from operator new since the program started */
+static long allocatedBytes = 0;
+
+#if __cplusplus >= 201103L
+#define THROWS_BAD_ALLOC
+#define THROWS_NOTHING noexcept
+#else
+#define THROWS_BAD_ALLOC throw (std::bad_alloc)
+#define THROWS_NOTHING throw ()
+#endif
+
+void* operator new(size_t size) THROWS_BAD_ALLOC {
+    allocations++;
+    allocatedBytes += size;
+    void* p = malloc(size == 0 ? 1 : size);
+    if (p == NULL)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) THROWS_NOTHING {
+    free(p);
+}
+
+namespace processors {
+
+/**
+ * Measures one benchmark: elapsed time and allocations between start() and
+ * stop(), and the amount of work done in between.
+ */
+class Benchmark {
+
+public:
+
+    /**
+     * Constructor.
+     * 	@param name Name reported in the results.
+     */
+    explicit Benchmark(const string &name) : name(name), seconds(0),
+            allocated(0), allocatedSize(0), iterations(0), tokens(0),
+            bytes(0), started(0), allocationsAtStart(0),
+            allocatedBytesAtStart(0) {
+    }
+
+    /** Start (or resume) timing. */
+    void start() {
+        allocationsAtStart = allocations;
+        allocatedBytesAtStart = allocatedBytes;
+        started = Metrics::now();
+    }
+
+    /**
+     * Stop timing and account for the work done since start().
+     * 	@param tokenCount Tokens processed.
+     * 	@param byteCount Bytes processed.
+     */
+    void stop(long tokenCount, long byteCount) {
+        seconds += Metrics::now() - started;
+        allocated += allocations - allocationsAtStart;
+        allocatedSize += allocatedBytes - allocatedBytesAtStart;
+        iterations++;
+        tokens += tokenCount;
+        bytes += byteCount;
+    }
+
+    /**
+     * Print the results as one JSON object per line.
+     * 	@param out The output stream.
+     */
+    void report(ostream &out) const {
+        double perToken = tokens > 0 ? (double) allocated / tokens : 0;
+        double bytesPerToken = tokens > 0
+                ? (double) allocatedSize / tokens : 0;
+        out << "{\"benchmark\": \"" << name << "\""
+                << ", \"iterations\": " << iterations
+                << ", \"seconds\": " << seconds
+                << ", \"tokens\": " << tokens
+                << ", \"bytes\": " << bytes
+                << ", \"tokens_per_sec\": " << rate(tokens)
+                << ", \"bytes_per_sec\": " << rate(bytes)
+                << ", \"allocs_per_token\": " << perToken
+                << ", \"alloc_bytes_per_token\": " << bytesPerToken << "}"
+                << endl;
+    }
+
+private:
+
+    /** Amount per second, or 0 if nothing was timed. */
+    double rate(long amount) const {
+        return seconds > 0 ? amount / seconds : 0;
+    }
+
+    string name;
+    double seconds;
+    long allocated;
+    long allocatedSize;
+    int iterations;
+    long tokens;
+    long bytes;
+    double started;
+    long allocationsAtStart;
+    long allocatedBytesAtStart;
+
+};
+
+}
+
+#endif /* PROCESSORS_BENCHMARK_H_ */
@@ -0,0 +1,183 @@
+/*
+ * CorpusGenerator.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#ifndef PROCESSORS_CORPUS_GENERATOR_H_
+#define PROCESSORS_CORPUS_GENERATOR_H_
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <ctype.h>
+#include <stdint.h>
+
+using namespace std;
+
+namespace processors {
+
+/**
+ * Settings for a synthetic corpus.
+ */
+struct CorpusOptions {
+    CorpusOptions() : sentences(10000), sentenceLength(25), nilDensity(0.2),
+            dependencies(true), trees(true), seed(1) { }
+
+    /* Number of sentences in the document */
+    int sentences;
+
+    /* Mean number of tokens per sentence; lengths are drawn uniformly
+     * from [1, 2 * sentenceLength - 1] */
+    int sentenceLength;
+
+    /* Probability that an optional column (tags, lemmas, entities, norms,
+     * chunks) is entirely NIL in a sentence */
+    double nilDensity;
+
+    /* Emit a dependency block (D ... EOX) for every sentence */
+    bool dependencies;
+
+    /* Emit a constituent tree (Y) for every sentence */
+    bool trees;
+
+    /* Seed of the generator; the same seed gives the same document */
+    uint32_t seed;
+};
+
+/**
+ * Writes synthetic documents in the CoreNLP text format read by
+ * DocumentSerializer::load. The output does not depend on the serializer,
+ * so it can be used to check it.
+ */
+class CorpusGenerator {
+
+public:
+
+    /**
+     * Constructor.
+     * 	@param options Shape of the corpus.
+     */
+    explicit CorpusGenerator(const CorpusOptions &options) :
+            options(options), state(options.seed ? options.seed : 1) {
+        const char *syllables[] = { "ka", "lo", "mi", "ne", "ru", "ta",
+                "shi", "ven", "dor", "ap", "el", "qu" };
+        for (int i = 0; i < 2000; i++) {
+            string word;
+            int n = 1 + i % 3;
+            for (int j = 0; j < n; j++)
+                word += syllables[(i * 7 + j * 5 + i / 12) % 12];
+            if (i % 17 == 0)
+                word[0] = word[0] - 'a' + 'A';
+            vocabulary.push_back(word);
+        }
+        vocabulary.push_back(".");
+        vocabulary.push_back(",");
+        vocabulary.push_back("\"quoted\"");
+        vocabulary.push_back("back\\slash");
+    }
+
+    /**
+     * Write one document.
+     * 	@param out The output stream.
+     * 	@return Number of tokens written.
+     */
+    long write(ostream &out) {
+        static const char *tags[] = { "NN", "NNS", "NNP", "VB", "VBD", "VBZ",
+                "DT", "JJ", "IN", "PRP", "RB", "CC", "." };
+        static const char *entities[] = { "O", "O", "O", "O", "PERSON",
+                "LOCATION", "ORGANIZATION", "DATE" };
+        static const char *chunks[] = { "B-NP", "I-NP", "B-VP", "I-VP",
+                "B-PP", "O" };
+        static const char *relations[] = { "nsubj", "dobj", "det", "amod",
+                "prep", "pobj", "punct" };
+
+        long tokens = 0;
+        out << "S\t" << options.sentences << "\n";
+        for (int s = 0; s < options.sentences; s++) {
+            int length = 1 + next(2 * options.sentenceLength - 1);
+            bool nilTags = chance(options.nilDensity);
+            bool nilLemmas = chance(options.nilDensity);
+            bool nilEntities = chance(options.nilDensity);
+            bool nilNorms = chance(options.nilDensity);
+            bool nilChunks = chance(options.nilDensity);
+
+            words.resize(length);
+            wordTags.resize(length);
+            out << "T\t" << length << "\n";
+            int offset = 0;
+            for (int i = 0; i < length; i++) {
+                const string &word = vocabulary[next(vocabulary.size())];
+                words[i] = word;
+                wordTags[i] = tags[next(13)];
+                out << word << '\t' << offset << '\t'
+                        << offset + word.size() << '\t';
+                out << (nilTags ? "_" : wordTags[i]) << '\t';
+                if (nilLemmas) {
+                    out << '_';
+                } else {
+                    for (unsigned int j = 0; j < word.size(); j++)
+                        out << (char) tolower(word[j]);
+                }
+                const char *entity = nilEntities ? "_" : entities[next(8)];
+                out << '\t' << entity << '\t';
+                if (nilNorms || string(entity) != "DATE")
+                    out << '_';
+                else
+                    out << "XXXX-" << 1 + next(12);
+                out << '\t' << (nilChunks ? "_" : chunks[next(6)]) << "\n";
+                offset += word.size() + 1;
+            }
+            tokens += length;
+
+            if (options.dependencies) {
+                out << "D\n";
+                for (int i = 1; i < length; i++)
+                    out << next(i) << '\t' << i << '\t'
+                            << relations[next(7)] << "\n";
+                out << "EOX\n";
+            }
+            if (options.trees) {
+                // A flat tree: ROOT -> S -> one preterminal per token
+                out << "Y\nROOT\t0\t0\t" << length << "\t1\tS\t0\t0\t"
+                        << length << '\t' << length;
+                for (int i = 0; i < length; i++) {
+                    out << '\t' << wordTags[i] << "\t0\t" << i << '\t'
+                            << i + 1 << "\t1\t" << words[i] << "\t0\t" << i
+                            << '\t' << i + 1 << "\t0";
+                }
+                out << "\n";
+            }
+            out << "EOS\n";
+        }
+        out << "EOD\n";
+        return tokens;
+    }
+
+private:
+
+    /** Uniform draw from [0, n), using xorshift32. */
+    uint32_t next(uint32_t n) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return n > 0 ? state % n : 0;
+    }
+
+    /** True with the given probability. */
+    bool chance(double p) {
+        return next(1000000) < p * 1000000;
+    }
+
+    CorpusOptions options;
+    uint32_t state;
+    vector<string> vocabulary;
+    vector<string> words;
+    vector<const char *> wordTags;
+
+};
+
+}
+
+#endif /* PROCESSORS_CORPUS_GENERATOR_H_ */
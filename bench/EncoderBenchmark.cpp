@@ -0,0 +1,118 @@
+/*
+ * EncoderBenchmark.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#include <iostream>
+#include <string>
+#include <stdlib.h>
+
+#include "Benchmark.h"
+#include "DocumentSerializer.h"
+
+using namespace std;
+using namespace processors;
+
+/**
+ * The SwiRL input as it used to be built: one getTokenizedText* call,
+ * a separate escaping pass, and the swirl code prepended.
+ */
+string legacyInput(const Sentence& sentence) {
+    string text, swirlCode;
+    if (sentence.entities.size() == sentence.words.size()) {
+        if (sentence.tags.size() == sentence.words.size()) {
+            for (unsigned int i = 0; i < sentence.words.size(); i++) {
+                text = text + sentence.words.str(i) + string(" ")
+                        + sentence.tag(i) + string(" ") + sentence.entity(i);
+                if (i < sentence.words.size() - 1)
+                    text = text + string(" ");
+            }
+            swirlCode = "1";
+        } else {
+            for (unsigned int i = 0; i < sentence.words.size(); i++) {
+                text = text + sentence.words.str(i) + string(" ")
+                        + sentence.entity(i);
+                if (i < sentence.words.size() - 1)
+                    text = text + string(" ");
+            }
+            swirlCode = "2";
+        }
+    } else {
+        for (unsigned int i = 0; i < sentence.words.size(); i++) {
+            text = text + sentence.words.str(i);
+            if (i < sentence.words.size() - 1)
+                text = text + string(" ");
+        }
+        swirlCode = "3";
+    }
+
+    string escaped;
+    for (string::size_type i = 0; i < text.length(); ++i) {
+        if (text[i] == '"' || text[i] == '\\')
+            escaped += '\\';
+        escaped += text[i];
+    }
+    return swirlCode + string(" ") + escaped;
+}
+
+/**
+ * Compare the legacy SwiRL input builder against Sentence::getSwirlInput,
+ * printing one JSON object per benchmark.
+ *  usage: encoder_bench <annotation-file> [iterations]
+ */
+int main(int argc, char ** argv) {
+    if (argc < 2) {
+        cerr << "usage: " << argv[0] << " <annotation-file> [iterations]\n";
+        return 1;
+    }
+    int iterations = (argc > 2) ? atoi(argv[2]) : 5;
+    MappedFile file(argv[1]);
+    if (!file.is_open()) {
+        cerr << "Failed to find annotation file!\n";
+        return 1;
+    }
+    Document doc;
+    DocumentSerializer::load(file, doc);
+    long tokens = 0;
+    for (unsigned int i = 0; i < doc.sentences.size(); i++)
+        tokens += doc.sentences[i].size();
+
+    // Both paths must produce the same lines
+    string line;
+    long bytes = 0;
+    for (unsigned int i = 0; i < doc.sentences.size(); i++) {
+        doc.sentences[i].getSwirlInput(line);
+        if (line != legacyInput(doc.sentences[i])) {
+            cerr << "Encoders disagree on sentence " << i << endl;
+            return 1;
+        }
+        bytes += line.size();
+    }
+
+    // What was built is counted, so that none of it is optimized away
+    long built = 0;
+    Benchmark legacy("encode_legacy");
+    for (int n = 0; n < iterations; n++) {
+        legacy.start();
+        for (unsigned int i = 0; i < doc.sentences.size(); i++)
+            built += legacyInput(doc.sentences[i]).size();
+        legacy.stop(tokens, bytes);
+    }
+
+    // The buffer is already warm from the check above
+    Benchmark encoder("encode_swirl_input");
+    for (int n = 0; n < iterations; n++) {
+        encoder.start();
+        for (unsigned int i = 0; i < doc.sentences.size(); i++) {
+            doc.sentences[i].getSwirlInput(line);
+            built += line.size();
+        }
+        encoder.stop(tokens, bytes);
+    }
+
+    legacy.report(cout);
+    encoder.report(cout);
+    return built == 0;
+}
@@ -0,0 +1,66 @@
+/*
+ * GenerateCorpus.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <stdlib.h>
+
+#include "CorpusGenerator.h"
+
+using namespace std;
+using namespace processors;
+
+/**
+ * Write a synthetic annotation file, e.g. as input for the other
+ * benchmarks.
+ *  usage: gen_corpus [--sentences N] [--length L] [--nil-density P]
+ *                    [--no-dependencies] [--no-trees] [--seed S] <output>
+ */
+int main(int argc, char ** argv) {
+    CorpusOptions options;
+    string output;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--sentences" && i + 1 < argc) {
+            options.sentences = atoi(argv[++i]);
+        } else if (arg == "--length" && i + 1 < argc) {
+            options.sentenceLength = atoi(argv[++i]);
+        } else if (arg == "--nil-density" && i + 1 < argc) {
+            options.nilDensity = atof(argv[++i]);
+        } else if (arg == "--no-dependencies") {
+            options.dependencies = false;
+        } else if (arg == "--no-trees") {
+            options.trees = false;
+        } else if (arg == "--seed" && i + 1 < argc) {
+            options.seed = atoi(argv[++i]);
+        } else if (output.empty() && arg[0] != '-') {
+            output = arg;
+        } else {
+            output.clear();
+            break;
+        }
+    }
+    if (output.empty() || options.sentences < 1
+            || options.sentenceLength < 1) {
+        cerr << "usage: " << argv[0] << " [--sentences N] [--length L]"
+                << " [--nil-density P] [--no-dependencies] [--no-trees]"
+                << " [--seed S] <output>\n";
+        return 1;
+    }
+
+    ofstream out(output.c_str());
+    if (!out.is_open()) {
+        cerr << "Failed to open output file!\n";
+        return 1;
+    }
+    CorpusGenerator generator(options);
+    long tokens = generator.write(out);
+    out.close();
+    cerr << options.sentences << " sentences, " << tokens << " tokens.\n";
+    return out ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+/*
+ * LoadBenchmark.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "Benchmark.h"
+#include "DocumentSerializer.h"
+
+using namespace std;
+using namespace processors;
+
+/**
+ * Count the tokens in a document.
+ *  @param doc The document.
+ *  @return Number of tokens over all sentences.
+ */
+long countTokens(Document &doc) {
+    long tokens = 0;
+    for (int i = 0; i < (int) doc.sentences.size(); i++)
+        tokens += doc.sentences.at(i).size();
+    return tokens;
+}
+
+/**
+ * Text form of a document, to compare the output of two loaders.
+ */
+string saved(const Document &doc) {
+    ostringstream out;
+    DocumentSerializer::save(doc, out);
+    return out.str();
+}
+
+/**
+ * Compare the stream loader against the memory-mapped loader, then time the
+ * parallel loader with 1, 2, 4, ... threads up to the number of CPUs, or up
+ * to max-threads if given, printing one JSON object per benchmark.
+ *  usage: load_bench <annotation-file> [iterations] [max-threads]
+ */
+int main(int argc, char ** argv) {
+    if (argc < 2) {
+        cerr << "usage: " << argv[0]
+                << " <annotation-file> [iterations] [max-threads]\n";
+        return 1;
+    }
+    string filename = argv[1];
+    int iterations = (argc > 2) ? atoi(argv[2]) : 3;
+
+    // The mapped loader must load the same document as the stream loader
+    MappedFile file(filename);
+    if (!file.is_open()) {
+        cerr << "Failed to find annotation file!\n";
+        return 1;
+    }
+    Document expectedDoc, streamDoc;
+    DocumentSerializer::load(file, expectedDoc);
+    ifstream check(filename.c_str());
+    DocumentSerializer::load(check, streamDoc);
+    long tokens = countTokens(expectedDoc);
+    if (countTokens(streamDoc) != tokens) {
+        cerr << "Token counts differ: " << countTokens(streamDoc) << " vs "
+                << tokens << endl;
+        return 1;
+    }
+    string expected = saved(expectedDoc);
+    long bytes = file.size();
+
+    Benchmark loadStream("load_stream");
+    Benchmark loadMapped("load_mapped");
+    for (int i = 0; i < iterations; i++) {
+        Document doc, mappedDoc;
+        loadStream.start();
+        ifstream stream(filename.c_str());
+        DocumentSerializer::load(stream, doc);
+        loadStream.stop(tokens, bytes);
+
+        loadMapped.start();
+        MappedFile mapped(filename);
+        DocumentSerializer::load(mapped, mappedDoc);
+        loadMapped.stop(tokens, bytes);
+    }
+    loadStream.report(cout);
+    loadMapped.report(cout);
+
+    // The parallel loader must produce the same document
+    int maxThreads = (argc > 3) ? atoi(argv[3])
+            : (int) sysconf(_SC_NPROCESSORS_ONLN);
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        char name[32];
+        snprintf(name, sizeof(name), "load_parallel_%d", threads);
+        Benchmark parallel(name);
+        for (int i = 0; i < iterations; i++) {
+            Document doc;
+            parallel.start();
+            DocumentSerializer::load(file, threads, doc);
+            parallel.stop(tokens, bytes);
+            if (i == 0 && saved(doc) != expected) {
+                cerr << "Parallel load with " << threads
+                        << " threads differs from the serial load" << endl;
+                return 1;
+            }
+        }
+        parallel.report(cout);
+    }
+    return 0;
+}
@@ -0,0 +1,145 @@
+/*
+ * SaveBenchmark.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "Benchmark.h"
+#include "DocumentSerializer.h"
+
+using namespace std;
+using namespace processors;
+
+/**
+ * Print one optional column the way the old writer did.
+ */
+void legacyColumn(bool present, const string &value, ostream &out) {
+    out << DocumentSerializer::SEP;
+    if (present)
+        out << value;
+    else
+        out << DocumentSerializer::NIL;
+}
+
+/**
+ * The previous writer: sentences copied by value, one stream insertion per
+ * field and a flush (endl) per line.
+ *  @param doc The document.
+ *  @param out The output stream.
+ */
+void legacySave(const Document &doc, ostream &out) {
+    const char SEP = DocumentSerializer::SEP;
+    out << DocumentSerializer::START_SENTENCES << SEP << doc.sentences.size()
+            << endl;
+    for (int i = 0; i < (int) doc.sentences.size(); i++) {
+        const Sentence &sentence = doc.sentences.at(i);
+        out << DocumentSerializer::START_TOKENS + SEP << sentence.size()
+                << endl;
+        for (int j = 0; j < sentence.size(); j++) {
+            out << sentence.words.str(j) + SEP << sentence.startOffsets.at(j)
+                    << SEP << sentence.endOffsets.at(j);
+            legacyColumn(!sentence.tags.empty(),
+                    sentence.tags.empty() ? "" : sentence.tag(j), out);
+            legacyColumn(!sentence.lemmas.empty(),
+                    sentence.lemmas.empty() ? "" : sentence.lemmas.str(j), out);
+            legacyColumn(!sentence.entities.empty(),
+                    sentence.entities.empty() ? "" : sentence.entity(j), out);
+            legacyColumn(!sentence.norms.empty(),
+                    sentence.norms.empty() ? "" : sentence.norms.str(j), out);
+            legacyColumn(!sentence.chunks.empty(),
+                    sentence.chunks.empty() ? "" : sentence.chunk(j), out);
+            out << endl;
+        }
+        const SyntacticTree &tree = sentence.syntacticTree;
+        if (!tree.empty()) {
+            out << DocumentSerializer::START_CONSTITUENTS << endl;
+            for (unsigned int k = 0; k < tree.nodes.size(); k++) {
+                const SyntacticTree::Node &node = tree.nodes[k];
+                if (k > 0)
+                    out << SEP;
+                out << node.value << SEP << node.head << SEP
+                        << node.startOffset << SEP << node.endOffset << SEP
+                        << node.children;
+            }
+            out << endl;
+        }
+        out << DocumentSerializer::END_OF_SENTENCE << endl;
+    }
+    out << DocumentSerializer::END_OF_DOCUMENT << endl;
+}
+
+/**
+ * Compare the old per-field stream writer against the buffered writer,
+ * both through a stream and straight to a file descriptor, printing one
+ * JSON object per benchmark.
+ *  usage: save_bench <annotation-file> [iterations]
+ */
+int main(int argc, char ** argv) {
+    if (argc < 2) {
+        cerr << "usage: " << argv[0] << " <annotation-file> [iterations]\n";
+        return 1;
+    }
+    MappedFile file(argv[1]);
+    if (!file.is_open()) {
+        cerr << "Cannot open " << argv[1] << endl;
+        return 1;
+    }
+    Document doc;
+    DocumentSerializer::load(file, doc);
+    int iterations = (argc > 2) ? atoi(argv[2]) : 3;
+    string scratch = "/tmp/save_bench.out";
+
+    // The output must not change
+    ostringstream legacyText, bufferedText;
+    legacySave(doc, legacyText);
+    DocumentSerializer::save(doc, bufferedText);
+    if (legacyText.str() != bufferedText.str()) {
+        cerr << "Outputs differ" << endl;
+        return 1;
+    }
+    long bytes = bufferedText.str().size();
+    long tokens = 0;
+    for (unsigned int i = 0; i < doc.sentences.size(); i++)
+        tokens += doc.sentences[i].size();
+
+    Benchmark legacy("save_legacy");
+    Benchmark stream("save_stream");
+    Benchmark sink("save_fd");
+    for (int i = 0; i < iterations; i++) {
+        legacy.start();
+        {
+            ofstream out(scratch.c_str());
+            legacySave(doc, out);
+        }
+        legacy.stop(tokens, bytes);
+
+        stream.start();
+        {
+            ofstream out(scratch.c_str());
+            DocumentSerializer::save(doc, out);
+        }
+        stream.stop(tokens, bytes);
+
+        sink.start();
+        int fd = open(scratch.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        FileSink fileSink(fd);
+        DocumentSerializer::save(doc, fileSink);
+        close(fd);
+        sink.stop(tokens, bytes);
+    }
+    unlink(scratch.c_str());
+
+    legacy.report(cout);
+    stream.report(cout);
+    sink.report(cout);
+    return 0;
+}
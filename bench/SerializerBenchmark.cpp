@@ -0,0 +1,239 @@
+/*
+ * SerializerBenchmark.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "Benchmark.h"
+#include "CorpusGenerator.h"
+#include "DocumentSerializer.h"
+#include "SentenceReader.h"
+
+using namespace std;
+using namespace processors;
+
+/**
+ * A sink that only counts the bytes written to it, so that save() is timed
+ * without any I/O.
+ */
+class CountingSink : public OutputSink {
+
+public:
+
+    CountingSink() : count(0) { }
+
+    bool write(const char *data, size_t length) {
+        count += length;
+        return true;
+    }
+
+    long count;
+
+};
+
+/**
+ * Time one of the getTokenizedText* builders, over the sentences that have
+ * the columns it needs.
+ */
+void benchmarkBuilder(const string &name, const Document &doc,
+        string (Sentence::*builder)() const, bool withTags,
+        bool withEntities, int iterations) {
+    Benchmark bench(name);
+    for (int n = 0; n < iterations; n++) {
+        long tokens = 0, bytes = 0;
+        bench.start();
+        for (unsigned int i = 0; i < doc.sentences.size(); i++) {
+            const Sentence &sentence = doc.sentences[i];
+            if ((withTags && sentence.tags.empty())
+                    || (withEntities && sentence.entities.empty()))
+                continue;
+            bytes += (sentence.*builder)().size();
+            tokens += sentence.size();
+        }
+        bench.stop(tokens, bytes);
+    }
+    bench.report(cout);
+}
+
+/**
+ * Time the serializer and the SwiRL input builders on a synthetic corpus,
+ * printing one JSON object per benchmark.
+ *  usage: serializer_bench [--sentences N] [--length L] [--nil-density P]
+ *                          [--no-dependencies] [--no-trees] [--seed S]
+ *                          [--iterations K]
+ */
+int main(int argc, char ** argv) {
+    CorpusOptions options;
+    int iterations = 3;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--sentences" && i + 1 < argc) {
+            options.sentences = atoi(argv[++i]);
+        } else if (arg == "--length" && i + 1 < argc) {
+            options.sentenceLength = atoi(argv[++i]);
+        } else if (arg == "--nil-density" && i + 1 < argc) {
+            options.nilDensity = atof(argv[++i]);
+        } else if (arg == "--no-dependencies") {
+            options.dependencies = false;
+        } else if (arg == "--no-trees") {
+            options.trees = false;
+        } else if (arg == "--seed" && i + 1 < argc) {
+            options.seed = atoi(argv[++i]);
+        } else if (arg == "--iterations" && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+        } else {
+            cerr << "usage: " << argv[0] << " [--sentences N] [--length L]"
+                    << " [--nil-density P] [--no-dependencies] [--no-trees]"
+                    << " [--seed S] [--iterations K]\n";
+            return 1;
+        }
+    }
+    if (options.sentences < 1 || options.sentenceLength < 1
+            || iterations < 1) {
+        cerr << "Sizes must be positive!\n";
+        return 1;
+    }
+
+    // Generate the corpus, in memory and in a file for the mapped loader
+    ostringstream generated;
+    CorpusGenerator generator(options);
+    long tokens = generator.write(generated);
+    string text = generated.str();
+    long bytes = text.size();
+
+    char scratch[] = "/tmp/serializer_bench.XXXXXX";
+    int fd = mkstemp(scratch);
+    if (fd < 0 || write(fd, text.data(), text.size()) != (ssize_t) bytes) {
+        cerr << "Failed to write the corpus!\n";
+        return 1;
+    }
+    close(fd);
+
+    cout << "{\"benchmark\": \"corpus\", \"sentences\": " << options.sentences
+            << ", \"tokens\": " << tokens << ", \"bytes\": " << bytes
+            << ", \"mean_length\": " << options.sentenceLength
+            << ", \"nil_density\": " << options.nilDensity
+            << ", \"seed\": " << options.seed << "}" << endl;
+
+    // Loaders
+    Benchmark loadStream("load_stream");
+    Benchmark loadMapped("load_mapped");
+    Document doc;
+    for (int n = 0; n < iterations; n++) {
+        // Each load fills a new document, as a reader of one file would
+        istringstream stream(text);
+        Document streamDoc;
+        loadStream.start();
+        DocumentSerializer::load(stream, streamDoc);
+        loadStream.stop(tokens, bytes);
+
+        Document mappedDoc;
+        loadMapped.start();
+        MappedFile file(scratch);
+        DocumentSerializer::load(file, mappedDoc);
+        loadMapped.stop(tokens, bytes);
+        doc.swap(mappedDoc);
+    }
+
+    // Sentence at a time, as the demo reads: every column, then only the
+    // ones SwiRL takes
+    Benchmark readMapped("read_mapped");
+    Benchmark readMappedSrl("read_mapped_srl");
+    unsigned int srl = DocumentSerializer::COLUMN_WORDS
+            | DocumentSerializer::COLUMN_TAGS
+            | DocumentSerializer::COLUMN_ENTITIES;
+    for (int n = 0; n < iterations; n++) {
+        MappedFile file(scratch);
+        Sentence sentence;
+        readMapped.start();
+        SentenceReader all(file);
+        while (all.next(sentence)) { }
+        readMapped.stop(tokens, bytes);
+
+        readMappedSrl.start();
+        SentenceReader projected(file);
+        projected.setColumns(srl);
+        while (projected.next(sentence)) { }
+        readMappedSrl.stop(tokens, bytes);
+    }
+    unlink(scratch);
+    loadStream.report(cout);
+    loadMapped.report(cout);
+    readMapped.report(cout);
+    readMappedSrl.report(cout);
+
+    // Writers
+    Benchmark save("save");
+    Benchmark saveBinary("save_binary");
+    Benchmark loadBinary("load_binary");
+    for (int n = 0; n < iterations; n++) {
+        CountingSink sink;
+        save.start();
+        DocumentSerializer::save(doc, sink);
+        save.stop(tokens, sink.count);
+
+        ostringstream binary;
+        saveBinary.start();
+        DocumentSerializer::saveBinary(doc, binary);
+        saveBinary.stop(tokens, binary.str().size());
+
+        istringstream encoded(binary.str());
+        Document decoded;
+        loadBinary.start();
+        if (!DocumentSerializer::loadBinary(encoded, decoded))
+            return 1;
+        loadBinary.stop(tokens, encoded.str().size());
+    }
+    save.report(cout);
+    saveBinary.report(cout);
+    loadBinary.report(cout);
+
+    // Line tokenizer, over every line of the corpus
+    Benchmark tokenize("tokenize");
+    for (int n = 0; n < iterations; n++) {
+        istringstream stream(text);
+        string line;
+        long fields = 0;
+        tokenize.start();
+        while (getline(stream, line))
+            fields += DocumentSerializer::tokenize(line).size();
+        tokenize.stop(tokens, bytes);
+        if (fields == 0)
+            return 1;
+    }
+    tokenize.report(cout);
+
+    // SwiRL input builders
+    benchmarkBuilder("tokenized_text", doc, &Sentence::getTokenizedText,
+            false, false, iterations);
+    benchmarkBuilder("tokenized_text_tags", doc,
+            &Sentence::getTokenizedTextWithTags, true, false, iterations);
+    benchmarkBuilder("tokenized_text_entities", doc,
+            &Sentence::getTokenizedTextWithEntities, false, true, iterations);
+    benchmarkBuilder("tokenized_text_tags_entities", doc,
+            &Sentence::getTokenizedTextWithTagsEntities, true, true,
+            iterations);
+
+    Benchmark swirlInput("swirl_input");
+    string line;
+    for (int n = 0; n < iterations; n++) {
+        long written = 0;
+        swirlInput.start();
+        for (unsigned int i = 0; i < doc.sentences.size(); i++) {
+            doc.sentences[i].getSwirlInput(line);
+            written += line.size();
+        }
+        swirlInput.stop(tokens, written);
+    }
+    swirlInput.report(cout);
+    return 0;
+}
@@ -0,0 +1,170 @@
+/*
+ * BatchJournal.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#ifndef PROCESSORS_BATCH_JOURNAL_H_
+#define PROCESSORS_BATCH_JOURNAL_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+using namespace std;
+
+namespace processors {
+
+/**
+ * Journal of the input files a batch run has completed, kept in its output
+ * directory so that an interrupted run can resume where it stopped.
+ *
+ * An input is recorded only after its output was written in full and
+ * renamed into place, along with the size, modification time and checksum
+ * of the input and the size of the output. A later run skips an input only
+ * if it is unchanged and its output is still there: the size and
+ * modification time are checked first, and the checksum only when they
+ * differ (e.g. for a copied corpus). Records are appended in groups, one
+ * line per input but a single write and flush per group, so several
+ * processes may share a journal and a torn last line from a crash is simply
+ * ignored.
+ */
+class BatchJournal {
+
+public:
+
+    /** Name of the journal file in the output directory. */
+    static const string FILENAME;
+
+    /**
+     * Constructor. Reads the journal of an output directory, if any.
+     * 	@param outdir The output directory.
+     */
+    explicit BatchJournal(const string &outdir);
+
+    /** Destructor. Flushes the records still pending. */
+    ~BatchJournal();
+
+    /**
+     * Check if an input was completed and neither it nor its output has
+     * changed since.
+     * 	@param input Path of the input file.
+     * 	@param output Path of its output file.
+     * 	@return True if the input can be skipped.
+     */
+    bool completed(const string &input, const string &output) const;
+
+    /**
+     * Check if an input was completed and neither it nor its output has
+     * changed since, for an output that is not a file of its own (e.g. an
+     * entry of a segment).
+     * 	@param input Path of the input file.
+     * 	@param output Path or name of its output.
+     * 	@param outputSize Current size of the output.
+     * 	@return True if the input can be skipped.
+     */
+    bool completed(const string &input, const string &output,
+            long long outputSize) const;
+
+    /**
+     * Record that an input was completed. The output must already be in
+     * place. The input is read again for its checksum and the journal is
+     * flushed right away; add() avoids both.
+     * 	@param input Path of the input file.
+     * 	@param output Path of its output file.
+     * 	@return False if the journal could not be written.
+     */
+    bool record(const string &input, const string &output);
+
+    /**
+     * Record that an input was completed, for an output that is not a file
+     * of its own. The output must already be durable.
+     * 	@param input Path of the input file.
+     * 	@param output Path or name of its output.
+     * 	@param outputSize Size of the output.
+     * 	@return False if the journal could not be written.
+     */
+    bool record(const string &input, const string &output,
+            long long outputSize);
+
+    /**
+     * Add a completed input to the records written by the next flush(),
+     * with the checksum of its contents as they were read, so that the
+     * input is not read again. The output must already be durable.
+     * 	@param input Path of the input file.
+     * 	@param output Path or name of its output.
+     * 	@param outputSize Size of the output, or -1 if it is a file of its
+     * 	own whose size is looked up.
+     * 	@param checksum CRC-32 of the input (see bufferChecksum).
+     * 	@return False if the input or output could not be found.
+     */
+    bool add(const string &input, const string &output, long long outputSize,
+            uint32_t checksum);
+
+    /**
+     * Append the records added since the last flush to the journal, with a
+     * single write, and flush it to disk.
+     * 	@return False if the journal could not be written; the records are
+     * 	then dropped.
+     */
+    bool flush();
+
+    /** Number of records waiting for flush(). */
+    size_t pending() const {
+        return added.size();
+    }
+
+    /** Number of inputs recorded. */
+    size_t size() const {
+        return entries.size();
+    }
+
+    /**
+     * Path of the temporary file an output is written to before it is
+     * committed.
+     * 	@param output Path of the output file.
+     */
+    static string partial(const string &output);
+
+    /**
+     * Commit an output written to its temporary file: flush it to disk and
+     * rename it into place.
+     * 	@param output Path of the output file.
+     * 	@return False if the output could not be committed.
+     */
+    static bool commit(const string &output);
+
+private:
+
+    /** What is known about a completed input. */
+    struct Entry {
+        long long size;
+        long long mtime;        /* nanoseconds */
+        string checksum;
+        string output;          /* name of the output file */
+        long long outputSize;
+    };
+
+    /** Checksum of the contents of a file; empty if it cannot be read. */
+    static string checksum(const string &path);
+
+    /** Hexadecimal form of a checksum, as written to the journal. */
+    static string hexChecksum(uint32_t checksum);
+
+    /** Name of a file without its directory. */
+    static string baseName(const string &path);
+
+    string path;
+    map<string, Entry> entries;
+    bool torn;          /* the journal ends in a partial line */
+    string lines;       /* records waiting for flush() */
+    vector<pair<string, Entry> > added;
+
+};
+
+}
+
+#endif /* PROCESSORS_BATCH_JOURNAL_H_ */
@@ -0,0 +1,275 @@
+/*
+ * BatchPipeline.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#ifndef PROCESSORS_BATCH_PIPELINE_H_
+#define PROCESSORS_BATCH_PIPELINE_H_
+
+#include <string>
+#include <vector>
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include "BlockingQueue.h"
+#include "CompressedStream.h"
+#include "Document.h"
+#include "SegmentWriter.h"
+
+using namespace std;
+
+namespace processors {
+
+/**
+ * The work a BatchPipeline does for each file of a run. Every method is
+ * called on one thread only, as noted. Whatever the labeling thread leaves
+ * for a file before its last sentence is handed over can be read by the
+ * writer thread once it formats that file, since the queues order it.
+ */
+class PipelineStages {
+
+public:
+
+    /** Destructor. */
+    virtual ~PipelineStages() { }
+
+    /**
+     * Labeling thread: a file is about to be labeled.
+     * 	@param file Index of the file in the run.
+     */
+    virtual void begin(int file) = 0;
+
+    /**
+     * Labeling thread: label one sentence.
+     * 	@param file Index of the file in the run.
+     * 	@param sentence The sentence.
+     * 	@param index Index of the sentence in its file.
+     * 	@param loadSeconds Time the reader thread spent loading it.
+     * 	@param labels Overwritten with the labels.
+     */
+    virtual void label(int file, const Sentence &sentence, long index,
+            double loadSeconds, string &labels) = 0;
+
+    /**
+     * Writer thread: format the start of the output of a file.
+     * 	@param file Index of the file in the run.
+     * 	@param sentences Number of sentences in the file.
+     * 	@param text Overwritten with the bytes to write.
+     */
+    virtual void open(int file, int sentences, string &text) = 0;
+
+    /**
+     * Writer thread: format one labeled sentence.
+     * 	@param file Index of the file in the run.
+     * 	@param sentence The sentence; it is loaded over afterwards, so it may
+     * 	be swapped away.
+     * 	@param index Index of the sentence in its file.
+     * 	@param labels The labels from label(); may be swapped away.
+     * 	@param text Overwritten with the bytes to write.
+     */
+    virtual void format(int file, Sentence &sentence, long index,
+            string &labels, string &text) = 0;
+
+    /**
+     * Writer thread: format the end of the output of a file.
+     * 	@param file Index of the file in the run.
+     * 	@param text Overwritten with the bytes to write.
+     */
+    virtual void close(int file, string &text) = 0;
+
+    /**
+     * Writer thread: the output of a file was committed, or the file
+     * failed and the run is stopping.
+     * 	@param file Index of the file in the run.
+     * 	@param ok False if the file could not be read or its output could
+     * 	not be written.
+     * 	@param size Size of the output in its segment, or -1 if it is a file
+     * 	of its own.
+     * 	@param checksum CRC-32 of the file as it was read (see
+     * 	bufferChecksum); only meaningful if ok and the whole file was read.
+     */
+    virtual void finished(int file, bool ok, long long size,
+            uint32_t checksum) = 0;
+
+    /**
+     * Writer thread: the files finished since the last call were committed
+     * together, e.g. with their segment, so whatever records them can be
+     * made durable at once.
+     */
+    virtual void committed() = 0;
+
+};
+
+/**
+ * Labels a list of files with the reading, labeling and writing of files
+ * overlapped, for runs with a single SwiRL instance.
+ *
+ * A reader thread opens the files in turn and loads their sentences onto a
+ * bounded queue, so it prefetches upcoming files while the current one is
+ * labeled. The calling thread only labels (SwiRL is not thread-safe) and
+ * passes the results on to a second bounded queue. A writer thread formats
+ * them and writes each file's output (compressing it if asked to) to a
+ * temporary file, renamed into place once complete, or appends it to a
+ * segment, then hands the sentences back to the reader, which loads over
+ * them. A file that cannot be read or written stops the run.
+ */
+class BatchPipeline {
+
+public:
+
+    /**
+     * Constructor.
+     * 	@param stages The work done for each file.
+     * 	@param compress Compression of the output files.
+     * 	@param capacity Sentences each queue may hold at once.
+     */
+    BatchPipeline(PipelineStages &stages, Compression compress,
+            size_t capacity = 256);
+
+    /** Destructor. Frees the spare sentences. */
+    ~BatchPipeline();
+
+    /**
+     * Label only a range of the sentences of each file, read through its
+     * sentence index.
+     * 	@param first First sentence of the range.
+     * 	@param last One past the last sentence, or -1 for the end.
+     */
+    void setRange(int first, int last) {
+        firstSentence = first;
+        lastSentence = last;
+    }
+
+    /**
+     * Choose the parts of each sentence to load; by default all of them.
+     * 	@param columns Mask of DocumentSerializer::Column values.
+     */
+    void setColumns(unsigned int columns) {
+        this->columns = columns;
+    }
+
+    /**
+     * Pack the outputs into segments instead of writing a file for each.
+     * Files are then finished in groups, as the segment is committed.
+     * 	@param writer The writer of the segments; its compression is used.
+     */
+    void setSegments(SegmentWriter *writer) {
+        segments = writer;
+    }
+
+    /**
+     * Add a file to the run.
+     * 	@param infile Path of the annotation.
+     * 	@param outfile Path of the output.
+     */
+    void add(const string &infile, const string &outfile);
+
+    /**
+     * Label every file, on the calling thread, until they are all written
+     * or one fails.
+     * 	@return False if a file failed or the threads could not start.
+     */
+    bool run();
+
+private:
+
+    // Not copyable
+    BatchPipeline(const BatchPipeline &);
+    BatchPipeline &operator=(const BatchPipeline &);
+
+    /** What an item of the queues stands for. */
+    enum Kind {
+        BEGIN,      /* start of a file; count holds its sentences */
+        SENTENCE,   /* a sentence of the file */
+        END         /* end of a file; ok is false if it could not be read */
+    };
+
+    /** One queued item. */
+    struct Item {
+        Kind kind;
+        int file;
+        long index;         /* index of the sentence in its file */
+        int count;
+        bool ok;
+        Sentence *sentence;
+        double seconds;     /* time spent loading the sentence */
+        string *labels;
+        uint32_t checksum;  /* of the whole file, at its end */
+    };
+
+    /** A file whose output waits for the segment to be committed. */
+    struct Pending {
+        int file;
+        long long size;     /* of the output in the segment */
+        uint32_t checksum;
+    };
+
+    /** Entry points of the threads. */
+    static void *readThread(void *argument);
+    static void *writeThread(void *argument);
+
+    /** Load every file onto the queue of loaded sentences. */
+    void read();
+
+    /**
+     * Load one file onto the queue of loaded sentences.
+     * 	@return False if the run was stopped.
+     */
+    bool readFile(int file);
+
+    /** Label the loaded sentences until the reader is done. */
+    void label();
+
+    /** Write the labeled sentences until the labeling thread is done. */
+    void write();
+
+    /**
+     * Commit the segment and finish the files waiting for it.
+     * 	@return False if the segment could not be committed.
+     */
+    bool commitSegments();
+
+    /** Queue an item of a file. */
+    bool push(Kind kind, int file, int count = 0, bool ok = true,
+            uint32_t checksum = 0);
+
+    /** Free an item. */
+    static void discard(Item &item);
+
+    /**
+     * A sentence to load into: a spare one handed back by the writer, whose
+     * storage is reused, or a new one if there is none.
+     */
+    Sentence *take();
+
+    /**
+     * Hand a formatted sentence back to the reader, or free it if enough
+     * are spare already.
+     */
+    void recycle(Item &item);
+
+    /** Stop the run after a failure; the queues are drained. */
+    void fail();
+
+    PipelineStages &stages;
+    Compression compress;
+    int firstSentence;
+    int lastSentence;
+    unsigned int columns;
+    vector<string> infiles;
+    vector<string> outfiles;
+    BlockingQueue<Item> loaded;
+    BlockingQueue<Item> labeled;
+    BlockingQueue<Sentence *> spare;    /* written sentences to reuse */
+    volatile bool failed;
+    SegmentWriter *segments;
+    vector<Pending> waiting;    /* files to finish at the next commit */
+
+};
+
+}
+
+#endif /* PROCESSORS_BATCH_PIPELINE_H_ */
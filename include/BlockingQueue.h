@@ -0,0 +1,154 @@
+/*
+ * BlockingQueue.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#ifndef PROCESSORS_BLOCKING_QUEUE_H_
+#define PROCESSORS_BLOCKING_QUEUE_H_
+
+#include <deque>
+#include <pthread.h>
+
+using namespace std;
+
+namespace processors {
+
+/**
+ * A bounded first-in first-out queue for handing items between threads.
+ * Producers block while it is full and consumers while it is empty. Once
+ * closed, producers are turned away and consumers drain what is left.
+ */
+template<typename T>
+class BlockingQueue {
+
+public:
+
+    /**
+     * Constructor.
+     * 	@param capacity Maximum number of items held at once.
+     */
+    explicit BlockingQueue(size_t capacity) :
+            limit(capacity > 0 ? capacity : 1), closed(false) {
+        pthread_mutex_init(&mutex, NULL);
+        pthread_cond_init(&notEmpty, NULL);
+        pthread_cond_init(&notFull, NULL);
+    }
+
+    /** Destructor. */
+    ~BlockingQueue() {
+        pthread_cond_destroy(&notFull);
+        pthread_cond_destroy(&notEmpty);
+        pthread_mutex_destroy(&mutex);
+    }
+
+    /**
+     * Add an item, waiting for room if the queue is full.
+     * 	@param item The item.
+     * 	@return False if the queue was closed; the item was not added.
+     */
+    bool push(const T &item) {
+        pthread_mutex_lock(&mutex);
+        while (!closed && items.size() >= limit)
+            pthread_cond_wait(&notFull, &mutex);
+        bool added = !closed;
+        if (added) {
+            items.push_back(item);
+            pthread_cond_signal(&notEmpty);
+        }
+        pthread_mutex_unlock(&mutex);
+        return added;
+    }
+
+    /**
+     * Add an item if there is room, without waiting.
+     * 	@param item The item.
+     * 	@return False if the queue was full or closed; the item was not
+     * 	added.
+     */
+    bool tryPush(const T &item) {
+        pthread_mutex_lock(&mutex);
+        bool added = !closed && items.size() < limit;
+        if (added) {
+            items.push_back(item);
+            pthread_cond_signal(&notEmpty);
+        }
+        pthread_mutex_unlock(&mutex);
+        return added;
+    }
+
+    /**
+     * Remove the oldest item if there is one, without waiting.
+     * 	@param item Set to the item.
+     * 	@return False if the queue was empty.
+     */
+    bool tryPop(T &item) {
+        pthread_mutex_lock(&mutex);
+        bool removed = !items.empty();
+        if (removed) {
+            item = items.front();
+            items.pop_front();
+            pthread_cond_signal(&notFull);
+        }
+        pthread_mutex_unlock(&mutex);
+        return removed;
+    }
+
+    /**
+     * Remove the oldest item, waiting for one if the queue is empty.
+     * 	@param item Set to the item.
+     * 	@return False if the queue is closed and empty.
+     */
+    bool pop(T &item) {
+        pthread_mutex_lock(&mutex);
+        while (!closed && items.empty())
+            pthread_cond_wait(&notEmpty, &mutex);
+        bool removed = !items.empty();
+        if (removed) {
+            item = items.front();
+            items.pop_front();
+            pthread_cond_signal(&notFull);
+        }
+        pthread_mutex_unlock(&mutex);
+        return removed;
+    }
+
+    /**
+     * Stop accepting items and wake every waiting thread. Items already in
+     * the queue can still be popped.
+     */
+    void close() {
+        pthread_mutex_lock(&mutex);
+        closed = true;
+        pthread_cond_broadcast(&notEmpty);
+        pthread_cond_broadcast(&notFull);
+        pthread_mutex_unlock(&mutex);
+    }
+
+    /** Number of items waiting in the queue. */
+    size_t size() {
+        pthread_mutex_lock(&mutex);
+        size_t n = items.size();
+        pthread_mutex_unlock(&mutex);
+        return n;
+    }
+
+private:
+
+    // Not copyable
+    BlockingQueue(const BlockingQueue &);
+    BlockingQueue &operator=(const BlockingQueue &);
+
+    deque<T> items;
+    size_t limit;
+    bool closed;
+    pthread_mutex_t mutex;
+    pthread_cond_t notEmpty;
+    pthread_cond_t notFull;
+
+};
+
+}
+
+#endif /* PROCESSORS_BLOCKING_QUEUE_H_ */
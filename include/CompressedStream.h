@@ -0,0 +1,348 @@
+/*
+ * CompressedStream.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#ifndef PROCESSORS_COMPRESSED_STREAM_H_
+#define PROCESSORS_COMPRESSED_STREAM_H_
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "BlockingQueue.h"
+
+using namespace std;
+
+namespace processors {
+
+/** Compression formats for annotation and SRL files. */
+enum Compression {
+    COMPRESSION_NONE,
+    COMPRESSION_GZIP,   /* .gz, via zlib */
+    COMPRESSION_ZSTD    /* .zst, only when built with HAVE_ZSTD */
+};
+
+/**
+ * Guess the compression of a file from its extension.
+ * 	@param filename Path to the file.
+ * 	@return COMPRESSION_GZIP for ".gz", COMPRESSION_ZSTD for ".zst", and
+ * 	COMPRESSION_NONE otherwise.
+ */
+Compression compressionOf(const string &filename);
+
+/**
+ * File extension of a compression format.
+ * 	@param codec The format.
+ * 	@return ".gz", ".zst", or "" for COMPRESSION_NONE.
+ */
+const char *compressionSuffix(Compression codec);
+
+/** True if this build can read and write the given format. */
+bool compressionSupported(Compression codec);
+
+/**
+ * Estimate the size of a file once decompressed, without decompressing it.
+ * Gzip files record their size (modulo 4GB) in the trailer and zstd frames
+ * usually do in their header; otherwise a typical ratio is assumed.
+ * 	@param filename Path to the file; the format follows its extension.
+ * 	@return The estimate in bytes, or -1 if the file cannot be read.
+ */
+long long uncompressedSize(const string &filename);
+
+/**
+ * Stream buffer that reads a file and decompresses it on a background
+ * thread, so that decoding overlaps with whatever consumes the text.
+ * Decoded blocks are handed over through a small bounded queue.
+ *
+ * Seeking is limited to the block currently being read, which is enough to
+ * peek at the start of the file (as DocumentSerializer::isBinary does).
+ */
+class DecompressingBuffer : public streambuf {
+
+public:
+
+    /** Constructor. */
+    DecompressingBuffer();
+
+    /** Destructor. Stops the decoder thread and closes the file. */
+    ~DecompressingBuffer();
+
+    /**
+     * Open a file and start decoding it.
+     * 	@param filename Path to the file.
+     * 	@param codec Compression of the file.
+     * 	@return False if the file cannot be opened or the format is not
+     * 	supported by this build.
+     */
+    bool open(const string &filename, Compression codec);
+
+    /** True if a file is open. */
+    bool is_open() const {
+        return fd >= 0;
+    }
+
+    /**
+     * Stop the decoder thread and close the file. The part of the file the
+     * decoder had not read yet is read into the checksum first.
+     */
+    void close();
+
+    /**
+     * True if the file could not be read or was not valid compressed data.
+     * Only meaningful once all of the data has been consumed.
+     */
+    bool failed() const {
+        return error;
+    }
+
+    /**
+     * CRC-32 of the bytes read from the file, before decoding. Covers the
+     * whole file once close() has been called, however much of the data was
+     * consumed.
+     */
+    uint32_t checksum() const {
+        return rawChecksum;
+    }
+
+protected:
+
+    int_type underflow();
+    pos_type seekoff(off_type off, ios_base::seekdir dir,
+            ios_base::openmode which);
+    pos_type seekpos(pos_type pos, ios_base::openmode which);
+
+private:
+
+    // Not copyable
+    DecompressingBuffer(const DecompressingBuffer &);
+    DecompressingBuffer &operator=(const DecompressingBuffer &);
+
+    /** Entry point of the decoder thread. */
+    static void *run(void *self);
+
+    /**
+     * Read the next bytes of the file, adding them to its checksum.
+     * 	@return Number of bytes read, 0 at end of file, or -1 on error.
+     */
+    ssize_t readRaw(char *data, size_t length);
+
+    /** Copy the raw file into blocks. */
+    bool readPlain();
+
+    /** Decode gzip (or zlib) data, including concatenated members. */
+    bool readGzip();
+
+    /** Decode zstd frames. */
+    bool readZstd();
+
+    /**
+     * Queue a decoded block and start a new one.
+     * 	@return False if the reader has gone away.
+     */
+    bool emit(string *&block, size_t length);
+
+    int fd;
+    Compression codec;
+    pthread_t thread;
+    BlockingQueue<string *> *blocks;
+    string *current;
+    long long currentStart;
+    bool error;
+    uint32_t rawChecksum;   /* of the bytes read so far */
+
+};
+
+/**
+ * Stream buffer that compresses everything written to it into a file.
+ * Compression happens on the writing thread, one large block at a time.
+ * Flushing hands the pending bytes to the compressor, but the file is only
+ * complete once close() has written the end of the compressed stream.
+ */
+class CompressingBuffer : public streambuf {
+
+public:
+
+    /** Constructor. */
+    CompressingBuffer();
+
+    /** Destructor. Closes the file. */
+    ~CompressingBuffer();
+
+    /**
+     * Create (or truncate) a file for writing.
+     * 	@param filename Path to the file.
+     * 	@param codec Compression to apply.
+     * 	@param level Compression level; -1 for the format's default.
+     * 	@return False if the file cannot be created or the format is not
+     * 	supported by this build.
+     */
+    bool open(const string &filename, Compression codec, int level = -1);
+
+    /**
+     * Write to a file that is already open, from its current position. The
+     * descriptor is left open by close(), so several compressed streams
+     * can be written one after another into the same file.
+     * 	@param fd An open file descriptor.
+     * 	@param codec Compression to apply.
+     * 	@param level Compression level; -1 for the format's default.
+     * 	@return False if the format is not supported by this build.
+     */
+    bool open(int fd, Compression codec, int level = -1);
+
+    /** True if a file is open. */
+    bool is_open() const {
+        return fd >= 0;
+    }
+
+    /**
+     * Finish the compressed stream and close the file.
+     * 	@return False if anything could not be written.
+     */
+    bool close();
+
+protected:
+
+    int_type overflow(int_type c);
+    int sync();
+
+private:
+
+    // Not copyable
+    CompressingBuffer(const CompressingBuffer &);
+    CompressingBuffer &operator=(const CompressingBuffer &);
+
+    /**
+     * Compress and write out the buffered text.
+     * 	@param finish Also end the compressed stream.
+     */
+    bool compress(bool finish);
+
+    /** Set up the compressor for a descriptor. */
+    bool start(int fd, Compression codec, int level);
+
+    int fd;
+    bool owned;         /* close() closes the descriptor */
+    Compression codec;
+    void *state;
+    vector<char> input;
+    vector<char> output;
+    bool error;
+
+};
+
+/**
+ * An input stream over a possibly compressed file, decoded ahead of the
+ * reader on a background thread.
+ */
+class CompressedInputStream : public istream {
+
+public:
+
+    /** Constructor. */
+    CompressedInputStream();
+
+    /**
+     * Constructor. Opens the file; check is_open() for success.
+     * 	@param filename Path to the file.
+     * 	@param codec Compression of the file; guessed from the extension by
+     * 	default.
+     */
+    explicit CompressedInputStream(const string &filename,
+            Compression codec);
+
+    /** Constructor. Opens the file, guessing its compression. */
+    explicit CompressedInputStream(const string &filename);
+
+    /**
+     * Open a file.
+     * 	@param filename Path to the file.
+     * 	@param codec Compression of the file.
+     */
+    void open(const string &filename, Compression codec);
+
+    /** True if the file is open. */
+    bool is_open() const {
+        return buffer.is_open();
+    }
+
+    /**
+     * Close the file. Sets the failbit if the data turned out to be
+     * corrupt or truncated.
+     */
+    void close();
+
+    /**
+     * CRC-32 of the file as stored, compressed or not, so that it need not
+     * be read again to be checksummed. Only covers the whole file once
+     * close() has been called: readers usually stop before the end.
+     */
+    uint32_t checksum() const {
+        return buffer.checksum();
+    }
+
+private:
+
+    DecompressingBuffer buffer;
+
+};
+
+/**
+ * An output stream into a possibly compressed file.
+ */
+class CompressedOutputStream : public ostream {
+
+public:
+
+    /** Constructor. */
+    CompressedOutputStream();
+
+    /**
+     * Constructor. Creates the file; check is_open() for success.
+     * 	@param filename Path to the file.
+     * 	@param codec Compression to apply.
+     */
+    CompressedOutputStream(const string &filename, Compression codec);
+
+    /**
+     * Create (or truncate) a file.
+     * 	@param filename Path to the file.
+     * 	@param codec Compression to apply.
+     * 	@param level Compression level; -1 for the format's default.
+     */
+    void open(const string &filename, Compression codec, int level = -1);
+
+    /**
+     * Write to a file that is already open, from its current position; the
+     * descriptor is left open by close().
+     * 	@param fd An open file descriptor.
+     * 	@param codec Compression to apply.
+     * 	@param level Compression level; -1 for the format's default.
+     */
+    void open(int fd, Compression codec, int level = -1);
+
+    /** True if the file is open. */
+    bool is_open() const {
+        return buffer.is_open();
+    }
+
+    /**
+     * Finish and close the file. Sets the failbit if anything could not be
+     * written.
+     */
+    void close();
+
+private:
+
+    CompressingBuffer buffer;
+
+};
+
+}
+
+#endif /* PROCESSORS_COMPRESSED_STREAM_H_ */
@@ -8,23 +8,127 @@
 #ifndef PROCESSORS_DOCUMENT_H_
 #define PROCESSORS_DOCUMENT_H_
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
 #include <assert.h>
 
+#include "StringColumn.h"
+#include "SymbolTable.h"
+
 using namespace std;
 
 namespace processors {
 
+/**
+ * Constituent tree of a sentence, including head words.
+ * Nodes are kept in a flat vector in pre-order (each node is followed by
+ * the subtrees of its children), which is also how the tree is serialized.
+ * This class mirrors the Scala implementation from sistanlp's processors.
+ */
+class SyntacticTree {
+
+public:
+
+    /** A node of the tree. Leaves hold words, other nodes hold labels. */
+    struct Node {
+        string value;       /* Constituent label or word */
+        int head;           /* Offset of the head child */
+        int startOffset;    /* First token covered; start at 0 */
+        int endOffset;      /* One past the last token covered */
+        int children;       /* Number of children; 0 for leaves */
+    };
+
+    // Public variables.
+    vector<Node> nodes;
+
+    /** True if there is no tree. */
+    bool empty() const {
+        return nodes.empty();
+    }
+
+    /** Remove all nodes. */
+    void clear() {
+        nodes.clear();
+    }
+
+    /**
+     * Bracketed (Penn Treebank) form of the tree.
+     * 	@param rootLabel If not empty, replaces the label of the root.
+     */
+    string toString(const string & rootLabel = "") const {
+        string text;
+        if (!nodes.empty()) {
+            unsigned int next = 0;
+            append(text, next, rootLabel);
+        }
+        return text;
+    }
+
+private:
+
+    /** Append the subtree rooted at nodes[next], advancing next past it. */
+    void append(string & text, unsigned int & next,
+            const string & label) const {
+        assert(next < nodes.size());
+        const Node & node = nodes[next++];
+        if (node.children == 0) {
+            text += node.value;
+            return;
+        }
+        text += '(';
+        text += label.empty() ? node.value : label;
+        for (int i = 0; i < node.children; i++) {
+            text += ' ';
+            append(text, next, "");
+        }
+        text += ')';
+    }
+
+};
+
+/**
+ * A labeled argument of a predicate: a semantic role over a span of tokens.
+ */
+struct SrlArgument {
+    Symbol label;       /* Role label, interned in SymbolTable::roles() */
+    int startOffset;    /* First token of the span; start at 0 */
+    int endOffset;      /* One past the last token of the span */
+
+    /** Role label, e.g. A0 or AM-TMP. */
+    const string & role() const {
+        return SymbolTable::roles().name(label);
+    }
+};
+
+/**
+ * A predicate of a sentence and its labeled arguments, as found by SwiRL.
+ */
+struct SrlPredicate {
+    int token;          /* Offset of the predicate (verb) token */
+    string lemma;       /* Lemma SwiRL labeled the predicate with */
+    vector<SrlArgument> arguments;  /* In order of their start offsets */
+};
+
 /**
  * Stores the annotations for a single sentence.
  * This class mirrors the Scala implementation from sistanlp's processors.
+ * POS tags, named entity labels and chunk labels come from small closed
+ * vocabularies, so they are stored as Symbols interned in the global
+ * SymbolTables rather than as strings. Words, lemmas and normalized values
+ * are each kept in a StringColumn, one arena per column.
+ *
+ * Sentences are not copyable, so that columns are never copied by accident;
+ * use swap() to hand one over, or slice() to copy its tokens.
  */
 class Sentence {
 
 public:
 
+    /** Constructor for an empty sentence. */
+    Sentence() { }
+
     /**
      * Constructor.
      * 	@param tokens Actual tokens in this sentence
@@ -42,102 +146,347 @@ public:
             const vector<string> & normVals,
             const vector<string> & chunkLabels) :
             words(tokens), startOffsets(startOff), endOffsets(endOff),
-            tags(pos), lemmas(lem), entities(en), norms(normVals),
-            chunks(chunkLabels) {
+            lemmas(lem), norms(normVals) {
+        intern(pos, SymbolTable::tags(), tags);
+        intern(en, SymbolTable::entities(), entities);
+        intern(chunkLabels, SymbolTable::chunks(), chunks);
     }
 
     // Public variables.
-    vector<string> words;
+    StringColumn words;
     vector<int> startOffsets;
     vector<int> endOffsets;
-    vector<string> tags;
-    vector<string> lemmas;
-    vector<string> entities;
-    vector<string> norms;
-    vector<string> chunks;
+    vector<Symbol> tags;
+    StringColumn lemmas;
+    vector<Symbol> entities;
+    StringColumn norms;
+    vector<Symbol> chunks;
+    SyntacticTree syntacticTree;  /* Constituent tree of this sent; may be empty */
+    vector<SrlPredicate> predicates;  /* Semantic roles; may be empty */
+    string dependencies;  /* D blocks as read, unparsed; may be empty */
 
     // TODO: Future impelementation
-    // Tree syntacticTree;  /* Constituent tree of this sent; incl head words */
     // DAG dependencies;    /* DAG of syntactic dependencies; offsets at 0 */
 
     /** Size of the sentence */
-    int size() {
+    int size() const {
         return words.size();
     }
 
-    /** Concatenated string tokens. */
-    string getTokenizedText() {
-        string text = "";
+    /** Exchange the contents of two sentences, without copying. */
+    void swap(Sentence & other) {
+        words.swap(other.words);
+        startOffsets.swap(other.startOffsets);
+        endOffsets.swap(other.endOffsets);
+        tags.swap(other.tags);
+        lemmas.swap(other.lemmas);
+        entities.swap(other.entities);
+        norms.swap(other.norms);
+        chunks.swap(other.chunks);
+        syntacticTree.nodes.swap(other.syntacticTree.nodes);
+        predicates.swap(other.predicates);
+        dependencies.swap(other.dependencies);
+    }
+
+    /** POS tag of a token. */
+    const string & tag(int i) const {
+        return SymbolTable::tags().name(tags.at(i));
+    }
+
+    /** Named entity label of a token. */
+    const string & entity(int i) const {
+        return SymbolTable::entities().name(entities.at(i));
+    }
+
+    /** Shallow parsing label of a token. */
+    const string & chunk(int i) const {
+        return SymbolTable::chunks().name(chunks.at(i));
+    }
+
+    /**
+     * Append the space-joined tokens, and optionally their labels, to a
+     * buffer in a single pass.
+     * 	@param text The buffer; existing contents are kept.
+     * 	@param withTags Follow each word by its POS tag
+     * 	@param withEntities Follow each word (and tag) by its entity label
+     * 	@param escape Escape quotes and backslashes, as SwiRL expects
+     */
+    void appendTokenizedText(string & text, bool withTags, bool withEntities,
+            bool escape) const {
+        assert(!withTags || words.size() == tags.size());
+        assert(!withEntities || words.size() == entities.size());
         for (unsigned int i = 0; i < words.size(); i++) {
-            text = text + words.at(i);
-            if (i < words.size() - 1) {
-                text = text + string(" ");
+            if (i > 0)
+                text += ' ';
+            append(text, words[i], escape);
+            if (withTags) {
+                text += ' ';
+                append(text, tag(i), escape);
+            }
+            if (withEntities) {
+                text += ' ';
+                append(text, entity(i), escape);
             }
         }
+    }
+
+    /**
+     * Form the SwiRL input line for this sentence. The swirl code is picked
+     * from the available columns (1: tags and entities, 2: entities only,
+     * 3: words only) and followed by a space and the escaped tokens.
+     * 	@param line Overwritten with the input line; its capacity is reused,
+     * 	so no memory is allocated once it is large enough.
+     * 	@return The swirl code.
+     */
+    char getSwirlInput(string & line) const {
+        bool withEntities = (entities.size() == words.size());
+        bool withTags = withEntities && (tags.size() == words.size());
+        char code = withTags ? '1' : (withEntities ? '2' : '3');
+        line.clear();
+        line += code;
+        line += ' ';
+        appendTokenizedText(line, withTags, withEntities, true);
+        return code;
+    }
+
+    /** Concatenated string tokens. */
+    string getTokenizedText() const {
+        string text;
+        appendTokenizedText(text, false, false, false);
         return text;
     }
 
     /** Concatenated string tokens with POS tags. */
-    string getTokenizedTextWithTags() {
-        assert(words.size() == tags.size());
-        string text = "";
-        for (unsigned int i = 0; i < words.size(); i++) {
-            text = text + words.at(i) + string(" ") + tags.at(i);
-            if (i < words.size() - 1) {
-                text = text + string(" ");
-            }
-        }
+    string getTokenizedTextWithTags() const {
+        string text;
+        appendTokenizedText(text, true, false, false);
         return text;
     }
 
     /** Concatenated string tokens with named entities. */
-    string getTokenizedTextWithEntities() {
-        assert(words.size() == entities.size());
-        string text = "";
-        for (unsigned int i = 0; i < words.size(); i++) {
-            text = text + words.at(i) + string(" ") + entities.at(i);
-            if (i < words.size() - 1) {
-                text = text + string(" ");
-            }
-        }
+    string getTokenizedTextWithEntities() const {
+        string text;
+        appendTokenizedText(text, false, true, false);
         return text;
     }
 
     /** Concatenated string tokens with POS tags & entities. */
-    string getTokenizedTextWithTagsEntities() {
-        assert(words.size() == tags.size() && words.size() == entities.size());
-        string text = "";
-        for (unsigned int i = 0; i < words.size(); i++) {
-            text = text + words.at(i) + string(" ") + tags.at(i)
-                    + string(" ") + entities.at(i);
-            if (i < words.size() - 1) {
-                text = text + string(" ");
+    string getTokenizedTextWithTagsEntities() const {
+        string text;
+        appendTokenizedText(text, true, true, false);
+        return text;
+    }
+
+    /**
+     * Copy a range of tokens, with every column that has a value per token,
+     * into another sentence. The constituent tree, the semantic roles and
+     * the dependencies are not carried over.
+     * 	@param begin First token of the range.
+     * 	@param end One past the last token of the range.
+     * 	@param part Overwritten with the tokens; its storage is reused.
+     */
+    void slice(int begin, int end, Sentence & part) const {
+        size_t n = words.size();
+        sliceColumn(words, n, begin, end, part.words);
+        sliceColumn(startOffsets, n, begin, end, part.startOffsets);
+        sliceColumn(endOffsets, n, begin, end, part.endOffsets);
+        sliceColumn(tags, n, begin, end, part.tags);
+        sliceColumn(lemmas, n, begin, end, part.lemmas);
+        sliceColumn(entities, n, begin, end, part.entities);
+        sliceColumn(norms, n, begin, end, part.norms);
+        sliceColumn(chunks, n, begin, end, part.chunks);
+        part.syntacticTree.clear();
+        part.predicates.clear();
+        part.dependencies.clear();
+    }
+
+private:
+
+    // Not copyable
+    Sentence(const Sentence &);
+    Sentence & operator=(const Sentence &);
+
+    /** Copy a range of a column, or nothing if the column is missing. */
+    static void sliceColumn(const StringColumn & column, size_t n, int begin,
+            int end, StringColumn & part) {
+        part.clear();
+        if (column.size() == n)
+            part.append(column, begin, end);
+    }
+
+    /** Copy a range of a column, or nothing if the column is missing. */
+    template<typename T>
+    static void sliceColumn(const vector<T> & column, size_t n, int begin,
+            int end, vector<T> & part) {
+        if (column.size() == n)
+            part.assign(column.begin() + begin, column.begin() + end);
+        else
+            part.clear();
+    }
+
+    /** Append a string, escaping quotes and backslashes if asked to. */
+    static void append(string & text, const StringRef & s, bool escape) {
+        if (!escape) {
+            text.append(s.data, s.length);
+            return;
+        }
+        size_t start = 0;
+        for (size_t i = 0; i < s.length; i++) {
+            if (s.data[i] == '"' || s.data[i] == '\\') {
+                text.append(s.data + start, i - start);
+                text += '\\';
+                start = i;
             }
         }
-        return text;
+        text.append(s.data + start, s.length - start);
+    }
+
+    /** Append a string, escaping quotes and backslashes if asked to. */
+    static void append(string & text, const string & s, bool escape) {
+        append(text, StringRef(s.data(), s.size()), escape);
+    }
+
+    /** Intern a column of labels into a table. */
+    static void intern(const vector<string> & labels, SymbolTable & table,
+            vector<Symbol> & ids) {
+        ids.resize(labels.size());
+        for (unsigned int i = 0; i < labels.size(); i++) {
+            ids[i] = table.intern(labels[i]);
+        }
     }
 
 };
 
+/**
+ * The sentences of a document, in order. Sentences are not copyable, so
+ * each one is allocated on its own and the list only moves pointers to
+ * them as it grows.
+ */
+class SentenceList {
+
+public:
+
+    /** Constructor for an empty list. */
+    SentenceList() { }
+
+    /** Destructor. */
+    ~SentenceList() {
+        clear();
+    }
+
+    /** Number of sentences. */
+    size_t size() const {
+        return items.size();
+    }
+
+    /** True if there are no sentences. */
+    bool empty() const {
+        return items.empty();
+    }
+
+    /** A sentence of the list. */
+    Sentence & operator[](size_t i) {
+        return *items[i];
+    }
+
+    /** A sentence of the list. */
+    const Sentence & operator[](size_t i) const {
+        return *items[i];
+    }
+
+    /** A sentence of the list; checks the index. */
+    Sentence & at(size_t i) {
+        return *items.at(i);
+    }
+
+    /** A sentence of the list; checks the index. */
+    const Sentence & at(size_t i) const {
+        return *items.at(i);
+    }
+
+    /** The last sentence. */
+    Sentence & back() {
+        return *items.back();
+    }
+
+    /** The last sentence. */
+    const Sentence & back() const {
+        return *items.back();
+    }
+
+    /**
+     * Append an empty sentence, e.g. to swap() one into.
+     * 	@return The new sentence.
+     */
+    Sentence & append() {
+        items.push_back(new Sentence());
+        return *items.back();
+    }
+
+    /**
+     * Add empty sentences at the end, or remove sentences from it.
+     * 	@param count Number of sentences to keep.
+     */
+    void resize(size_t count) {
+        for (size_t i = count; i < items.size(); i++)
+            delete items[i];
+        size_t kept = min(count, items.size());
+        items.resize(count);
+        for (size_t i = kept; i < count; i++)
+            items[i] = new Sentence();
+    }
+
+    /** Remove all sentences. */
+    void clear() {
+        resize(0);
+    }
+
+    /** Exchange the sentences of two lists, without copying any. */
+    void swap(SentenceList & other) {
+        items.swap(other.items);
+    }
+
+private:
+
+    // Not copyable
+    SentenceList(const SentenceList &);
+    SentenceList & operator=(const SentenceList &);
+
+    vector<Sentence *> items;
+
+};
+
 /**
  * Stores all annotations for one document
  * This class mirrors the Scala implementation from sistanlp's processors.
+ *
+ * Documents are not copyable; loaders fill one in place, and swap() hands
+ * one over.
  */
 class Document {
 
 public:
 
-    /**
-     * Constructor.
-     * 	@param sentences Sentences from the document.
-     */
-    Document(const vector<Sentence> & s) : sentences(s) { }
+    /** Constructor for an empty document. */
+    Document() { }
+
+    /** Exchange the sentences of two documents, without copying. */
+    void swap(Document & other) {
+        sentences.swap(other.sentences);
+    }
 
     // Public variables
-    vector<Sentence> sentences;
+    SentenceList sentences;
 
     // TODO: Future implementation
     // CorefChains coreferenceChains;	/* Chains of coref mentions */
+
+private:
+
+    // Not copyable
+    Document(const Document &);
+    Document & operator=(const Document &);
+
 };
 
 }
@@ -13,16 +13,33 @@
 #include <vector>
 
 #include "Document.h"
+#include "LineReader.h"
+#include "MappedFile.h"
+#include "OutputSink.h"
+#include "TextScanner.h"
 
 using namespace std;
 
 namespace processors {
 
+class SentenceReader;
+
 /**
  * Saves/loads a Document to/from a stream
  * An important focus here is to minimize the size of the serialized Document.
  * For this reason, we use a custom (compact) text format, rather than XML.
  *
+ * A versioned binary format is also available (saveBinary/loadBinary). It
+ * stores every distinct word and label once in a per-file dictionary,
+ * delta-encodes character offsets as varints, and marks all-NIL columns in a
+ * per-sentence bitmap instead of writing them out.
+ *
+ * Besides the token columns and the constituent tree, a sentence may carry
+ * the predicates and labeled argument spans found by SwiRL. In the text
+ * format they follow the tokens as an "R" line with the number of
+ * predicates, then one line per predicate: its token, its lemma, and a
+ * label, start and end offset for each argument. Older readers skip them.
+ *
  * This class mirrors the Scala implementation from sistanlp's processors.
  */
 class DocumentSerializer {
@@ -32,15 +49,121 @@ public:
     /**
      * Load the NLP annotation from an input stream (file or string).
      * 	@param stream The input stream.
+     * 	@param doc Overwritten with the document.
+     */
+    static void load(istream &stream, Document &doc);
+
+    /**
+     * Load the NLP annotation from a memory-mapped file. Fields are parsed
+     * in place from the mapping rather than copied line by line.
+     * 	@param file The mapped file.
+     * 	@param doc Overwritten with the document.
+     */
+    static void load(const MappedFile &file, Document &doc);
+
+    /**
+     * Load the NLP annotation from a memory-mapped file on several threads.
+     * The file is cut into chunks at sentence boundaries (EOS lines), the
+     * chunks are parsed in parallel, and their sentences are stored in
+     * order; the document is the same as the one load(file, doc) loads.
+     * 	@param file The mapped file.
+     * 	@param threads Number of threads; 0 for one per online CPU.
+     * 	@param doc Overwritten with the document.
      */
-    static Document load(istream &stream);
+    static void load(const MappedFile &file, int threads, Document &doc);
+
+    /**
+     * Collect all remaining sentences from a reader into a Document. The
+     * document grows as sentences are read, rather than being sized from
+     * the count in the header.
+     * 	@param reader The sentence reader.
+     * 	@param doc Overwritten with the sentences.
+     */
+    static void load(SentenceReader &reader, Document &doc);
 
     /**
      * Save the NLP annotation to an output stream (file or string).
      * 	@param doc The annotated document.
      * 	@param out The output stream.
      */
-    static void save(Document doc, ostream &out);
+    static void save(const Document &doc, ostream &out);
+
+    /**
+     * Save the NLP annotation to an output sink, bypassing iostreams.
+     * 	@param doc The annotated document.
+     * 	@param out The output sink.
+     * 	@return False if the sink reported an error.
+     */
+    static bool save(const Document &doc, OutputSink &out);
+
+    /**
+     * Load the NLP annotation from a stream in the binary format.
+     * 	@param stream The input stream.
+     * 	@param doc Overwritten with the document.
+     * 	@return False if the stream does not hold a valid binary document.
+     */
+    static bool loadBinary(istream &stream, Document &doc);
+
+    /**
+     * Load the NLP annotation from a memory-mapped file in the binary format.
+     * 	@param file The mapped file.
+     * 	@param doc Overwritten with the document.
+     * 	@return False if the file does not hold a valid binary document.
+     */
+    static bool loadBinary(const MappedFile &file, Document &doc);
+
+    /**
+     * Check that a text annotation has the structure the text loaders rely
+     * on, without asserting: the S header, every declared sentence with its
+     * T line and as many token lines of all fields, R lines and trees that
+     * fit the tokens, D blocks that end, and an EOS for each sentence. Use
+     * it before loading annotations that come from an untrusted source.
+     * 	@param begin Start of the annotation.
+     * 	@param end One past the end of the annotation.
+     * 	@return False if the annotation is malformed.
+     */
+    static bool checkText(const char *begin, const char *end);
+
+    /**
+     * Save the NLP annotation to an output stream in the binary format.
+     * 	@param doc The annotated document.
+     * 	@param out The output stream.
+     */
+    static void saveBinary(const Document &doc, ostream &out);
+
+    /**
+     * Check whether a stream holds the binary format, without consuming it.
+     * 	@param stream The input stream.
+     * 	@return True if the stream starts with the binary magic.
+     */
+    static bool isBinary(istream &stream);
+
+    /**
+     * Tokenize a line on the field separator.
+     * 	@param line The string to tokenize.
+     * 	@return A vector of tokens.
+     */
+    static vector<string> tokenize(const string &line);
+
+    /**
+     * Parts of a sentence, combined into a mask to choose what the text
+     * loader parses (see SentenceReader::setColumns). Words are always
+     * loaded. Dependencies are not parsed, only kept as text so they can be
+     * saved again; the binary format does not store them.
+     */
+    enum Column {
+        COLUMN_WORDS = 1,
+        COLUMN_OFFSETS = 2,     /* start and end offsets */
+        COLUMN_TAGS = 4,
+        COLUMN_LEMMAS = 8,
+        COLUMN_ENTITIES = 16,
+        COLUMN_NORMS = 32,
+        COLUMN_CHUNKS = 64,
+        COLUMN_TREE = 128,      /* the constituent tree (Y block) */
+        COLUMN_ROLES = 256,     /* the predicates (R block) */
+        COLUMN_DEPENDENCIES = 512,  /* the D blocks, as text */
+        COLUMN_ALL = 1023
+    };
 
     // Useful string constants
     static const char NIL;
@@ -50,40 +173,111 @@ public:
     static const string START_COREF;
     static const string START_DEPENDENCIES;
     static const string START_CONSTITUENTS;
+    static const string START_ROLES;
     static const string END_OF_SENTENCE;
     static const string END_OF_DOCUMENT;
     static const string END_OF_DEPENDENCIES;
 
+    // Binary format header
+    static const string BINARY_MAGIC;
+    static const unsigned char BINARY_VERSION;
+
 private:
 
+    friend class SentenceReader;
+
     /**
-     * Tokenize a line.
-     * 	@param line The string to tokenize.
-     * 	@return A vector of tokens.
+     * Caches in front of the global label tables, and scratch space that a
+     * sentence is parsed into before it is copied into storage of the exact
+     * size; one set per reader.
      */
-    static vector<string> tokenize(const string &line);
+    struct LoadBuffers {
+        LoadBuffers() : tags(SymbolTable::tags()),
+                entities(SymbolTable::entities()),
+                chunks(SymbolTable::chunks()), roles(SymbolTable::roles()) {
+        }
+        SymbolCache tags;
+        SymbolCache entities;
+        SymbolCache chunks;
+        SymbolCache roles;
+        StringColumn words;
+        StringColumn lemmas;
+        StringColumn norms;
+        SyntacticTree tree;
+    };
 
     /**
-     * Loads the annotation for the next sentence in the stream.
-     * 	@param stream The input stream.
-     * 	@return A sentence containing the annotations.
+     * Loads the annotation for the next sentence from a line reader.
+     * 	@param lines The source of annotation lines.
+     * 	@param fields Scratch space for the fields of each line.
+     * 	@param buffers The label caches and scratch space of the reader.
+     * 	@param columns Mask of the Columns to load; the others are left
+     * 	empty.
+     * 	@param sentence Overwritten with the annotations; its storage is
+     * 	reused.
      */
-    static Sentence loadSentence(istream &stream);
+    static void loadSentence(LineReader &lines, vector<StringRef> &fields,
+            LoadBuffers &buffers, unsigned int columns, Sentence &sentence);
 
     /**
-     * Print the NLP annotation for the sentence to an output stream.
+     * Print the NLP annotation for the sentence.
      * 	@param doc The annotated sentence.
-     * 	@param out The output stream.
+     * 	@param out The buffered output.
      */
-    static void saveSentence(Sentence sentence, ostream &out);
+    static void saveSentence(const Sentence &sentence, BufferedWriter &out);
 
     /**
-     * Print the NLP annotation for the token to an output stream.
+     * Print the NLP annotation for the token.
      * 	@param doc The annotated sentence.
      * 	@param offset The token offset in the sentence.
-     * 	@param out The output stream.
+     * 	@param out The buffered output.
+     */
+    static void saveToken(const Sentence &sentence, int offset,
+            BufferedWriter &out);
+
+    /**
+     * Loads the predicates of a sentence and their arguments.
+     * 	@param lines The source of annotation lines.
+     * 	@param fields Scratch space; holds the "R" line on entry.
+     * 	@param roles Cache in front of the table of role labels.
+     * 	@param predicates Filled with the predicates.
+     */
+    static void loadRoles(LineReader &lines, vector<StringRef> &fields,
+            SymbolCache &roles, vector<SrlPredicate> &predicates);
+
+    /**
+     * Print the predicates of a sentence and their arguments.
+     * 	@param predicates The predicates.
+     * 	@param out The buffered output.
+     */
+    static void saveRoles(const vector<SrlPredicate> &predicates,
+            BufferedWriter &out);
+
+    /**
+     * Loads a constituent tree, up to and including the end of the sentence.
+     * 	@param lines The source of annotation lines.
+     * 	@param fields Scratch space; holds the EOS line on return.
+     * 	@param tree Filled with the nodes of the tree.
+     */
+    static void loadTree(LineReader &lines, vector<StringRef> &fields,
+            SyntacticTree &tree);
+
+    /**
+     * Print a constituent tree on one line, in pre-order.
+     * 	@param tree The tree.
+     * 	@param out The buffered output.
+     */
+    static void saveTree(const SyntacticTree &tree, BufferedWriter &out);
+
+    /**
+     * Decode a document in the binary format.
+     * 	@param begin Start of the encoded bytes.
+     * 	@param end One past the end of the encoded bytes.
+     * 	@param doc Overwritten with the document; left empty on failure.
+     * 	@return False if the bytes are not a valid binary document.
      */
-    static void saveToken(Sentence sentence, int offset, ostream &out);
+    static bool loadBinary(const char *begin, const char *end,
+            Document &doc);
 
 };
 
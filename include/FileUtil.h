@@ -0,0 +1,58 @@
+/*
+ * FileUtil.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#ifndef PROCESSORS_FILE_UTIL_H_
+#define PROCESSORS_FILE_UTIL_H_
+
+#include <string>
+
+#include <stdint.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+using namespace std;
+
+namespace processors {
+
+/**
+ * CRC-32 of a buffer of any size (zlib takes at most 4 GB at once).
+ * 	@param data The bytes.
+ * 	@param length Number of bytes.
+ * 	@param previous CRC-32 of the bytes before them, to checksum a file a
+ * 	block at a time.
+ */
+uint32_t bufferChecksum(const char *data, size_t length,
+        uint32_t previous = 0);
+
+/**
+ * Flush a file or directory to disk; flushing a directory makes the files
+ * created in it persist.
+ * 	@param path The file or directory.
+ * 	@return False on error.
+ */
+bool syncPath(const string &path);
+
+/**
+ * Modification time of a file in nanoseconds.
+ * 	@param info The status of the file.
+ */
+inline long long modifiedNanos(const struct stat &info) {
+    return info.st_mtim.tv_sec * 1000000000LL + info.st_mtim.tv_nsec;
+}
+
+/**
+ * Write all bytes to a file descriptor, retrying short writes.
+ * 	@param fd The file descriptor.
+ * 	@param data The bytes.
+ * 	@param length Number of bytes.
+ * 	@return False on error (e.g. the other end is gone).
+ */
+bool writeAll(int fd, const char *data, size_t length);
+
+}
+
+#endif /* PROCESSORS_FILE_UTIL_H_ */
@@ -0,0 +1,130 @@
+/*
+ * LineReader.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#ifndef PROCESSORS_LINE_READER_H_
+#define PROCESSORS_LINE_READER_H_
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+#include "TextScanner.h"
+
+using namespace std;
+
+namespace processors {
+
+/**
+ * Source of separator-delimited lines for the deserializer.
+ * Fields returned by nextFields() stay valid until the next call.
+ */
+class LineReader {
+
+public:
+
+    virtual ~LineReader() { }
+
+    /**
+     * Split the next line into fields.
+     * 	@param fields Cleared, then filled with views of each field.
+     * 	@param count Most fields to split; the rest of the line is skipped.
+     * 	@return False if there are no lines left.
+     */
+    virtual bool nextFields(vector<StringRef> &fields,
+            size_t count = (size_t) -1) = 0;
+
+    /**
+     * Read the next line without splitting it, e.g. to skip it.
+     * 	@param line Set to a view of the line, without its newline.
+     * 	@return False if there are no lines left.
+     */
+    virtual bool nextLine(StringRef &line) = 0;
+
+};
+
+/**
+ * Reads lines from an input stream into a single reused buffer.
+ */
+class StreamLineReader : public LineReader {
+
+public:
+
+    /**
+     * Constructor.
+     * 	@param in The input stream.
+     * 	@param sep The field separator.
+     */
+    StreamLineReader(istream &in, char sep) : stream(in), separator(sep) { }
+
+    bool nextFields(vector<StringRef> &fields, size_t count = (size_t) -1) {
+        fields.clear();
+        if (!getline(stream, line))
+            return false;
+        TextScanner scanner(line.data(), line.data() + line.size(), separator);
+        scanner.nextFields(fields, count);
+        return true;
+    }
+
+    bool nextLine(StringRef &view) {
+        if (!getline(stream, line))
+            return false;
+        view = StringRef(line.data(), line.size());
+        return true;
+    }
+
+private:
+
+    istream &stream;
+    string line;
+    char separator;
+
+};
+
+/**
+ * Reads lines straight out of a memory-mapped file.
+ */
+class MappedLineReader : public LineReader {
+
+public:
+
+    /**
+     * Constructor.
+     * 	@param file The mapped file.
+     * 	@param sep The field separator.
+     */
+    MappedLineReader(const MappedFile &file, char sep) :
+            scanner(file.begin(), file.end(), sep) {
+    }
+
+    /**
+     * Constructor for a range of lines of a mapped file.
+     * 	@param begin Start of the first line.
+     * 	@param end One past the end of the last line.
+     * 	@param sep The field separator.
+     */
+    MappedLineReader(const char *begin, const char *end, char sep) :
+            scanner(begin, end, sep) {
+    }
+
+    bool nextFields(vector<StringRef> &fields, size_t count = (size_t) -1) {
+        return scanner.nextFields(fields, count);
+    }
+
+    bool nextLine(StringRef &line) {
+        return scanner.nextLine(line);
+    }
+
+private:
+
+    TextScanner scanner;
+
+};
+
+}
+
+#endif /* PROCESSORS_LINE_READER_H_ */
@@ -0,0 +1,68 @@
+/*
+ * MappedFile.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#ifndef PROCESSORS_MAPPED_FILE_H_
+#define PROCESSORS_MAPPED_FILE_H_
+
+#include <string>
+
+using namespace std;
+
+namespace processors {
+
+/**
+ * A read-only memory mapping of an entire file.
+ * The mapping is released when the object goes out of scope.
+ */
+class MappedFile {
+
+public:
+
+    /**
+     * Constructor. Maps the file; check is_open() for success.
+     * 	@param filename Path to the file.
+     */
+    explicit MappedFile(const string &filename);
+
+    /** Destructor. Unmaps the file. */
+    ~MappedFile();
+
+    /** True if the file was opened and mapped successfully. */
+    bool is_open() const {
+        return opened;
+    }
+
+    /** Start of the mapped contents. */
+    const char *begin() const {
+        return data;
+    }
+
+    /** One past the end of the mapped contents. */
+    const char *end() const {
+        return data + length;
+    }
+
+    /** Size of the file in bytes. */
+    size_t size() const {
+        return length;
+    }
+
+private:
+
+    // Not copyable
+    MappedFile(const MappedFile &);
+    MappedFile &operator=(const MappedFile &);
+
+    const char *data;
+    size_t length;
+    bool opened;
+
+};
+
+}
+
+#endif /* PROCESSORS_MAPPED_FILE_H_ */
@@ -0,0 +1,225 @@
+/*
+ * Metrics.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#ifndef PROCESSORS_METRICS_H_
+#define PROCESSORS_METRICS_H_
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <time.h>
+
+using namespace std;
+
+namespace processors {
+
+/**
+ * Latency measurements of the SRL pipeline.
+ *
+ * Time spent in each stage is recorded per sentence into histograms, one
+ * per stage and sentence-length bucket, and the slowest sentence of every
+ * stage is remembered. A Metrics object describes either one file or a
+ * whole run; a run also keeps a short summary of each of its files. The
+ * results can be written as JSON or as a Prometheus textfile.
+ */
+class Metrics {
+
+public:
+
+    /** Pipeline stages. */
+    enum Stage {
+        LOAD,       /* reading the sentence from the annotation */
+        ENCODE,     /* building the SwiRL input */
+        CACHE,      /* looking up and storing cached output */
+        PARSE,      /* Swirl::parse */
+        TREE,       /* tree->serialize */
+        CONLL,      /* Swirl::serialize */
+        LABEL       /* everything after encoding, cache included */
+    };
+
+    /** Number of stages. */
+    static const int STAGES = 7;
+
+    /** Number of sentence-length buckets. */
+    static const int LENGTHS = 5;
+
+    /** Number of latency buckets, the last one unbounded. */
+    static const int LATENCIES = 7;
+
+    /** Monotonic time in seconds. */
+    static double now() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+    }
+
+    /** Name of a stage, as used in the output. */
+    static const char *stageName(int stage);
+
+    /** Constructor. */
+    Metrics();
+
+    /**
+     * Record the time one sentence spent in a stage.
+     * 	@param stage The stage.
+     * 	@param tokens Length of the sentence.
+     * 	@param seconds Time spent.
+     * 	@param sentence Index of the sentence in its file, if known.
+     */
+    void record(Stage stage, int tokens, double seconds, long sentence = -1);
+
+    /**
+     * Count a sentence that went through the pipeline.
+     * 	@param tokens Length of the sentence.
+     */
+    void countSentence(int tokens) {
+        sentences++;
+        this->tokens += tokens;
+    }
+
+    /**
+     * Add the measurements of another object (e.g. from a worker).
+     * 	@param other The measurements.
+     * 	@param sentence If not negative, the sentence the measurements
+     * 	belong to.
+     */
+    void merge(const Metrics &other, long sentence = -1);
+
+    /**
+     * Add the measurements of a file to a run, and keep its summary if it
+     * is among the slowest files of the run.
+     * 	@param file The measurements of the file.
+     */
+    void addFile(const Metrics &file);
+
+    /**
+     * Append a compact encoding of the measurements (without the file
+     * summaries), for sending them between processes.
+     * 	@param out The encoding is appended here.
+     */
+    void encode(string &out) const;
+
+    /**
+     * Replace the measurements with an encoding made by encode().
+     * 	@param in The encoding.
+     * 	@return False if the encoding is malformed.
+     */
+    bool decode(const string &in);
+
+    /**
+     * Write the measurements to a file, replacing it atomically. Files
+     * ending in ".prom" get the Prometheus text format, others JSON.
+     * 	@param filename Path to the file.
+     * 	@return False if the file could not be written.
+     */
+    bool save(const string &filename) const;
+
+    /** Write the measurements as a JSON object. */
+    void writeJson(ostream &out) const;
+
+    /** Write the measurements in the Prometheus text format. */
+    void writePrometheus(ostream &out) const;
+
+    // Public variables.
+    string file;        /* File measured; empty for a run */
+    long sentences;     /* Sentences processed */
+    long tokens;        /* Tokens processed */
+    double seconds;     /* Wall-clock time of the file or run */
+
+private:
+
+    /** Histogram of one stage for one sentence-length bucket. */
+    struct Cell {
+        long count;
+        double sum;
+        long latencies[LATENCIES];
+    };
+
+    /** The slowest sentence of a stage. */
+    struct Outlier {
+        double seconds;
+        int tokens;
+        long sentence;
+        string file;
+    };
+
+    /** Totals of one file of a run. */
+    struct FileSummary {
+        string file;
+        long sentences;
+        long tokens;
+        double seconds;
+        double stages[STAGES];
+    };
+
+    /** Slower file first. */
+    static bool slowerFile(const FileSummary &a, const FileSummary &b);
+
+    /** Time spent in a stage over all sentences. */
+    double stageSeconds(int stage) const;
+
+    /** Sentences that went through a stage. */
+    long stageCount(int stage) const;
+
+    Cell cells[STAGES][LENGTHS];
+    Outlier slowest[STAGES];
+    vector<FileSummary> files;     /* the slowest files, unordered */
+
+};
+
+/**
+ * Times consecutive stages of one sentence. Does nothing (not even read
+ * the clock) when there is no Metrics object.
+ */
+class StageTimer {
+
+public:
+
+    /**
+     * Constructor. Starts timing.
+     * 	@param metrics Where to record; may be NULL.
+     */
+    explicit StageTimer(Metrics *metrics) : metrics(metrics),
+            started(metrics ? Metrics::now() : 0) {
+    }
+
+    /** Seconds since the last start; 0 when there is no Metrics object. */
+    double elapsed() const {
+        return metrics ? Metrics::now() - started : 0;
+    }
+
+    /** Start timing again, without recording anything. */
+    void restart() {
+        if (metrics != NULL)
+            started = Metrics::now();
+    }
+
+    /**
+     * Record the time since the last start as a stage, and start timing
+     * the next one.
+     * 	@param stage The stage that just finished.
+     * 	@param tokens Length of the sentence.
+     * 	@param sentence Index of the sentence in its file, if known.
+     */
+    void stop(Metrics::Stage stage, int tokens, long sentence = -1) {
+        if (metrics == NULL)
+            return;
+        double finished = Metrics::now();
+        metrics->record(stage, tokens, finished - started, sentence);
+        started = finished;
+    }
+
+private:
+
+    Metrics *metrics;
+    double started;
+
+};
+
+}
+
+#endif /* PROCESSORS_METRICS_H_ */
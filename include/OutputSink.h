@@ -0,0 +1,192 @@
+/*
+ * OutputSink.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#ifndef PROCESSORS_OUTPUT_SINK_H_
+#define PROCESSORS_OUTPUT_SINK_H_
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <string.h>
+
+using namespace std;
+
+namespace processors {
+
+/**
+ * Destination for serialized bytes, written in large blocks.
+ */
+class OutputSink {
+
+public:
+
+    virtual ~OutputSink() { }
+
+    /**
+     * Write a block of bytes.
+     * 	@param data The bytes.
+     * 	@param length Number of bytes.
+     * 	@return False on error.
+     */
+    virtual bool write(const char *data, size_t length) = 0;
+
+    /**
+     * Push written bytes to their final destination.
+     * 	@return False on error.
+     */
+    virtual bool flush() {
+        return true;
+    }
+
+};
+
+/**
+ * Writes to an output stream.
+ */
+class StreamSink : public OutputSink {
+
+public:
+
+    /**
+     * Constructor.
+     * 	@param out The output stream.
+     */
+    explicit StreamSink(ostream &out) : stream(out) { }
+
+    bool write(const char *data, size_t length) {
+        stream.write(data, length);
+        return stream.good();
+    }
+
+    bool flush() {
+        stream.flush();
+        return stream.good();
+    }
+
+private:
+
+    ostream &stream;
+
+};
+
+/**
+ * Writes straight to a file descriptor, bypassing iostreams.
+ */
+class FileSink : public OutputSink {
+
+public:
+
+    /**
+     * Constructor.
+     * 	@param fd An open file descriptor; it is not closed by the sink.
+     */
+    explicit FileSink(int fd) : descriptor(fd) { }
+
+    bool write(const char *data, size_t length);
+
+private:
+
+    int descriptor;
+
+};
+
+/**
+ * Formats text into a large internal buffer and hands it to a sink in
+ * blocks, instead of going through the stream for every field.
+ */
+class BufferedWriter {
+
+public:
+
+    /**
+     * Constructor.
+     * 	@param out The sink receiving full blocks.
+     * 	@param capacity Size of the buffer in bytes.
+     */
+    explicit BufferedWriter(OutputSink &out, size_t capacity = 1 << 16) :
+            sink(out), buffer(capacity), used(0), ok(true) {
+    }
+
+    /** Destructor. Writes out whatever is still buffered. */
+    ~BufferedWriter() {
+        flush();
+    }
+
+    /** Append one character. */
+    void put(char c) {
+        if (used == buffer.size())
+            drain();
+        buffer[used++] = c;
+    }
+
+    /** Append a run of characters. */
+    void write(const char *data, size_t length) {
+        if (length > buffer.size() - used) {
+            drain();
+            if (length > buffer.size()) {
+                ok = sink.write(data, length) && ok;
+                return;
+            }
+        }
+        memcpy(&buffer[used], data, length);
+        used += length;
+    }
+
+    /** Append a string. */
+    void write(const string &s) {
+        write(s.data(), s.size());
+    }
+
+    /** Append the decimal form of an integer. */
+    void writeInt(long value) {
+        char digits[24];
+        char *end = digits + sizeof(digits);
+        char *p = end;
+        unsigned long magnitude = (value < 0) ? -(unsigned long) value : value;
+        do {
+            *--p = '0' + (magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude > 0);
+        if (value < 0)
+            *--p = '-';
+        write(p, end - p);
+    }
+
+    /**
+     * Hand all buffered bytes to the sink and flush it.
+     * 	@return False if any write failed.
+     */
+    bool flush() {
+        drain();
+        ok = sink.flush() && ok;
+        return ok;
+    }
+
+private:
+
+    // Not copyable
+    BufferedWriter(const BufferedWriter &);
+    BufferedWriter &operator=(const BufferedWriter &);
+
+    /** Hand all buffered bytes to the sink. */
+    void drain() {
+        if (used > 0) {
+            ok = sink.write(&buffer[0], used) && ok;
+            used = 0;
+        }
+    }
+
+    OutputSink &sink;
+    vector<char> buffer;
+    size_t used;
+    bool ok;
+
+};
+
+}
+
+#endif /* PROCESSORS_OUTPUT_SINK_H_ */
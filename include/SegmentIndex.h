@@ -0,0 +1,99 @@
+/*
+ * SegmentIndex.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#ifndef PROCESSORS_SEGMENT_INDEX_H_
+#define PROCESSORS_SEGMENT_INDEX_H_
+
+#include <map>
+#include <string>
+
+using namespace std;
+
+namespace processors {
+
+/**
+ * Index of the outputs packed into the segments of an output directory
+ * (see SegmentWriter), by name.
+ *
+ * Segments are named "segment-NNNNN.seg" and hold the outputs back to back,
+ * each exactly as it would have been written to a file of its own (a
+ * complete gzip member or zstd frame when compressed). The index is a text
+ * file in the same directory, FILENAME, with one line per output: the
+ * segment, offset, length and name of the output, separated by tabs.
+ * Lines are appended once the bytes they point to are on disk; a line torn
+ * by a crash is ended with an extra tab by the next writer, and ignored.
+ * An output that was written again (e.g. by a rerun) is listed again; the
+ * last line wins.
+ */
+class SegmentIndex {
+
+public:
+
+    /** Name of the index file in the output directory. */
+    static const string FILENAME;
+
+    /** Where an output lies. */
+    struct Entry {
+        string segment;         /* name of the segment file */
+        long long offset;
+        long long length;
+    };
+
+    /**
+     * Name of a segment file.
+     * 	@param number Number of the segment.
+     */
+    static string segmentName(int number);
+
+    /**
+     * Constructor. Reads the index of an output directory, if any. Entries
+     * that point past the end of their segment are dropped.
+     * 	@param directory The output directory.
+     */
+    explicit SegmentIndex(const string &directory);
+
+    /** True if the directory has an index. */
+    bool is_open() const {
+        return opened;
+    }
+
+    /**
+     * Find an output.
+     * 	@param name Name of the output.
+     * 	@return Its entry, or NULL if it is not in the index.
+     */
+    const Entry *find(const string &name) const;
+
+    /** Every output, by name. */
+    const map<string, Entry> &entries() const {
+        return index;
+    }
+
+    /** Number of outputs. */
+    size_t size() const {
+        return index.size();
+    }
+
+    /**
+     * Path of the segment holding an output.
+     * 	@param entry The entry of the output.
+     */
+    string path(const Entry &entry) const {
+        return directory + "/" + entry.segment;
+    }
+
+private:
+
+    string directory;
+    map<string, Entry> index;
+    bool opened;
+
+};
+
+}
+
+#endif /* PROCESSORS_SEGMENT_INDEX_H_ */
@@ -0,0 +1,117 @@
+/*
+ * SegmentWriter.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#ifndef PROCESSORS_SEGMENT_WRITER_H_
+#define PROCESSORS_SEGMENT_WRITER_H_
+
+#include <string>
+
+#include "CompressedStream.h"
+
+using namespace std;
+
+namespace processors {
+
+/**
+ * Packs outputs into a few large segment files of an output directory,
+ * listed in its SegmentIndex, instead of creating a file for each. Writing
+ * an output then costs a sequential append rather than a file creation,
+ * rename and directory update.
+ *
+ * Each writer appends to a segment of its own, created with the next free
+ * number, and starts a new one once it has grown past the segment size;
+ * several processes may therefore share an output directory. Outputs are
+ * made durable in groups by commit(): the segment is flushed to disk, then
+ * the index lines of the group are appended to the index with a single
+ * write. Outputs that were never committed (e.g. after a crash) are simply
+ * not in the index, and their bytes are never read.
+ */
+class SegmentWriter {
+
+public:
+
+    /**
+     * Constructor. No file is created until the first output.
+     * 	@param directory The output directory.
+     * 	@param codec Compression of each output.
+     * 	@param segmentBytes Size past which a new segment is started.
+     */
+    SegmentWriter(const string &directory, Compression codec,
+            long long segmentBytes);
+
+    /** Destructor. Commits the outputs still pending. */
+    ~SegmentWriter();
+
+    /**
+     * Start an output.
+     * 	@param name Name of the output in the index; it may not contain a
+     * 	tab or newline.
+     * 	@return False if the segment could not be created.
+     */
+    bool open(const string &name);
+
+    /** The stream receiving the bytes of the current output. */
+    ostream &stream() {
+        return out;
+    }
+
+    /**
+     * Finish the current output. It is pending until the next commit.
+     * 	@param length Set to the size of the output in the segment.
+     * 	@return False if the output could not be written.
+     */
+    bool close(long long &length);
+
+    /**
+     * Drop the current output. Its bytes stay in the segment but are never
+     * indexed.
+     */
+    void cancel();
+
+    /** True if enough outputs are pending that they should be committed. */
+    bool due() const;
+
+    /** Number of outputs waiting to be committed. */
+    int pending() const {
+        return pendingCount;
+    }
+
+    /**
+     * Flush the pending outputs to disk and add them to the index.
+     * 	@return False if they could not be made durable.
+     */
+    bool commit();
+
+private:
+
+    // Not copyable
+    SegmentWriter(const SegmentWriter &);
+    SegmentWriter &operator=(const SegmentWriter &);
+
+    /** Create the next free segment. */
+    bool createSegment();
+
+    string directory;
+    Compression codec;
+    long long segmentBytes;
+    int fd;                 /* current segment, or -1 */
+    string segment;         /* its name */
+    long long size;         /* its size so far */
+    int next;               /* number to try for the next segment */
+    bool indexed;           /* the index was written to by this writer */
+    CompressedOutputStream out;
+    string name;            /* the current output */
+    long long start;        /* its offset */
+    string lines;           /* index lines of the pending outputs */
+    int pendingCount;
+    long long pendingBytes;
+
+};
+
+}
+
+#endif /* PROCESSORS_SEGMENT_WRITER_H_ */
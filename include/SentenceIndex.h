@@ -0,0 +1,136 @@
+/*
+ * SentenceIndex.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#ifndef PROCESSORS_SENTENCE_INDEX_H_
+#define PROCESSORS_SENTENCE_INDEX_H_
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#include "MappedFile.h"
+
+using namespace std;
+
+namespace processors {
+
+/**
+ * Byte offsets of the sentences of an annotation file in the text format,
+ * so that any sentence or range of sentences can be read without parsing
+ * everything before it.
+ *
+ * For each sentence, the index holds the offset of its "T" line and the
+ * offset just past its "EOS" line. It is kept in a sidecar file next to
+ * the annotation (the annotation's name plus SUFFIX), stamped with the size
+ * and modification time of the annotation so that a stale index is never
+ * used. The sidecar is memory-mapped when loaded, so looking up a sentence
+ * costs the same whatever its position.
+ *
+ * Layout: a Header, then two 64-bit offsets per sentence. Integers are in
+ * host byte order.
+ */
+class SentenceIndex {
+
+public:
+
+    /** Magic bytes at the start of every index file. */
+    static const string MAGIC;
+
+    /** Version of the layout. */
+    static const uint32_t VERSION;
+
+    /** Appended to the name of an annotation to name its index. */
+    static const string SUFFIX;
+
+    /** Constructor for an empty index. */
+    SentenceIndex();
+
+    /** Destructor. */
+    ~SentenceIndex();
+
+    /**
+     * Index an annotation by scanning it once.
+     * 	@param file The mapped annotation.
+     * 	@return False if the annotation is not in the text format or is
+     * 	truncated.
+     */
+    bool build(const MappedFile &file);
+
+    /**
+     * Write the index to the sidecar of an annotation. The index is written
+     * to a temporary file first and renamed into place.
+     * 	@param annotation Path of the annotation that was indexed.
+     * 	@return False if the sidecar could not be written.
+     */
+    bool save(const string &annotation) const;
+
+    /**
+     * Map the sidecar of an annotation.
+     * 	@param annotation Path of the annotation.
+     * 	@return False if there is no sidecar, or it is corrupt or older than
+     * 	the annotation.
+     */
+    bool load(const string &annotation);
+
+    /**
+     * Load the sidecar of an annotation, or index the annotation in memory
+     * if there is no up-to-date sidecar.
+     * 	@param annotation Path of the annotation.
+     * 	@param file The mapped annotation.
+     * 	@return False if the annotation could not be indexed.
+     */
+    bool open(const string &annotation, const MappedFile &file);
+
+    /** Number of sentences. */
+    size_t size() const {
+        return count;
+    }
+
+    /** Offset of the first byte of a sentence. */
+    uint64_t begin(size_t sentence) const {
+        return offsets[2 * sentence];
+    }
+
+    /** Offset one past the last byte of a sentence. */
+    uint64_t end(size_t sentence) const {
+        return offsets[2 * sentence + 1];
+    }
+
+    /**
+     * Parse a range of sentences: "N" for one sentence, "N-M" for sentences
+     * N to M inclusive, or "N-" for sentence N to the end (numbered from 0).
+     * 	@param text The range.
+     * 	@param first Set to the first sentence of the range.
+     * 	@param last Set to one past the last sentence of the range, or -1 for
+     * 	the end of the document.
+     * 	@return False if the range is malformed.
+     */
+    static bool parseRange(const string &text, int &first, int &last);
+
+    // Layout of the index file
+    struct Header;
+
+private:
+
+    // Not copyable
+    SentenceIndex(const SentenceIndex &);
+    SentenceIndex &operator=(const SentenceIndex &);
+
+    /** Drop the offsets and any mapping. */
+    void clear();
+
+    vector<uint64_t> built;     /* offsets of an index built in memory */
+    MappedFile *mapping;        /* the sidecar, when loaded */
+    const uint64_t *offsets;
+    size_t count;
+
+};
+
+}
+
+#endif /* PROCESSORS_SENTENCE_INDEX_H_ */
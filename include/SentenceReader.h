@@ -0,0 +1,121 @@
+/*
+ * SentenceReader.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#ifndef PROCESSORS_SENTENCE_READER_H_
+#define PROCESSORS_SENTENCE_READER_H_
+
+#include <iostream>
+#include <vector>
+
+#include "Document.h"
+#include "DocumentSerializer.h"
+#include "LineReader.h"
+#include "MappedFile.h"
+#include "SentenceIndex.h"
+
+using namespace std;
+
+namespace processors {
+
+/**
+ * Pulls the sentences of a serialized Document one at a time, so that a
+ * document never has to be fully materialized in memory.
+ *
+ * 	SentenceReader reader(stream);
+ * 	Sentence sentence;
+ * 	while (reader.next(sentence)) { ... }
+ */
+class SentenceReader {
+
+public:
+
+    /**
+     * Constructor. Reads the document header from the stream.
+     * 	@param stream The input stream.
+     */
+    explicit SentenceReader(istream &stream);
+
+    /**
+     * Constructor. Reads the document header from the mapped file.
+     * 	@param file The mapped file.
+     */
+    explicit SentenceReader(const MappedFile &file);
+
+    /**
+     * Constructor. Reads a range of sentences of the mapped file, starting
+     * straight at the first one; nothing before it is read.
+     * 	@param file The mapped file.
+     * 	@param index The sentence index of the file.
+     * 	@param first First sentence to read.
+     * 	@param last One past the last sentence to read, or -1 for the end of
+     * 	the document; clamped to the size of the index.
+     */
+    SentenceReader(const MappedFile &file, const SentenceIndex &index,
+            int first, int last);
+
+    /**
+     * Constructor. Reads sentences from part of a mapped document that
+     * starts at the "T" line of a sentence, without a document header.
+     * 	@param begin Start of the first sentence.
+     * 	@param end One past the end of the last sentence.
+     * 	@param count Number of sentences to read.
+     * 	@param first Position in the document of the first sentence.
+     */
+    SentenceReader(const char *begin, const char *end, int count, int first);
+
+    /** Destructor. */
+    ~SentenceReader();
+
+    /** Number of sentences declared in the document header, or in the
+     * range being read. */
+    int size() const {
+        return sentCount;
+    }
+
+    /** Position in the document of the first sentence read. */
+    int first() const {
+        return base;
+    }
+
+    /**
+     * Choose the parts of each sentence to load; by default all of them.
+     * Parsing only what the consumer needs saves most of the loading time.
+     * 	@param columns Mask of DocumentSerializer::Column values.
+     */
+    void setColumns(unsigned int columns) {
+        this->columns = columns;
+    }
+
+    /**
+     * Load the next sentence, reusing the storage of the given one.
+     * 	@param sentence Overwritten with the next sentence.
+     * 	@return False once all sentences have been read.
+     */
+    bool next(Sentence &sentence);
+
+private:
+
+    // Not copyable
+    SentenceReader(const SentenceReader &);
+    SentenceReader &operator=(const SentenceReader &);
+
+    /** Read the header line with the sentence count. */
+    void readHeader();
+
+    LineReader *lines;
+    vector<StringRef> fields;
+    DocumentSerializer::LoadBuffers buffers;
+    int sentCount;
+    int offset;
+    int base;
+    unsigned int columns;
+
+};
+
+}
+
+#endif /* PROCESSORS_SENTENCE_READER_H_ */
@@ -0,0 +1,126 @@
+/*
+ * SrlCache.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#ifndef PROCESSORS_SRL_CACHE_H_
+#define PROCESSORS_SRL_CACHE_H_
+
+#include <string>
+
+#include <stdint.h>
+#include <sys/types.h>
+
+using namespace std;
+
+namespace processors {
+
+/**
+ * Persistent, content-addressed cache of SwiRL output.
+ *
+ * Keys are the exact SwiRL input lines, qualified by the identity of the
+ * models; values are the bytes SwiRL printed for them. The cache lives in a
+ * directory with two files: "index", an open-addressing hash table that is
+ * memory-mapped and shared by every process using the cache, and "data",
+ * an append-only log of records. Readers take a shared lock on the index
+ * and writers an exclusive one, so forked workers can share a cache.
+ * Hit and miss counters are kept in the index and survive restarts.
+ */
+class SrlCache {
+
+public:
+
+    /**
+     * Constructor. Opens (or creates) the cache; check is_open().
+     * 	@param directory Directory holding the cache files.
+     * 	@param identity Prefix for every key, e.g. a fingerprint of the
+     * 	models, so that output from other models is never replayed.
+     */
+    SrlCache(const string &directory, const string &identity);
+
+    /** Destructor. */
+    ~SrlCache();
+
+    /** True if the cache files were opened successfully. */
+    bool is_open() const {
+        return indexFd >= 0;
+    }
+
+    /**
+     * Look up the output for an input line and count a hit or a miss.
+     * 	@param key The SwiRL input line.
+     * 	@param value Set to the cached output on a hit.
+     * 	@return True on a hit.
+     */
+    bool lookup(const string &key, string &value);
+
+    /**
+     * Store the output for an input line.
+     * 	@param key The SwiRL input line.
+     * 	@param value SwiRL's output for it.
+     * 	@return False if the cache could not be written.
+     */
+    bool insert(const string &key, const string &value);
+
+    /** Total hits recorded in the cache, over all processes and runs. */
+    uint64_t hits() const;
+
+    /** Total misses recorded in the cache, over all processes and runs. */
+    uint64_t misses() const;
+
+    /**
+     * Fingerprint of a directory (names, sizes and modification times of
+     * its files), to tell different model directories apart.
+     * 	@param directory The directory.
+     * 	@return A hex string; empty if the directory cannot be read.
+     */
+    static string fingerprint(const string &directory);
+
+    // Layout of the index file
+    struct Header;
+    struct Slot;
+
+private:
+
+    // Not copyable
+    SrlCache(const SrlCache &);
+    SrlCache &operator=(const SrlCache &);
+
+    /** Open the cache files, creating them if needed. */
+    bool open();
+
+    /** Release the mappings and file descriptors. */
+    void close();
+
+    /**
+     * Reopen the index if it was replaced by a bigger one, or if this
+     * process is a fork of the one that opened it (locks are per open file).
+     */
+    bool refresh();
+
+    /** Map enough of the data log to read [0, size). */
+    bool mapData(uint64_t size);
+
+    /** Find the slot holding a key, or the empty slot where it belongs. */
+    Slot *find(const string &qualified, uint64_t hash);
+
+    /** Replace the index with one twice as large. */
+    bool grow();
+
+    string path;
+    string prefix;
+    pid_t owner;
+    int indexFd;
+    int dataFd;
+    Header *header;
+    size_t indexSize;
+    const char *data;
+    size_t dataSize;
+
+};
+
+}
+
+#endif /* PROCESSORS_SRL_CACHE_H_ */
@@ -0,0 +1,75 @@
+/*
+ * SrlExtractor.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#ifndef PROCESSORS_SRL_EXTRACTOR_H_
+#define PROCESSORS_SRL_EXTRACTOR_H_
+
+#include <string>
+#include <vector>
+
+#include "Document.h"
+
+using namespace std;
+
+namespace processors {
+
+/**
+ * Recovers the predicates and labeled argument spans of a sentence from the
+ * output SwiRL printed for it, so they can be stored in the Sentence. Fresh
+ * output and output replayed from the cache are read the same way.
+ *
+ * The output holds, for each SwiRL input line, the extended Treebank tree
+ * (on one line, if any) and the extended CoNLL table: one row per token,
+ * with the word, the lemma of the predicate or "-", and one column per
+ * predicate in bracket notation, e.g.
+ * 	John    -      (A0*)   *
+ * 	wants   want   (V*)    *
+ * 	to      -      (A1*    *
+ * 	sleep   sleep  *)      (V*)
+ * Blocks are separated by blank lines. A sentence that was split into
+ * chunks has one table per chunk, each after a "# chunk <begin>-<end>" line;
+ * their token offsets are shifted so that they count from the start of the
+ * sentence. Other lines starting with "#" (notes about skipped sentences)
+ * are ignored.
+ */
+class SrlExtractor {
+
+public:
+
+    /**
+     * Extract the predicates from SwiRL's output for a sentence.
+     * 	@param output The output.
+     * 	@param predicates Overwritten with the predicates, in token order.
+     * 	@return False if the output is malformed; the predicates found up
+     * 	to that point are kept.
+     */
+    static bool extract(const string &output,
+            vector<SrlPredicate> &predicates);
+
+private:
+
+    /**
+     * Extract the predicates of one CoNLL table.
+     * 	@param rows The fields of each row.
+     * 	@param offset Offset of the first row in the sentence.
+     * 	@param predicates The predicates are appended to it.
+     * 	@return False if the table is malformed.
+     */
+    static bool extractTable(const vector<vector<string> > &rows, int offset,
+            vector<SrlPredicate> &predicates);
+
+    /** True if a line is an extended Treebank tree. */
+    static bool isTree(const string &line);
+
+    /** True if a cell is in bracket notation, e.g. "(A0*", "*" or "*)". */
+    static bool isBracket(const string &cell);
+
+};
+
+}
+
+#endif /* PROCESSORS_SRL_EXTRACTOR_H_ */
@@ -0,0 +1,165 @@
+/*
+ * SrlServer.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#ifndef PROCESSORS_SRL_SERVER_H_
+#define PROCESSORS_SRL_SERVER_H_
+
+#include <set>
+#include <string>
+
+#include <pthread.h>
+
+#include "BlockingQueue.h"
+#include "Document.h"
+
+using namespace std;
+
+namespace processors {
+
+/**
+ * Function run on the labeling thread for each sentence of a request.
+ * 	@param sentence The sentence; it is freed afterwards, so it may be
+ * 	swapped away.
+ * 	@param result Bytes to send back for the sentence.
+ * 	@param context The context pointer given to the server.
+ * 	@return A status code for the sentence; 0 means success.
+ */
+typedef int (*SentenceHandler)(Sentence &sentence, string &result,
+        void *context);
+
+/**
+ * A long-running server that labels documents sent over a Unix domain
+ * socket, or over a pair of file descriptors such as stdin and stdout.
+ *
+ * Each connection gets a thread that reads and parses its requests, and
+ * queues their sentences on a bounded queue; when the queue is full the
+ * readers stop reading, which pushes back on the clients. A single thread
+ * takes the sentences off the queue and runs the handler (SwiRL is not
+ * thread-safe), answering each sentence as soon as it is labeled. Clients
+ * may pipeline requests; the answers to one connection come back in order.
+ *
+ * Protocol (all header lines end with a newline):
+ * 	request:  DOC <id> <bytes>      followed by a document in the text
+ * 	                                format of DocumentSerializer
+ * 	answers:  SENT <id> <index> <bytes>   followed by the handler's output
+ * 	          FAIL <id> <index> <status>  the handler failed
+ * 	          END <id> <sentences>        the request is complete
+ * 	          ERR <id> <message>          the request, or its document, was
+ * 	                                      malformed; the connection is
+ * 	                                      then closed
+ * The id is chosen by the client and may not contain whitespace.
+ */
+class SrlServer {
+
+public:
+
+    /** Largest document accepted in a request. */
+    static const long MAX_DOCUMENT;
+
+    /**
+     * Constructor.
+     * 	@param handler Function run for each sentence.
+     * 	@param context Passed through to the handler.
+     * 	@param capacity Sentences that may be queued at once.
+     */
+    SrlServer(SentenceHandler handler, void *context, size_t capacity = 256);
+
+    /** Destructor. Removes the socket, if any. */
+    ~SrlServer();
+
+    /**
+     * Create the Unix domain socket to serve on, replacing a stale one.
+     * 	@param path Path of the socket.
+     * 	@return False if the socket could not be created.
+     */
+    bool listen(const string &path);
+
+    /**
+     * Accept connections on the socket until stop() is called, then
+     * answer the sentences already queued.
+     * 	@return False if the server could not be started.
+     */
+    bool serve();
+
+    /**
+     * Serve a single client over a pair of file descriptors, until the
+     * input ends and every request is answered.
+     * 	@param in Descriptor the requests are read from.
+     * 	@param out Descriptor the answers are written to.
+     * 	@return False if the server could not be started.
+     */
+    bool serve(int in, int out);
+
+    /** Stop accepting connections. Safe to call from a signal handler. */
+    void stop();
+
+    /** Number of requests answered so far. */
+    long requests() const {
+        return answered;
+    }
+
+    /** Number of sentences labeled so far. */
+    long sentences() const {
+        return labeled;
+    }
+
+private:
+
+    // Not copyable
+    SrlServer(const SrlServer &);
+    SrlServer &operator=(const SrlServer &);
+
+    struct Connection;
+
+    /** One queued sentence, or the end or rejection of a request. */
+    struct Item {
+        Connection *connection;
+        string id;
+        int index;          /* index of the sentence, or a sentence count */
+        Sentence *sentence; /* NULL for the end of a request */
+        string error;       /* rejection message, if any */
+    };
+
+    /** Entry points of the threads. */
+    static void *readThread(void *argument);
+    static void *labelThread(void *argument);
+
+    /** Start a reader thread for a connection. */
+    bool accept(int in, int out, bool owned);
+
+    /** Read requests from a connection until it ends. */
+    void read(Connection *connection);
+
+    /** Label queued sentences until the queue is closed and drained. */
+    void label();
+
+    /** Answer one queued item. */
+    void answer(Item &item);
+
+    /** Drop a reference to a connection, closing it with the last one. */
+    void release(Connection *connection);
+
+    /** Wait until every connection is closed. */
+    void drain();
+
+    SentenceHandler handler;
+    void *context;
+    BlockingQueue<Item> queue;
+    string socketPath;
+    int listener;
+    volatile bool stopping;
+    set<Connection *> connections;
+    pthread_mutex_t mutex;
+    pthread_cond_t closed;
+    long answered;
+    long labeled;
+
+};
+
+}
+
+#endif /* PROCESSORS_SRL_SERVER_H_ */
@@ -0,0 +1,147 @@
+/*
+ * StringColumn.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#ifndef PROCESSORS_STRING_COLUMN_H_
+#define PROCESSORS_STRING_COLUMN_H_
+
+#include <string>
+#include <vector>
+
+#include <assert.h>
+#include <stdint.h>
+
+#include "TextScanner.h"
+
+using namespace std;
+
+namespace processors {
+
+/**
+ * A column of strings (one per token) stored back to back in a single
+ * arena, with the end offset of each string kept in a compact array.
+ * A column of n strings takes two allocations, whatever n, instead of up
+ * to n + 1 for a vector<string>, and 4 bytes of overhead per string instead
+ * of 32. Strings are read as StringRefs into the arena, which stay valid
+ * until the column is next modified.
+ */
+class StringColumn {
+
+public:
+
+    /** Constructor for an empty column. */
+    StringColumn() { }
+
+    /**
+     * Constructor.
+     * 	@param values The strings of the column.
+     */
+    explicit StringColumn(const vector<string> & values) {
+        size_t bytes = 0;
+        for (unsigned int i = 0; i < values.size(); i++)
+            bytes += values[i].size();
+        reserve(values.size(), bytes);
+        for (unsigned int i = 0; i < values.size(); i++)
+            push_back(values[i]);
+    }
+
+    /** Number of strings. */
+    size_t size() const {
+        return ends.size();
+    }
+
+    /** True if the column holds no strings. */
+    bool empty() const {
+        return ends.empty();
+    }
+
+    /** View of a string. */
+    StringRef operator[](size_t i) const {
+        size_t start = (i == 0) ? 0 : ends[i - 1];
+        return StringRef(arena.data() + start, ends[i] - start);
+    }
+
+    /** View of a string, checking the index. */
+    StringRef at(size_t i) const {
+        assert(i < ends.size());
+        return (*this)[i];
+    }
+
+    /** Copy of a string. */
+    string str(size_t i) const {
+        return at(i).str();
+    }
+
+    /** Total length of the strings. */
+    size_t bytes() const {
+        return arena.size();
+    }
+
+    /**
+     * Append a string.
+     * 	@param data Characters of the string.
+     * 	@param length Number of characters.
+     */
+    void push_back(const char *data, size_t length) {
+        arena.append(data, length);
+        assert(arena.size() == (uint32_t) arena.size());
+        ends.push_back((uint32_t) arena.size());
+    }
+
+    /** Append a string. */
+    void push_back(const StringRef & s) {
+        push_back(s.data, s.length);
+    }
+
+    /** Append a string. */
+    void push_back(const string & s) {
+        push_back(s.data(), s.size());
+    }
+
+    /**
+     * Append a range of the strings of another column.
+     * 	@param other The other column.
+     * 	@param begin First string of the range.
+     * 	@param end One past the last string of the range.
+     */
+    void append(const StringColumn & other, size_t begin, size_t end) {
+        assert(begin <= end && end <= other.size());
+        for (size_t i = begin; i < end; i++)
+            push_back(other[i]);
+    }
+
+    /**
+     * Make room for strings, so that appending them does not reallocate.
+     * 	@param count Number of strings.
+     * 	@param length Total length of the strings.
+     */
+    void reserve(size_t count, size_t length) {
+        ends.reserve(count);
+        arena.reserve(length);
+    }
+
+    /** Remove all strings; the storage is kept for reuse. */
+    void clear() {
+        arena.clear();
+        ends.clear();
+    }
+
+    /** Exchange the contents of two columns, without copying. */
+    void swap(StringColumn & other) {
+        arena.swap(other.arena);
+        ends.swap(other.ends);
+    }
+
+private:
+
+    string arena;               /* The strings, back to back */
+    vector<uint32_t> ends;      /* One past the end of each string */
+
+};
+
+}
+
+#endif /* PROCESSORS_STRING_COLUMN_H_ */
@@ -0,0 +1,174 @@
+/*
+ * SymbolTable.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#ifndef PROCESSORS_SYMBOL_TABLE_H_
+#define PROCESSORS_SYMBOL_TABLE_H_
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <pthread.h>
+#include <string.h>
+
+using namespace std;
+
+namespace processors {
+
+/**
+ * Compact ID of an interned label (POS tag, NE label, chunk label or
+ * semantic role).
+ */
+typedef unsigned short Symbol;
+
+/**
+ * Interns strings and hands out dense integer IDs for them, starting at 0.
+ * Interning is serialized with a mutex; looking up the name of an ID that
+ * has already been handed out never blocks, since interned strings never
+ * move.
+ */
+class SymbolTable {
+
+public:
+
+    /**
+     * Constructor.
+     * 	@param capacity Maximum number of symbols; names can be looked up
+     * 	concurrently with interning only when this is set.
+     */
+    explicit SymbolTable(size_t capacity = 0);
+
+    /** Destructor. */
+    ~SymbolTable();
+
+    /**
+     * Get the ID of a string, adding it to the table if it is new. Adding
+     * a string to a table that holds its capacity aborts the program.
+     * 	@param data Characters of the string.
+     * 	@param length Number of characters.
+     * 	@return The ID of the string.
+     */
+    unsigned int intern(const char *data, size_t length);
+
+    /**
+     * Get the ID of a string, adding it to the table if it is new.
+     * 	@param s The string.
+     * 	@return The ID of the string.
+     */
+    unsigned int intern(const string &s) {
+        return intern(s.data(), s.size());
+    }
+
+    /**
+     * Get the string for an ID.
+     * 	@param id An ID previously returned by intern().
+     * 	@return The interned string.
+     */
+    const string &name(unsigned int id) const {
+        return *names[id];
+    }
+
+    /** Number of interned strings. */
+    size_t size() const {
+        return names.size();
+    }
+
+    /** Global table of POS tags. */
+    static SymbolTable &tags();
+
+    /** Global table of named entity labels. */
+    static SymbolTable &entities();
+
+    /** Global table of shallow parsing (chunk) labels. */
+    static SymbolTable &chunks();
+
+    /** Global table of semantic role labels. */
+    static SymbolTable &roles();
+
+    /** ID of the NIL label in each of the global tables. */
+    static const Symbol NIL_SYMBOL;
+
+private:
+
+    // Not copyable
+    SymbolTable(const SymbolTable &);
+    SymbolTable &operator=(const SymbolTable &);
+
+    /** Double the hash index once it is half full. */
+    void grow();
+
+    deque<string> strings;
+    vector<const string *> names;
+    vector<int> slots;
+    size_t maxSize;
+    pthread_mutex_t lock;
+
+};
+
+/**
+ * A small cache in front of a SymbolTable, for a single thread. Labels come
+ * from small vocabularies and repeat on every line, so nearly every lookup
+ * is answered here without taking the table's lock, and threads that load
+ * annotations in parallel do not contend on it. The table must have been
+ * created with a capacity (as the global tables are), so that names can be
+ * read while other threads intern.
+ */
+class SymbolCache {
+
+public:
+
+    /**
+     * Constructor.
+     * 	@param table The table to cache.
+     */
+    explicit SymbolCache(SymbolTable &table) : table(table) {
+        for (unsigned int i = 0; i < SIZE; i++)
+            entries[i].name = NULL;
+    }
+
+    /**
+     * Get the ID of a string, adding it to the table if it is new.
+     * 	@param data Characters of the string.
+     * 	@param length Number of characters.
+     * 	@return The ID of the string.
+     */
+    Symbol intern(const char *data, size_t length) {
+        unsigned int hash = (unsigned int) length;
+        for (size_t i = 0; i < length; i++)
+            hash = hash * 31 + (unsigned char) data[i];
+        Entry &entry = entries[hash & (SIZE - 1)];
+        if (entry.name != NULL && entry.name->size() == length
+                && memcmp(entry.name->data(), data, length) == 0)
+            return entry.id;
+        entry.id = table.intern(data, length);
+        entry.name = &table.name(entry.id);
+        return entry.id;
+    }
+
+private:
+
+    // Not copyable
+    SymbolCache(const SymbolCache &);
+    SymbolCache &operator=(const SymbolCache &);
+
+    /** Number of entries; a power of two. */
+    static const unsigned int SIZE = 128;
+
+    /** A cached symbol; the name points into the table. */
+    struct Entry {
+        const string *name;
+        Symbol id;
+    };
+
+    SymbolTable &table;
+    Entry entries[SIZE];
+
+};
+
+}
+
+#endif /* PROCESSORS_SYMBOL_TABLE_H_ */
@@ -0,0 +1,195 @@
+/*
+ * TextScanner.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#ifndef PROCESSORS_TEXT_SCANNER_H_
+#define PROCESSORS_TEXT_SCANNER_H_
+
+#include <string>
+#include <vector>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+namespace processors {
+
+/**
+ * A non-owning view of a run of characters, usually pointing straight into
+ * a memory-mapped annotation file. The referenced buffer must outlive it.
+ */
+class StringRef {
+
+public:
+
+    /** Constructor for an empty view. */
+    StringRef() : data(NULL), length(0) { }
+
+    /**
+     * Constructor.
+     * 	@param d Pointer to the first character
+     * 	@param l Number of characters in the view
+     */
+    StringRef(const char *d, size_t l) : data(d), length(l) { }
+
+    // Public variables.
+    const char *data;
+    size_t length;
+
+    /** True if the view holds no characters. */
+    bool empty() const {
+        return length == 0;
+    }
+
+    /** True if the view holds exactly the given string. */
+    bool equals(const string &s) const {
+        return s.size() == length && memcmp(s.data(), data, length) == 0;
+    }
+
+    /** Copy of the viewed characters. */
+    string str() const {
+        return string(data, length);
+    }
+
+};
+
+/**
+ * Find the first occurrence of either character in [begin, end).
+ * Scans 16 bytes at a time when SSE2 is available.
+ * 	@param begin Start of the buffer.
+ * 	@param end One past the end of the buffer.
+ * 	@param a First character to look for.
+ * 	@param b Second character to look for.
+ * 	@return Pointer to the first match, or end if there is none.
+ */
+inline const char *findEither(const char *begin, const char *end, char a,
+        char b) {
+#ifdef __SSE2__
+    const __m128i va = _mm_set1_epi8(a);
+    const __m128i vb = _mm_set1_epi8(b);
+    while (end - begin >= 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *) begin);
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, va),
+                _mm_cmpeq_epi8(chunk, vb)));
+        if (mask != 0)
+            return begin + __builtin_ctz(mask);
+        begin += 16;
+    }
+#endif
+    while (begin < end && *begin != a && *begin != b)
+        begin++;
+    return begin;
+}
+
+/**
+ * Parse a decimal integer in place, with the same leniency as atoi
+ * (optional sign, stops at the first non-digit).
+ * 	@param ref The characters to parse.
+ * 	@return The parsed value, or 0 if there are no digits.
+ */
+inline int parseInt(const StringRef &ref) {
+    const char *p = ref.data;
+    const char *end = ref.data + ref.length;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        p++;
+    }
+    int value = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        value = value * 10 + (*p - '0');
+        p++;
+    }
+    return negative ? -value : value;
+}
+
+/**
+ * Splits an in-memory buffer into lines and separator-delimited fields,
+ * without copying. Fields follow the same rules as getline-based
+ * tokenization: an empty line has no fields and a trailing separator does
+ * not produce a trailing empty field.
+ */
+class TextScanner {
+
+public:
+
+    /**
+     * Constructor.
+     * 	@param begin Start of the buffer.
+     * 	@param end One past the end of the buffer.
+     * 	@param sep The field separator.
+     */
+    TextScanner(const char *begin, const char *end, char sep) :
+            cursor(begin), limit(end), separator(sep) {
+    }
+
+    /** True once every line has been consumed. */
+    bool atEnd() const {
+        return cursor >= limit;
+    }
+
+    /**
+     * Split the next line into fields.
+     * 	@param fields Cleared, then filled with views of each field.
+     * 	@param count Most fields to split; the rest of the line is skipped
+     * 	without being looked at field by field.
+     * 	@return False if there are no lines left.
+     */
+    bool nextFields(vector<StringRef> &fields, size_t count = (size_t) -1) {
+        fields.clear();
+        if (cursor >= limit)
+            return false;
+        const char *start = cursor;
+        while (true) {
+            if (fields.size() == count) {
+                const char *stop = (const char *) memchr(start, '\n',
+                        limit - start);
+                cursor = (stop == NULL) ? limit : stop + 1;
+                return true;
+            }
+            const char *stop = findEither(start, limit, separator, '\n');
+            if (stop == limit || *stop == '\n') {
+                if (stop > start)
+                    fields.push_back(StringRef(start, stop - start));
+                cursor = (stop == limit) ? limit : stop + 1;
+                return true;
+            }
+            fields.push_back(StringRef(start, stop - start));
+            start = stop + 1;
+        }
+    }
+
+    /**
+     * Find the next line, without splitting it into fields.
+     * 	@param line Set to a view of the line, without its newline.
+     * 	@return False if there are no lines left.
+     */
+    bool nextLine(StringRef &line) {
+        if (cursor >= limit)
+            return false;
+        const char *stop = (const char *) memchr(cursor, '\n',
+                limit - cursor);
+        if (stop == NULL)
+            stop = limit;
+        line = StringRef(cursor, stop - cursor);
+        cursor = (stop == limit) ? limit : stop + 1;
+        return true;
+    }
+
+private:
+
+    const char *cursor;
+    const char *limit;
+    char separator;
+
+};
+
+}
+
+#endif /* PROCESSORS_TEXT_SCANNER_H_ */
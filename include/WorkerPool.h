@@ -0,0 +1,156 @@
+/*
+ * WorkerPool.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#ifndef PROCESSORS_WORKER_POOL_H_
+#define PROCESSORS_WORKER_POOL_H_
+
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+using namespace std;
+
+namespace processors {
+
+/**
+ * Function run inside a worker process for each task.
+ * 	@param task The task sent by the parent.
+ * 	@param result Bytes to send back to the parent.
+ * 	@param context The context pointer given to the pool.
+ * 	@return A status code for the task; 0 means success.
+ */
+typedef int (*TaskHandler)(const string &task, string &result,
+        void *context);
+
+/**
+ * A pool of forked worker processes.
+ *
+ * Everything the parent initialized before start() (such as the SwiRL
+ * models) is shared with the workers copy-on-write, so it is loaded once
+ * rather than once per worker. The parent hands out one task at a time to
+ * each idle worker over a pipe and reads results back over another.
+ *
+ * Workers are isolated from the parent: one that crashes, or overruns the
+ * time budget of its task, is killed and replaced by a fresh fork. Writes
+ * to a dead worker fail instead of raising SIGPIPE; the disposition of the
+ * signal is left as it is.
+ *
+ * Since a fork copies only the calling thread, the pool must be created
+ * and used before any other thread is started: a lock held by another
+ * thread at the time of a fork would stay locked in the worker for good.
+ */
+class WorkerPool {
+
+public:
+
+    /** Status reported for a task whose worker died while running it. */
+    static const int WORKER_DIED;
+
+    /** Status reported for a task that ran out of time. */
+    static const int TIMED_OUT;
+
+    /**
+     * Constructor.
+     * 	@param workers Number of worker processes.
+     * 	@param handler Function run by the workers for each task.
+     * 	@param context Passed through to the handler.
+     */
+    WorkerPool(int workers, TaskHandler handler, void *context);
+
+    /** Destructor. Shuts down the workers if needed. */
+    ~WorkerPool();
+
+    /**
+     * Fork the workers.
+     * 	@return False if the pipes or processes could not be created.
+     */
+    bool start();
+
+    /**
+     * Set the time budget of each task; the worker of a task that runs
+     * longer is killed. No budget by default.
+     * 	@param seconds The budget; 0 for none.
+     */
+    void setTimeout(double seconds) {
+        timeout = seconds;
+    }
+
+    /**
+     * Send a task to an idle worker.
+     * 	@param id Identifier reported back with the result.
+     * 	@param task The task.
+     * 	@return False if no worker is idle.
+     */
+    bool submit(long id, const string &task);
+
+    /**
+     * Wait for the next task to complete.
+     * 	@param id Set to the identifier of the completed task.
+     * 	@param status Set to the status returned by the handler, or
+     * 	WORKER_DIED or TIMED_OUT.
+     * 	@param result Set to the bytes returned by the handler.
+     * 	@return False if no task is running.
+     */
+    bool collect(long &id, int &status, string &result);
+
+    /** Number of tasks submitted but not yet collected. */
+    int pending() const {
+        return running;
+    }
+
+    /** Number of live workers. */
+    int size() const;
+
+    /**
+     * Stop the workers and wait for them to exit. Running tasks are
+     * abandoned.
+     * 	@return Number of workers that did not exit cleanly.
+     */
+    int shutdown();
+
+private:
+
+    // Not copyable
+    WorkerPool(const WorkerPool &);
+    WorkerPool &operator=(const WorkerPool &);
+
+    /** Bookkeeping for one worker process. */
+    struct Worker {
+        pid_t pid;
+        int taskFd;     /* parent -> worker */
+        int resultFd;   /* worker -> parent */
+        bool busy;
+        long task;
+        double started;     /* when the task was sent */
+    };
+
+    /** Fork one worker into the given slot. */
+    bool spawn(int slot);
+
+    /** Main loop of a worker process; never returns. */
+    void serve(int taskFd, int resultFd);
+
+    /** Mark a worker as gone and reap it. */
+    void retire(Worker &worker);
+
+    /** Kill the worker in a slot and fork a new one in its place. */
+    void replace(int slot);
+
+    int count;
+    TaskHandler handler;
+    void *context;
+    vector<Worker> workers;
+    int running;
+    int failures;
+    double timeout;
+
+};
+
+}
+
+#endif /* PROCESSORS_WORKER_POOL_H_ */
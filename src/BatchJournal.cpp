@@ -0,0 +1,250 @@
+/*
+ * BatchJournal.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#include <fstream>
+#include <sstream>
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "BatchJournal.h"
+#include "FileUtil.h"
+#include "MappedFile.h"
+
+using namespace std;
+using namespace processors;
+
+/* Name of the journal file in the output directory */
+const string BatchJournal::FILENAME = ".swirl-journal";
+
+/**
+ * Constructor. Reads the journal of an output directory, if any.
+ * 	@param outdir The output directory.
+ */
+BatchJournal::BatchJournal(const string &outdir) :
+        path(outdir + "/" + FILENAME), torn(false) {
+    ifstream in(path.c_str());
+    if (!in)
+        return;
+    stringstream contents;
+    contents << in.rdbuf();
+    string text = contents.str();
+    torn = !text.empty() && text[text.size() - 1] != '\n';
+
+    // One record per line; a line without its newline was torn by a crash
+    string::size_type start = 0, end;
+    while ((end = text.find('\n', start)) != string::npos) {
+        string line = text.substr(start, end - start);
+        start = end + 1;
+
+        string::size_type tab = line.find('\t');
+        string::size_type tab2 = (tab == string::npos)
+                ? string::npos : line.find('\t', tab + 1);
+        if (tab2 == string::npos)
+            continue;
+        Entry entry;
+        istringstream fields(line.substr(0, tab));
+        fields >> entry.size >> entry.mtime >> entry.checksum
+                >> entry.outputSize;
+        if (fields.fail())
+            continue;
+        entry.output = line.substr(tab2 + 1);
+        entries[line.substr(tab + 1, tab2 - tab - 1)] = entry;
+    }
+}
+
+/**
+ * Check if an input was completed and neither it nor its output has changed
+ * since.
+ * 	@param input Path of the input file.
+ * 	@param output Path of its output file.
+ * 	@return True if the input can be skipped.
+ */
+bool BatchJournal::completed(const string &input,
+        const string &output) const {
+    struct stat info;
+    if (stat(output.c_str(), &info) != 0)
+        return false;
+    return completed(input, output, info.st_size);
+}
+
+/**
+ * Check if an input was completed and neither it nor its output has changed
+ * since, for an output that is not a file of its own (e.g. an entry of a
+ * segment).
+ * 	@param input Path of the input file.
+ * 	@param output Path or name of its output.
+ * 	@param outputSize Current size of the output.
+ * 	@return True if the input can be skipped.
+ */
+bool BatchJournal::completed(const string &input, const string &output,
+        long long outputSize) const {
+    map<string, Entry>::const_iterator found = entries.find(baseName(input));
+    if (found == entries.end())
+        return false;
+    const Entry &entry = found->second;
+
+    struct stat info;
+    if (entry.output != baseName(output) || outputSize != entry.outputSize)
+        return false;
+    if (stat(input.c_str(), &info) != 0 || info.st_size != entry.size)
+        return false;
+    return modifiedNanos(info) == entry.mtime
+            || checksum(input) == entry.checksum;
+}
+
+/** Destructor. Flushes the records still pending. */
+BatchJournal::~BatchJournal() {
+    flush();
+}
+
+/**
+ * Record that an input was completed. The output must already be in place.
+ * The input is read again for its checksum and the journal is flushed right
+ * away; add() avoids both.
+ * 	@param input Path of the input file.
+ * 	@param output Path of its output file.
+ * 	@return False if the journal could not be written.
+ */
+bool BatchJournal::record(const string &input, const string &output) {
+    return record(input, output, -1);
+}
+
+/**
+ * Record that an input was completed, for an output that is not a file of
+ * its own. The output must already be durable.
+ * 	@param input Path of the input file.
+ * 	@param output Path or name of its output.
+ * 	@param outputSize Size of the output.
+ * 	@return False if the journal could not be written.
+ */
+bool BatchJournal::record(const string &input, const string &output,
+        long long outputSize) {
+    MappedFile file(input);
+    if (!file.is_open())
+        return false;
+    uint32_t crc = bufferChecksum(file.begin(), file.size());
+    return add(input, output, outputSize, crc) && flush();
+}
+
+/**
+ * Add a completed input to the records written by the next flush(), with
+ * the checksum of its contents as they were read, so that the input is not
+ * read again. The output must already be durable.
+ * 	@param input Path of the input file.
+ * 	@param output Path or name of its output.
+ * 	@param outputSize Size of the output, or -1 if it is a file of its own
+ * 	whose size is looked up.
+ * 	@param checksum CRC-32 of the input (see bufferChecksum).
+ * 	@return False if the input or output could not be found.
+ */
+bool BatchJournal::add(const string &input, const string &output,
+        long long outputSize, uint32_t checksum) {
+    struct stat in, out;
+    if (stat(input.c_str(), &in) != 0)
+        return false;
+    if (outputSize < 0) {
+        if (stat(output.c_str(), &out) != 0)
+            return false;
+        outputSize = out.st_size;
+    }
+    Entry entry;
+    entry.size = in.st_size;
+    entry.mtime = modifiedNanos(in);
+    entry.checksum = hexChecksum(checksum);
+    entry.output = baseName(output);
+    entry.outputSize = outputSize;
+
+    char fields[96];
+    snprintf(fields, sizeof(fields), "%lld %lld %s %lld\t", entry.size,
+            entry.mtime, entry.checksum.c_str(), entry.outputSize);
+    lines += fields + baseName(input) + "\t" + entry.output + "\n";
+    added.push_back(make_pair(baseName(input), entry));
+    return true;
+}
+
+/**
+ * Append the records added since the last flush to the journal, with a
+ * single write, and flush it to disk.
+ * 	@return False if the journal could not be written; the records are then
+ * 	dropped.
+ */
+bool BatchJournal::flush() {
+    if (added.empty())
+        return true;
+    string text;
+    text.swap(lines);
+    vector<pair<string, Entry> > records;
+    records.swap(added);
+    if (torn)
+        text.insert(0, "\n");
+
+    // A single append, so records of concurrent processes do not interleave
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0)
+        return false;
+    bool ok = writeAll(fd, text.data(), text.size()) && fsync(fd) == 0;
+    ok = (close(fd) == 0) && ok;
+    if (ok) {
+        for (unsigned int i = 0; i < records.size(); i++)
+            entries[records[i].first] = records[i].second;
+        torn = false;
+    }
+    return ok;
+}
+
+/**
+ * Path of the temporary file an output is written to before it is
+ * committed.
+ * 	@param output Path of the output file.
+ */
+string BatchJournal::partial(const string &output) {
+    return output + ".part";
+}
+
+/**
+ * Commit an output written to its temporary file: flush it to disk and
+ * rename it into place.
+ * 	@param output Path of the output file.
+ * 	@return False if the output could not be committed.
+ */
+bool BatchJournal::commit(const string &output) {
+    string temporary = partial(output);
+    if (!syncPath(temporary)
+            || rename(temporary.c_str(), output.c_str()) != 0)
+        return false;
+    string::size_type slash = output.find_last_of('/');
+    return syncPath(slash == string::npos ? "." : output.substr(0, slash));
+}
+
+/**
+ * Checksum of the contents of a file; empty if it cannot be read.
+ */
+string BatchJournal::checksum(const string &path) {
+    MappedFile file(path);
+    if (!file.is_open())
+        return "";
+    return hexChecksum(bufferChecksum(file.begin(), file.size()));
+}
+
+/**
+ * Hexadecimal form of a checksum, as written to the journal.
+ */
+string BatchJournal::hexChecksum(uint32_t checksum) {
+    char hex[16];
+    snprintf(hex, sizeof(hex), "%08lx", (unsigned long) checksum);
+    return hex;
+}
+
+/**
+ * Name of a file without its directory.
+ */
+string BatchJournal::baseName(const string &path) {
+    string::size_type slash = path.find_last_of('/');
+    return (slash == string::npos) ? path : path.substr(slash + 1);
+}
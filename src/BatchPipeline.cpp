@@ -0,0 +1,367 @@
+/*
+ * BatchPipeline.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#include <iostream>
+
+#include "BatchJournal.h"
+#include "BatchPipeline.h"
+#include "FileUtil.h"
+#include "MappedFile.h"
+#include "Metrics.h"
+#include "SentenceIndex.h"
+#include "SentenceReader.h"
+
+using namespace std;
+using namespace processors;
+
+/**
+ * Constructor.
+ * 	@param stages The work done for each file.
+ * 	@param compress Compression of the output files.
+ * 	@param capacity Sentences each queue may hold at once.
+ */
+BatchPipeline::BatchPipeline(PipelineStages &stages, Compression compress,
+        size_t capacity) : stages(stages), compress(compress),
+        firstSentence(0), lastSentence(-1),
+        columns(DocumentSerializer::COLUMN_ALL), loaded(capacity),
+        labeled(capacity), spare(2 * capacity + 4), failed(false),
+        segments(NULL) {
+}
+
+/** Destructor. Frees the spare sentences. */
+BatchPipeline::~BatchPipeline() {
+    Sentence *sentence;
+    while (spare.tryPop(sentence))
+        delete sentence;
+}
+
+/**
+ * Add a file to the run.
+ * 	@param infile Path of the annotation.
+ * 	@param outfile Path of the output.
+ */
+void BatchPipeline::add(const string &infile, const string &outfile) {
+    infiles.push_back(infile);
+    outfiles.push_back(outfile);
+}
+
+/**
+ * Label every file, on the calling thread, until they are all written or
+ * one fails.
+ * 	@return False if a file failed or the threads could not start.
+ */
+bool BatchPipeline::run() {
+    pthread_t reader, writer;
+    if (pthread_create(&reader, NULL, readThread, this) != 0)
+        return false;
+    if (pthread_create(&writer, NULL, writeThread, this) != 0) {
+        fail();
+        label();
+        pthread_join(reader, NULL);
+        return false;
+    }
+    label();
+    pthread_join(reader, NULL);
+    pthread_join(writer, NULL);
+    return !failed;
+}
+
+/** Entry point of the reader thread. */
+void *BatchPipeline::readThread(void *argument) {
+    ((BatchPipeline *) argument)->read();
+    return NULL;
+}
+
+/** Entry point of the writer thread. */
+void *BatchPipeline::writeThread(void *argument) {
+    ((BatchPipeline *) argument)->write();
+    return NULL;
+}
+
+/**
+ * Load every file onto the queue of loaded sentences, then close it.
+ */
+void BatchPipeline::read() {
+    for (unsigned int i = 0; i < infiles.size() && !failed; i++) {
+        if (!readFile(i))
+            break;
+    }
+    loaded.close();
+}
+
+/**
+ * Load one file onto the queue of loaded sentences: its start, every
+ * sentence, and its end. Files ending in .gz or .zst are decompressed on
+ * the fly; with a range, the sentence index is used to seek to it.
+ * 	@param file Index of the file.
+ * 	@return False if the run was stopped.
+ */
+bool BatchPipeline::readFile(int file) {
+    const string &filename = infiles[file];
+    MappedFile *mapped = NULL;
+    SentenceIndex index;
+    CompressedInputStream *stream = NULL;
+    SentenceReader *reader = NULL;
+    bool ranged = firstSentence > 0 || lastSentence >= 0;
+    if (compressionOf(filename) == COMPRESSION_NONE) {
+        mapped = new MappedFile(filename);
+        if (!mapped->is_open()) {
+            cerr << "Failed to find annotation file!\n";
+        } else if (!ranged) {
+            reader = new SentenceReader(*mapped);
+        } else if (index.open(filename, *mapped)) {
+            reader = new SentenceReader(*mapped, index, firstSentence,
+                    lastSentence);
+        } else {
+            cerr << "Failed to index annotation file: " << filename << endl;
+        }
+    } else if (ranged) {
+        cerr << "Sentence ranges need an uncompressed annotation file: "
+                << filename << endl;
+    } else {
+        // Decompression runs on its own thread, ahead of the parser
+        stream = new CompressedInputStream(filename);
+        if (stream->is_open())
+            reader = new SentenceReader(*stream);
+        else
+            cerr << "Failed to find annotation file!\n";
+    }
+
+    bool ok = (reader != NULL);
+    if (ok)
+        reader->setColumns(columns);
+    bool running = true;
+    uint32_t checksum = 0;
+    if (ok) {
+        running = push(BEGIN, file, reader->size());
+        Item item;
+        item.kind = SENTENCE;
+        item.file = file;
+        item.index = reader->first();
+        item.count = 0;
+        item.ok = true;
+        item.labels = NULL;
+        item.checksum = 0;
+        while (running) {
+            double started = Metrics::now();
+            item.sentence = take();
+            if (!reader->next(*item.sentence)) {
+                delete item.sentence;
+                break;
+            }
+            item.seconds = Metrics::now() - started;
+            running = loaded.push(item);
+            if (!running)
+                delete item.sentence;
+            item.index++;
+        }
+    }
+    delete reader;
+    if (stream != NULL) {
+        stream->close();
+        if (ok && stream->fail()) {
+            cerr << "Corrupt compressed file: " << filename << endl;
+            ok = false;
+        }
+        checksum = stream->checksum();
+    } else if (ok && !ranged) {
+        // Taken while the file is still mapped, for the journal
+        checksum = bufferChecksum(mapped->begin(), mapped->size());
+    }
+    delete stream;
+    delete mapped;
+    // A file that could not be read stops the run
+    return running && push(END, file, 0, ok, checksum) && ok;
+}
+
+/**
+ * Label the loaded sentences until the reader is done, then close the queue
+ * of labeled sentences. After a failure, the rest is dropped unlabeled.
+ */
+void BatchPipeline::label() {
+    Item item;
+    while (loaded.pop(item)) {
+        if (failed) {
+            discard(item);
+            continue;
+        }
+        if (item.kind == BEGIN) {
+            stages.begin(item.file);
+        } else if (item.kind == SENTENCE) {
+            item.labels = new string();
+            stages.label(item.file, *item.sentence, item.index, item.seconds,
+                    *item.labels);
+        }
+        if (!labeled.push(item))
+            discard(item);
+    }
+    labeled.close();
+}
+
+/**
+ * Write the labeled sentences until the labeling thread is done. Each file
+ * goes to a temporary file, renamed into place at its end, or to the
+ * current segment.
+ */
+void BatchPipeline::write() {
+    CompressedOutputStream *output = NULL;
+    ostream *out = NULL;
+    string text;
+    Item item;
+    while (labeled.pop(item)) {
+        if (failed) {
+            discard(item);
+            continue;
+        }
+        int file = item.file;
+        if (item.kind == BEGIN) {
+            if (segments != NULL) {
+                // Outputs are named as their files would be
+                const string &path = outfiles[file];
+                segments->open(path.substr(path.find_last_of('/') + 1));
+                out = &segments->stream();
+            } else {
+                output = new CompressedOutputStream(
+                        BatchJournal::partial(outfiles[file]), compress);
+                out = output;
+            }
+            stages.open(file, item.count, text);
+            out->write(text.data(), text.size());
+        } else if (item.kind == SENTENCE) {
+            stages.format(file, *item.sentence, item.index, *item.labels,
+                    text);
+            out->write(text.data(), text.size());
+            recycle(item);
+        } else {
+            bool ok = item.ok;
+            long long size = -1;
+            if (out != NULL) {
+                if (ok) {
+                    stages.close(file, text);
+                    out->write(text.data(), text.size());
+                }
+                bool written;
+                if (segments != NULL && !ok) {
+                    segments->cancel();
+                    written = false;
+                } else if (segments != NULL) {
+                    written = segments->close(size);
+                } else {
+                    output->close();
+                    written = ok && *output
+                            && BatchJournal::commit(outfiles[file]);
+                    delete output;
+                    output = NULL;
+                }
+                out = NULL;
+                if (ok && !written) {
+                    cerr << "Failed to write output file: " << outfiles[file]
+                            << endl;
+                    ok = false;
+                }
+            }
+            if (ok && segments != NULL) {
+                // Finished once the segment is committed
+                Pending pending;
+                pending.file = file;
+                pending.size = size;
+                pending.checksum = item.checksum;
+                waiting.push_back(pending);
+                if (segments->due())
+                    commitSegments();
+            } else {
+                // Files before a failed one are finished first
+                if (!ok)
+                    commitSegments();
+                stages.finished(file, ok, size, item.checksum);
+                stages.committed();
+                if (!ok)
+                    fail();
+            }
+        }
+    }
+    delete output;
+    commitSegments();
+}
+
+/**
+ * Commit the segment and finish the files waiting for it.
+ * 	@return False if the segment could not be committed.
+ */
+bool BatchPipeline::commitSegments() {
+    if (waiting.empty())
+        return true;
+    bool ok = segments->commit();
+    if (!ok)
+        cerr << "Failed to commit output segment!\n";
+    for (unsigned int i = 0; i < waiting.size(); i++)
+        stages.finished(waiting[i].file, ok, waiting[i].size,
+                waiting[i].checksum);
+    stages.committed();
+    waiting.clear();
+    if (!ok)
+        fail();
+    return ok;
+}
+
+/**
+ * Queue the start or end of a file.
+ * 	@return False if the run was stopped.
+ */
+bool BatchPipeline::push(Kind kind, int file, int count, bool ok,
+        uint32_t checksum) {
+    Item item;
+    item.kind = kind;
+    item.file = file;
+    item.index = -1;
+    item.count = count;
+    item.ok = ok;
+    item.sentence = NULL;
+    item.seconds = 0;
+    item.labels = NULL;
+    item.checksum = checksum;
+    return loaded.push(item);
+}
+
+/** Free the sentence and labels of an item. */
+void BatchPipeline::discard(Item &item) {
+    delete item.sentence;
+    delete item.labels;
+    item.sentence = NULL;
+    item.labels = NULL;
+}
+
+/**
+ * A sentence to load into: a spare one handed back by the writer, whose
+ * storage is reused, or a new one if there is none. The queues hold at most
+ * twice their capacity, so once they are full no more are allocated.
+ */
+Sentence *BatchPipeline::take() {
+    Sentence *sentence;
+    if (!spare.tryPop(sentence))
+        sentence = new Sentence();
+    return sentence;
+}
+
+/**
+ * Hand a formatted sentence back to the reader, or free it if enough are
+ * spare already. The labels are freed.
+ */
+void BatchPipeline::recycle(Item &item) {
+    if (spare.tryPush(item.sentence))
+        item.sentence = NULL;
+    discard(item);
+}
+
+/**
+ * Stop the run after a failure. The reader is turned away; the labeling
+ * and writer threads drop what is still queued.
+ */
+void BatchPipeline::fail() {
+    failed = true;
+    loaded.close();
+}
@@ -0,0 +1,719 @@
+/*
+ * CompressedStream.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "CompressedStream.h"
+#include "FileUtil.h"
+
+using namespace std;
+using namespace processors;
+
+/* Size of the blocks read, decoded and compressed at a time */
+static const size_t BLOCK_SIZE = 256 * 1024;
+
+/* Decoded blocks the decoder thread may run ahead of the reader */
+static const size_t READ_AHEAD = 4;
+
+/* Compression ratio assumed for annotations of unknown decompressed size */
+static const int TYPICAL_RATIO = 5;
+
+/**
+ * Read up to length bytes from a file descriptor.
+ * 	@return Number of bytes read, 0 at end of file, or -1 on error.
+ */
+static ssize_t readSome(int fd, char *data, size_t length) {
+    while (true) {
+        ssize_t n = read(fd, data, length);
+        if (n >= 0 || errno != EINTR)
+            return n;
+    }
+}
+
+/**
+ * Guess the compression of a file from its extension.
+ * 	@param filename Path to the file.
+ * 	@return COMPRESSION_GZIP for ".gz", COMPRESSION_ZSTD for ".zst", and
+ * 	COMPRESSION_NONE otherwise.
+ */
+Compression processors::compressionOf(const string &filename) {
+    string::size_type dot = filename.find_last_of("./");
+    if (dot == string::npos || filename[dot] != '.')
+        return COMPRESSION_NONE;
+    string extension = filename.substr(dot);
+    if (extension == ".gz")
+        return COMPRESSION_GZIP;
+    if (extension == ".zst")
+        return COMPRESSION_ZSTD;
+    return COMPRESSION_NONE;
+}
+
+/**
+ * File extension of a compression format.
+ * 	@param codec The format.
+ * 	@return ".gz", ".zst", or "" for COMPRESSION_NONE.
+ */
+const char *processors::compressionSuffix(Compression codec) {
+    switch (codec) {
+    case COMPRESSION_GZIP:
+        return ".gz";
+    case COMPRESSION_ZSTD:
+        return ".zst";
+    default:
+        return "";
+    }
+}
+
+/** True if this build can read and write the given format. */
+bool processors::compressionSupported(Compression codec) {
+#ifndef HAVE_ZSTD
+    if (codec == COMPRESSION_ZSTD)
+        return false;
+#endif
+    return true;
+}
+
+/**
+ * Estimate the size of a file once decompressed, without decompressing it.
+ * Gzip files record their size (modulo 4GB) in the trailer and zstd frames
+ * usually do in their header; otherwise a typical ratio is assumed.
+ * 	@param filename Path to the file; the format follows its extension.
+ * 	@return The estimate in bytes, or -1 if the file cannot be read.
+ */
+long long processors::uncompressedSize(const string &filename) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return -1;
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return -1;
+    }
+    long long size = info.st_size;
+    long long estimate = size * TYPICAL_RATIO;
+    unsigned char bytes[32];
+
+    switch (compressionOf(filename)) {
+    case COMPRESSION_NONE:
+        estimate = size;
+        break;
+    case COMPRESSION_GZIP:
+        // ISIZE: the last member's size modulo 4GB, little-endian
+        if (size >= 18 && pread(fd, bytes, 4, size - 4) == 4) {
+            long long isize = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16)
+                    | ((long long) bytes[3] << 24);
+            while (isize < size / 2)
+                isize += 1LL << 32;
+            estimate = isize;
+        }
+        break;
+    case COMPRESSION_ZSTD:
+#ifdef HAVE_ZSTD
+        {
+            ssize_t n = pread(fd, bytes, sizeof(bytes), 0);
+            unsigned long long content = (n > 0)
+                    ? ZSTD_getFrameContentSize(bytes, n)
+                    : ZSTD_CONTENTSIZE_UNKNOWN;
+            if (content != ZSTD_CONTENTSIZE_UNKNOWN
+                    && content != ZSTD_CONTENTSIZE_ERROR)
+                estimate = content;
+        }
+#endif
+        break;
+    }
+    close(fd);
+    return estimate;
+}
+
+/** Constructor. */
+DecompressingBuffer::DecompressingBuffer() :
+        fd(-1), codec(COMPRESSION_NONE), blocks(NULL), current(NULL),
+        currentStart(0), error(false), rawChecksum(0) {
+}
+
+/** Destructor. Stops the decoder thread and closes the file. */
+DecompressingBuffer::~DecompressingBuffer() {
+    close();
+}
+
+/**
+ * Open a file and start decoding it.
+ * 	@param filename Path to the file.
+ * 	@param codec Compression of the file.
+ * 	@return False if the file cannot be opened or the format is not
+ * 	supported by this build.
+ */
+bool DecompressingBuffer::open(const string &filename, Compression codec) {
+    close();
+    if (!compressionSupported(codec))
+        return false;
+    fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    this->codec = codec;
+    error = false;
+    currentStart = 0;
+    rawChecksum = 0;
+    blocks = new BlockingQueue<string *>(READ_AHEAD);
+    if (pthread_create(&thread, NULL, run, this) != 0) {
+        delete blocks;
+        blocks = NULL;
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Stop the decoder thread and close the file. The part of the file the
+ * decoder had not read yet is read into the checksum first.
+ */
+void DecompressingBuffer::close() {
+    if (fd < 0)
+        return;
+
+    // Closing the queue turns the decoder away if it is still running
+    blocks->close();
+    pthread_join(thread, NULL);
+
+    // Readers stop after the last sentence, and the decoder as soon as it
+    // is turned away, so the rest of the file has not been checksummed yet
+    vector<char> rest(BLOCK_SIZE);
+    while (readRaw(&rest[0], rest.size()) > 0) {
+    }
+    string *block;
+    while (blocks->pop(block))
+        delete block;
+    delete blocks;
+    blocks = NULL;
+    delete current;
+    current = NULL;
+    setg(NULL, NULL, NULL);
+
+    ::close(fd);
+    fd = -1;
+}
+
+/**
+ * Entry point of the decoder thread.
+ */
+void *DecompressingBuffer::run(void *self) {
+    DecompressingBuffer *buffer = (DecompressingBuffer *) self;
+    bool ok;
+    switch (buffer->codec) {
+    case COMPRESSION_GZIP:
+        ok = buffer->readGzip();
+        break;
+    case COMPRESSION_ZSTD:
+        ok = buffer->readZstd();
+        break;
+    default:
+        ok = buffer->readPlain();
+        break;
+    }
+    // The reader only looks at the flag after the queue runs dry
+    if (!ok)
+        buffer->error = true;
+    buffer->blocks->close();
+    return NULL;
+}
+
+/**
+ * Queue a decoded block and start a new one.
+ * 	@return False if the reader has gone away.
+ */
+bool DecompressingBuffer::emit(string *&block, size_t length) {
+    block->resize(length);
+    if (!blocks->push(block)) {
+        delete block;
+        block = NULL;
+        return false;
+    }
+    block = new string(BLOCK_SIZE, '\0');
+    return true;
+}
+
+/**
+ * Read the next bytes of the file, adding them to its checksum.
+ * 	@return Number of bytes read, 0 at end of file, or -1 on error.
+ */
+ssize_t DecompressingBuffer::readRaw(char *data, size_t length) {
+    ssize_t n = readSome(fd, data, length);
+    if (n > 0)
+        rawChecksum = bufferChecksum(data, n, rawChecksum);
+    return n;
+}
+
+/**
+ * Copy the raw file into blocks.
+ */
+bool DecompressingBuffer::readPlain() {
+    string *block = new string(BLOCK_SIZE, '\0');
+    ssize_t n;
+    while ((n = readRaw(&(*block)[0], BLOCK_SIZE)) > 0) {
+        if (!emit(block, n))
+            return true;
+    }
+    delete block;
+    return n == 0;
+}
+
+/**
+ * Decode gzip (or zlib) data, including concatenated members.
+ */
+bool DecompressingBuffer::readGzip() {
+    z_stream z;
+    memset(&z, 0, sizeof(z));
+    // 32 enables automatic detection of gzip and zlib headers
+    if (inflateInit2(&z, 15 + 32) != Z_OK)
+        return false;
+
+    vector<char> input(BLOCK_SIZE);
+    string *block = new string(BLOCK_SIZE, '\0');
+    size_t filled = 0;
+    bool ended = true, ok = true, full = false;
+    ssize_t n = 0;
+    while (ok && block != NULL
+            && (n = readRaw(&input[0], input.size())) > 0) {
+        z.next_in = (Bytef *) &input[0];
+        z.avail_in = n;
+        // Keep going while there is input, or output still held back
+        while (ok && (z.avail_in > 0 || full)) {
+            if (ended) {
+                // Another member follows the previous one
+                inflateReset(&z);
+                ended = false;
+            }
+            z.next_out = (Bytef *) &(*block)[filled];
+            z.avail_out = BLOCK_SIZE - filled;
+            int ret = inflate(&z, Z_NO_FLUSH);
+            filled = BLOCK_SIZE - z.avail_out;
+            full = (filled == BLOCK_SIZE);
+            if (ret == Z_STREAM_END)
+                ended = true;
+            else if (ret != Z_OK && ret != Z_BUF_ERROR)
+                ok = false;
+            if (full && !emit(block, filled))
+                break;
+            if (full)
+                filled = 0;
+            if (ended && z.avail_in == 0)
+                full = false;
+        }
+    }
+    inflateEnd(&z);
+    if (block == NULL)
+        return true;
+
+    // A member cut short means the file is truncated
+    ok = ok && n == 0 && ended;
+    if (ok && filled > 0 && !emit(block, filled))
+        return true;
+    delete block;
+    return ok;
+}
+
+/**
+ * Decode zstd frames.
+ */
+bool DecompressingBuffer::readZstd() {
+#ifdef HAVE_ZSTD
+    ZSTD_DStream *z = ZSTD_createDStream();
+    if (z == NULL)
+        return false;
+    ZSTD_initDStream(z);
+
+    vector<char> input(BLOCK_SIZE);
+    string *block = new string(BLOCK_SIZE, '\0');
+    size_t filled = 0, pending = 0;
+    bool ok = true, full = false;
+    ssize_t n = 0;
+    while (ok && block != NULL
+            && (n = readRaw(&input[0], input.size())) > 0) {
+        ZSTD_inBuffer in = { &input[0], (size_t) n, 0 };
+        while (ok && (in.pos < in.size || full)) {
+            ZSTD_outBuffer out = { &(*block)[0], BLOCK_SIZE, filled };
+            pending = ZSTD_decompressStream(z, &out, &in);
+            if (ZSTD_isError(pending))
+                ok = false;
+            filled = out.pos;
+            full = (filled == BLOCK_SIZE);
+            if (full && !emit(block, filled))
+                break;
+            if (full)
+                filled = 0;
+        }
+    }
+    ZSTD_freeDStream(z);
+    if (block == NULL)
+        return true;
+
+    // A frame cut short means the file is truncated
+    ok = ok && n == 0 && pending == 0;
+    if (ok && filled > 0 && !emit(block, filled))
+        return true;
+    delete block;
+    return ok;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Move on to the next decoded block.
+ */
+DecompressingBuffer::int_type DecompressingBuffer::underflow() {
+    if (gptr() < egptr())
+        return traits_type::to_int_type(*gptr());
+    if (blocks == NULL)
+        return traits_type::eof();
+
+    if (current != NULL) {
+        currentStart += current->size();
+        delete current;
+        current = NULL;
+    }
+    setg(NULL, NULL, NULL);
+    if (!blocks->pop(current)) {
+        current = NULL;
+        return traits_type::eof();
+    }
+    char *begin = &(*current)[0];
+    setg(begin, begin, begin + current->size());
+    return traits_type::to_int_type(*gptr());
+}
+
+/**
+ * Report the position, or seek within the current block.
+ */
+DecompressingBuffer::pos_type DecompressingBuffer::seekoff(off_type off,
+        ios_base::seekdir dir, ios_base::openmode which) {
+    if (!(which & ios_base::in))
+        return pos_type(off_type(-1));
+    long long position = currentStart + (gptr() - eback());
+    if (dir == ios_base::cur)
+        return (off == 0) ? pos_type(position) : seekpos(position + off, which);
+    if (dir == ios_base::beg)
+        return seekpos(off, which);
+    return pos_type(off_type(-1));
+}
+
+/**
+ * Seek within the current block.
+ */
+DecompressingBuffer::pos_type DecompressingBuffer::seekpos(pos_type pos,
+        ios_base::openmode which) {
+    long long target = (off_type) pos;
+    if (!(which & ios_base::in) || current == NULL || target < currentStart
+            || target > currentStart + (long long) current->size())
+        return pos_type(off_type(-1));
+    setg(eback(), eback() + (target - currentStart), egptr());
+    return pos;
+}
+
+/** Constructor. */
+CompressingBuffer::CompressingBuffer() :
+        fd(-1), owned(true), codec(COMPRESSION_NONE), state(NULL),
+        error(false) {
+}
+
+/** Destructor. Closes the file. */
+CompressingBuffer::~CompressingBuffer() {
+    close();
+}
+
+/**
+ * Create (or truncate) a file for writing.
+ * 	@param filename Path to the file.
+ * 	@param codec Compression to apply.
+ * 	@param level Compression level; -1 for the format's default.
+ * 	@return False if the file cannot be created or the format is not
+ * 	supported by this build.
+ */
+bool CompressingBuffer::open(const string &filename, Compression codec,
+        int level) {
+    close();
+    if (!compressionSupported(codec))
+        return false;
+    int file = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (file < 0)
+        return false;
+    if (!start(file, codec, level)) {
+        ::close(file);
+        return false;
+    }
+    owned = true;
+    return true;
+}
+
+/**
+ * Write to a file that is already open, from its current position. The
+ * descriptor is left open by close().
+ * 	@param file An open file descriptor.
+ * 	@param codec Compression to apply.
+ * 	@param level Compression level; -1 for the format's default.
+ * 	@return False if the format is not supported by this build.
+ */
+bool CompressingBuffer::open(int file, Compression codec, int level) {
+    close();
+    if (!compressionSupported(codec) || !start(file, codec, level))
+        return false;
+    owned = false;
+    return true;
+}
+
+/**
+ * Set up the compressor for a descriptor.
+ * 	@return False if the compressor could not be initialized.
+ */
+bool CompressingBuffer::start(int file, Compression codec, int level) {
+    fd = file;
+    this->codec = codec;
+    error = false;
+    if (codec == COMPRESSION_GZIP) {
+        z_stream *z = new z_stream;
+        memset(z, 0, sizeof(*z));
+        // 16 asks for a gzip header and trailer
+        if (deflateInit2(z, (level < 0) ? Z_DEFAULT_COMPRESSION : level,
+                Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            delete z;
+            error = true;
+        } else {
+            state = z;
+        }
+    }
+#ifdef HAVE_ZSTD
+    if (codec == COMPRESSION_ZSTD) {
+        ZSTD_CStream *z = ZSTD_createCStream();
+        if (z == NULL || ZSTD_isError(ZSTD_initCStream(z,
+                (level < 0) ? ZSTD_CLEVEL_DEFAULT : level))) {
+            ZSTD_freeCStream(z);
+            error = true;
+        } else {
+            state = z;
+        }
+    }
+#endif
+    if (error) {
+        fd = -1;
+        return false;
+    }
+
+    input.resize(BLOCK_SIZE);
+    output.resize(BLOCK_SIZE);
+    setp(&input[0], &input[0] + input.size());
+    return true;
+}
+
+/**
+ * Finish the compressed stream and close the file.
+ * 	@return False if anything could not be written.
+ */
+bool CompressingBuffer::close() {
+    if (fd < 0)
+        return true;
+
+    compress(true);
+    if (codec == COMPRESSION_GZIP) {
+        deflateEnd((z_stream *) state);
+        delete (z_stream *) state;
+    }
+#ifdef HAVE_ZSTD
+    if (codec == COMPRESSION_ZSTD)
+        ZSTD_freeCStream((ZSTD_CStream *) state);
+#endif
+    state = NULL;
+    setp(NULL, NULL);
+
+    if (owned && ::close(fd) != 0)
+        error = true;
+    fd = -1;
+    return !error;
+}
+
+/**
+ * Compress the full buffer and make room for more.
+ */
+CompressingBuffer::int_type CompressingBuffer::overflow(int_type c) {
+    if (fd < 0 || !compress(false))
+        return traits_type::eof();
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+/**
+ * Hand the buffered text to the compressor.
+ */
+int CompressingBuffer::sync() {
+    if (fd < 0)
+        return 0;
+    return compress(false) ? 0 : -1;
+}
+
+/**
+ * Compress and write out the buffered text.
+ * 	@param finish Also end the compressed stream.
+ */
+bool CompressingBuffer::compress(bool finish) {
+    char *data = pbase();
+    size_t length = pptr() - pbase();
+    setp(&input[0], &input[0] + input.size());
+    if (error)
+        return false;
+
+    if (codec == COMPRESSION_GZIP) {
+        z_stream *z = (z_stream *) state;
+        z->next_in = (Bytef *) data;
+        z->avail_in = length;
+        int ret;
+        do {
+            z->next_out = (Bytef *) &output[0];
+            z->avail_out = output.size();
+            ret = deflate(z, finish ? Z_FINISH : Z_NO_FLUSH);
+            if (ret == Z_STREAM_ERROR
+                    || !writeAll(fd, &output[0],
+                            output.size() - z->avail_out)) {
+                error = true;
+                break;
+            }
+        } while (z->avail_out == 0 || (finish && ret != Z_STREAM_END));
+#ifdef HAVE_ZSTD
+    } else if (codec == COMPRESSION_ZSTD) {
+        ZSTD_CStream *z = (ZSTD_CStream *) state;
+        ZSTD_inBuffer in = { data, length, 0 };
+        while (!error && in.pos < in.size) {
+            ZSTD_outBuffer out = { &output[0], output.size(), 0 };
+            if (ZSTD_isError(ZSTD_compressStream(z, &out, &in))
+                    || !writeAll(fd, &output[0], out.pos))
+                error = true;
+        }
+        size_t remaining = finish ? 1 : 0;
+        while (!error && remaining > 0) {
+            ZSTD_outBuffer out = { &output[0], output.size(), 0 };
+            remaining = ZSTD_endStream(z, &out);
+            if (ZSTD_isError(remaining)
+                    || !writeAll(fd, &output[0], out.pos))
+                error = true;
+        }
+#endif
+    } else if (!writeAll(fd, data, length)) {
+        error = true;
+    }
+    return !error;
+}
+
+/** Constructor. */
+CompressedInputStream::CompressedInputStream() : istream(NULL) {
+    rdbuf(&buffer);
+}
+
+/**
+ * Constructor. Opens the file; check is_open() for success.
+ * 	@param filename Path to the file.
+ * 	@param codec Compression of the file.
+ */
+CompressedInputStream::CompressedInputStream(const string &filename,
+        Compression codec) : istream(NULL) {
+    rdbuf(&buffer);
+    open(filename, codec);
+}
+
+/** Constructor. Opens the file, guessing its compression. */
+CompressedInputStream::CompressedInputStream(const string &filename) :
+        istream(NULL) {
+    rdbuf(&buffer);
+    open(filename, compressionOf(filename));
+}
+
+/**
+ * Open a file.
+ * 	@param filename Path to the file.
+ * 	@param codec Compression of the file.
+ */
+void CompressedInputStream::open(const string &filename, Compression codec) {
+    if (buffer.open(filename, codec))
+        clear();
+    else
+        setstate(ios_base::failbit);
+}
+
+/**
+ * Close the file. Sets the failbit if the data turned out to be corrupt or
+ * truncated.
+ */
+void CompressedInputStream::close() {
+    buffer.close();
+    if (buffer.failed())
+        setstate(ios_base::failbit);
+}
+
+/** Constructor. */
+CompressedOutputStream::CompressedOutputStream() : ostream(NULL) {
+    rdbuf(&buffer);
+}
+
+/**
+ * Constructor. Creates the file; check is_open() for success.
+ * 	@param filename Path to the file.
+ * 	@param codec Compression to apply.
+ */
+CompressedOutputStream::CompressedOutputStream(const string &filename,
+        Compression codec) : ostream(NULL) {
+    rdbuf(&buffer);
+    open(filename, codec);
+}
+
+/**
+ * Create (or truncate) a file.
+ * 	@param filename Path to the file.
+ * 	@param codec Compression to apply.
+ * 	@param level Compression level; -1 for the format's default.
+ */
+void CompressedOutputStream::open(const string &filename, Compression codec,
+        int level) {
+    if (buffer.open(filename, codec, level))
+        clear();
+    else
+        setstate(ios_base::failbit);
+}
+
+/**
+ * Write to a file that is already open, from its current position; the
+ * descriptor is left open by close().
+ * 	@param fd An open file descriptor.
+ * 	@param codec Compression to apply.
+ * 	@param level Compression level; -1 for the format's default.
+ */
+void CompressedOutputStream::open(int fd, Compression codec, int level) {
+    if (buffer.open(fd, codec, level))
+        clear();
+    else
+        setstate(ios_base::failbit);
+}
+
+/**
+ * Finish and close the file. Sets the failbit if anything could not be
+ * written.
+ */
+void CompressedOutputStream::close() {
+    if (!buffer.close())
+        setstate(ios_base::failbit);
+}
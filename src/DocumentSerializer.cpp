@@ -5,10 +5,16 @@
  *      Author: trananh
  */
 
+#include <algorithm>
+#include <iterator>
 #include <sstream>
 #include <assert.h>
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
 
 #include "DocumentSerializer.h"
+#include "SentenceReader.h"
 
 using namespace std;
 using namespace processors;
@@ -21,43 +27,760 @@ const string DocumentSerializer::START_TOKENS = "T";
 const string DocumentSerializer::START_COREF = "C";
 const string DocumentSerializer::START_DEPENDENCIES = "D";
 const string DocumentSerializer::START_CONSTITUENTS = "Y";
+const string DocumentSerializer::START_ROLES = "R";
 const string DocumentSerializer::END_OF_SENTENCE = "EOS";
 const string DocumentSerializer::END_OF_DOCUMENT = "EOD";
 const string DocumentSerializer::END_OF_DEPENDENCIES = "EOX";
 
+/*
+ * Binary format (all integers are unsigned LEB128 varints):
+ *   magic, version byte
+ *   dictionary size, then each entry as length + bytes
+ *   sentence count, then for each sentence:
+ *     token count, one byte with a bit set for every all-NIL column
+ *     word ids
+ *     per token: zigzag(start - previous end), zigzag(end - start)
+ *     label ids for each column that is not NIL, in column order
+ *     unless the tree bit is set (version 2 and up): node count, then per
+ *     node in pre-order: value id, head, start, end - start, children
+ *     unless the roles bit is set (version 3 and up): predicate count, then
+ *     per predicate: token, lemma id, argument count, and per argument:
+ *     label id, start, end - start
+ */
+const string DocumentSerializer::BINARY_MAGIC = "SWDB";
+const unsigned char DocumentSerializer::BINARY_VERSION = 3;
+
+/* Number of fields of a token line, and the Column each belongs to */
+static const size_t TOKEN_FIELDS = 8;
+static const unsigned int FIELD_COLUMNS[TOKEN_FIELDS] = {
+    DocumentSerializer::COLUMN_WORDS, DocumentSerializer::COLUMN_OFFSETS,
+    DocumentSerializer::COLUMN_OFFSETS, DocumentSerializer::COLUMN_TAGS,
+    DocumentSerializer::COLUMN_LEMMAS, DocumentSerializer::COLUMN_ENTITIES,
+    DocumentSerializer::COLUMN_NORMS, DocumentSerializer::COLUMN_CHUNKS
+};
+
+/* Bits of the per-sentence NIL column bitmap */
+static const unsigned char NIL_TAGS = 1;
+static const unsigned char NIL_LEMMAS = 2;
+static const unsigned char NIL_ENTITIES = 4;
+static const unsigned char NIL_NORMS = 8;
+static const unsigned char NIL_CHUNKS = 16;
+static const unsigned char NIL_TREE = 32;
+static const unsigned char NIL_ROLES = 64;
+
+/**
+ * Append an unsigned varint.
+ */
+static void putVarint(string &out, unsigned int value) {
+    while (value >= 0x80) {
+        out += (char) (value | 0x80);
+        value >>= 7;
+    }
+    out += (char) value;
+}
+
+/**
+ * Append a signed value as a zigzag varint.
+ */
+static void putSigned(string &out, int value) {
+    putVarint(out, ((unsigned int) value << 1) ^ (unsigned int) (value >> 31));
+}
+
+/**
+ * Reads the values of a document in the binary format. Reading past the
+ * end of the bytes, a varint longer than five bytes, an id outside the
+ * dictionary or a count larger than the bytes left mark the cursor as
+ * failed and yield 0, so that the decoder stays in bounds and only has to
+ * check for failure once per block.
+ */
+class BinaryCursor {
+
+public:
+
+    BinaryCursor(const char *begin, const char *end) :
+            p(begin), end(end), failed(false) {
+    }
+
+    /** Read a byte. */
+    unsigned char byte() {
+        if (p >= end)
+            return fail();
+        return (unsigned char) *p++;
+    }
+
+    /** Read an unsigned varint. */
+    unsigned int varint() {
+        unsigned int value = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            if (p >= end)
+                return fail();
+            unsigned char byte = *p++;
+            value |= (unsigned int) (byte & 0x7f) << shift;
+            if (byte < 0x80)
+                return value;
+        }
+        return fail();
+    }
+
+    /** Read a zigzag varint. */
+    int zigzag() {
+        unsigned int value = varint();
+        return (int) (value >> 1) ^ -(int) (value & 1);
+    }
+
+    /**
+     * Read the number of items that follow.
+     * 	@param bytes Fewest bytes an item takes, to bound the count by
+     * 	what is left to read.
+     */
+    unsigned int count(unsigned int bytes) {
+        unsigned int value = varint();
+        if (value > (size_t) (end - p) / bytes)
+            return fail();
+        return value;
+    }
+
+    /**
+     * Read a dictionary id. Check bad() before using it: a failed read
+     * yields 0, which is not an id of an empty dictionary.
+     * 	@param size Number of dictionary entries.
+     */
+    unsigned int id(size_t size) {
+        unsigned int value = varint();
+        if (value >= size)
+            return fail();
+        return value;
+    }
+
+    /**
+     * Read a dictionary id and get its entry.
+     * 	@return The entry, or an empty one if the id is not valid.
+     */
+    StringRef entry(const vector<StringRef> &dictionary) {
+        unsigned int value = varint();
+        if (value >= dictionary.size()) {
+            fail();
+            return StringRef();
+        }
+        return dictionary[value];
+    }
+
+    /**
+     * Take a run of bytes.
+     * 	@param length Number of bytes.
+     * 	@return The bytes, or an empty run past the end.
+     */
+    StringRef take(unsigned int length) {
+        if (length > (size_t) (end - p)) {
+            fail();
+            return StringRef();
+        }
+        StringRef bytes(p, length);
+        p += length;
+        return bytes;
+    }
+
+    /** True once anything could not be read. */
+    bool bad() const {
+        return failed;
+    }
+
+private:
+
+    /** Mark the cursor as failed and stop at the end. */
+    unsigned int fail() {
+        failed = true;
+        p = end;
+        return 0;
+    }
+
+    const char *p;
+    const char *end;
+    bool failed;
+
+};
+
+/**
+ * Append the dictionary ids of a column of strings.
+ */
+static void putColumn(string &out, SymbolTable &dictionary,
+        const StringColumn &column) {
+    for (unsigned int i = 0; i < column.size(); i++)
+        putVarint(out, dictionary.intern(column[i].data, column[i].length));
+}
+
+/**
+ * Append the dictionary ids of a column of interned labels.
+ */
+static void putColumn(string &out, SymbolTable &dictionary,
+        const vector<Symbol> &column, const SymbolTable &labels) {
+    for (unsigned int i = 0; i < column.size(); i++)
+        putVarint(out, dictionary.intern(labels.name(column[i])));
+}
+
+/**
+ * True if a line holds a marker and nothing else (but separators).
+ */
+static bool isMarker(const StringRef &line, const string &marker) {
+    if (line.length < marker.size()
+            || memcmp(line.data, marker.data(), marker.size()) != 0)
+        return false;
+    for (size_t i = marker.size(); i < line.length; i++) {
+        if (line.data[i] != DocumentSerializer::SEP)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Read a column of strings from their dictionary ids. The ids are read
+ * twice, first to size the arena of the column.
+ * 	@param count Number of strings; 0 for a missing column.
+ */
+static void getColumn(BinaryCursor &in, const vector<StringRef> &dictionary,
+        unsigned int count, StringColumn &column) {
+    BinaryCursor start = in;
+    size_t length = 0;
+    for (unsigned int i = 0; i < count; i++)
+        length += in.entry(dictionary).length;
+    column.clear();
+    if (in.bad())
+        return;
+    in = start;
+    column.reserve(count, length);
+    for (unsigned int i = 0; i < count; i++)
+        column.push_back(in.entry(dictionary));
+}
+
+/**
+ * Read a column of labels from their dictionary ids, interning each
+ * dictionary entry at most once.
+ */
+static void getColumn(BinaryCursor &in, const vector<StringRef> &dictionary,
+        SymbolTable &labels, vector<int> &symbols, vector<Symbol> &column) {
+    for (unsigned int i = 0; i < column.size(); i++) {
+        unsigned int id = in.id(dictionary.size());
+        if (in.bad())
+            return;
+        if (symbols[id] < 0)
+            symbols[id] = labels.intern(dictionary[id].data,
+                    dictionary[id].length);
+        column[i] = symbols[id];
+    }
+}
+
+/**
+ * True if the nodes of a tree, in pre-order with their child counts, form
+ * exactly one tree.
+ */
+static bool wellFormed(const vector<SyntacticTree::Node> &nodes) {
+    size_t pending = 1;
+    for (unsigned int i = 0; i < nodes.size(); i++) {
+        if (pending == 0 || nodes[i].children < 0
+                || (size_t) nodes[i].children > nodes.size())
+            return false;
+        pending += nodes[i].children - 1;
+    }
+    return nodes.empty() || pending == 0;
+}
+
+/**
+ * Parse a count or offset that must be a plain non-negative number.
+ * 	@param field The field.
+ * 	@param value Set to the number.
+ * 	@return False if the field is empty, has other characters, or is too
+ * 	large for an int.
+ */
+static bool parseCount(const StringRef &field, int &value) {
+    if (field.length == 0 || field.length > 9)
+        return false;
+    for (size_t i = 0; i < field.length; i++) {
+        if (field.data[i] < '0' || field.data[i] > '9')
+            return false;
+    }
+    value = parseInt(field);
+    return true;
+}
+
+/* Smallest part of a file worth a thread of its own */
+static const size_t MIN_CHUNK = 1 << 20;
+
+/* Chunks per thread, so that threads that finish early can take more */
+static const int CHUNKS_PER_THREAD = 4;
+
+/**
+ * Find the end of the next sentence: the byte past the next EOS line that
+ * follows a newline, at or after a position. As in loadSentence, a line
+ * ends a sentence if its first field is EOS, whatever fields follow.
+ * 	@param from Where to start looking.
+ * 	@param end One past the end of the text.
+ * 	@param marker A newline followed by the EOS marker.
+ * 	@return The end of the sentence, or NULL if there is none.
+ */
+static const char *nextSentenceEnd(const char *from, const char *end,
+        const string &marker) {
+    while (from < end) {
+        const char *found = (const char *) memmem(from, end - from,
+                marker.data(), marker.size());
+        if (found == NULL)
+            return NULL;
+        const char *after = found + marker.size();
+        if (after == end)
+            return end;
+        if (*after == '\n')
+            return after + 1;
+        if (*after == DocumentSerializer::SEP) {
+            const char *newline = (const char *) memchr(after, '\n',
+                    end - after);
+            return (newline == NULL) ? end : newline + 1;
+        }
+        from = after;
+    }
+    return NULL;
+}
+
+/** A part of a document, parsed by one thread. */
+struct LoadChunk {
+    const char *begin;  /* The "T" line of its first sentence */
+    const char *end;
+    int count;          /* Number of sentences */
+    int first;          /* Position of its first sentence in the document */
+};
+
+/** State shared by the threads of a parallel load. */
+struct ParallelLoad {
+    vector<LoadChunk> chunks;
+    Document *doc;
+    string marker;
+    bool counting;      /* First pass: count sentences; second: parse them */
+    size_t next;        /* Next chunk to take */
+    pthread_mutex_t lock;
+};
+
+/**
+ * Take chunks of a parallel load until there are none left, and count or
+ * parse their sentences. Each chunk has its own reader (and label caches).
+ */
+static void *loadChunks(void *argument) {
+    ParallelLoad &load = *(ParallelLoad *) argument;
+    while (true) {
+        pthread_mutex_lock(&load.lock);
+        size_t i = load.next++;
+        pthread_mutex_unlock(&load.lock);
+        if (i >= load.chunks.size())
+            return NULL;
+
+        LoadChunk &chunk = load.chunks[i];
+        if (load.counting) {
+            const char *cursor = chunk.begin;
+            chunk.count = 0;
+            while ((cursor = nextSentenceEnd(cursor, chunk.end, load.marker))
+                    != NULL)
+                chunk.count++;
+        } else {
+            SentenceReader reader(chunk.begin, chunk.end, chunk.count,
+                    chunk.first);
+            for (int j = 0; j < chunk.count; j++)
+                reader.next(load.doc->sentences[chunk.first + j]);
+        }
+    }
+}
+
+/**
+ * Run a pass of a parallel load on this thread and up to threads - 1 more.
+ */
+static void runLoad(ParallelLoad &load, int threads) {
+    load.next = 0;
+    vector<pthread_t> helpers(threads - 1);
+    int started = 0;
+    while (started < (int) helpers.size() && pthread_create(&helpers[started],
+            NULL, loadChunks, &load) == 0)
+        started++;
+    loadChunks(&load);
+    for (int i = 0; i < started; i++)
+        pthread_join(helpers[i], NULL);
+}
+
 /**
  * Load the NLP annotation from an input stream (file or stringstream).
  * 	@param stream The input stream.
+ * 	@param doc Overwritten with the document.
+ */
+void DocumentSerializer::load(istream &stream, Document &doc) {
+    SentenceReader reader(stream);
+    load(reader, doc);
+}
+
+/**
+ * Load the NLP annotation from a memory-mapped file.
+ * 	@param file The mapped file.
+ * 	@param doc Overwritten with the document.
+ */
+void DocumentSerializer::load(const MappedFile &file, Document &doc) {
+    SentenceReader reader(file);
+    load(reader, doc);
+}
+
+/**
+ * Load the NLP annotation from a memory-mapped file on several threads. The
+ * file is cut into chunks after the first EOS line past evenly spaced
+ * offsets. The sentences of each chunk are counted in parallel, which places
+ * every chunk in the document, and then parsed in parallel straight into
+ * their slots. Files too small to split are loaded serially.
+ * 	@param file The mapped file.
+ * 	@param threads Number of threads; 0 for one per online CPU.
+ * 	@param doc Overwritten with the document.
+ */
+void DocumentSerializer::load(const MappedFile &file, int threads,
+        Document &doc) {
+    if (threads <= 0)
+        threads = max((int) sysconf(_SC_NPROCESSORS_ONLN), 1);
+    size_t chunkCount = min((size_t) threads * CHUNKS_PER_THREAD,
+            file.size() / MIN_CHUNK);
+    if (threads == 1 || chunkCount <= 1) {
+        load(file, doc);
+        return;
+    }
+
+    // Document header
+    const char *begin = file.begin();
+    const char *end = file.end();
+    const char *body = (const char *) memchr(begin, '\n', end - begin);
+    body = (body == NULL) ? end : body + 1;
+    vector<StringRef> fields;
+    TextScanner header(begin, body, SEP);
+    header.nextFields(fields);
+    assert(fields.size() >= 2 && fields.at(0).equals(START_SENTENCES));
+    int declared = parseInt(fields.at(1));
+
+    ParallelLoad load;
+    load.marker = "\n" + END_OF_SENTENCE;
+    const char *start = body;
+    size_t stride = (end - start) / chunkCount;
+    for (size_t i = 1; i <= chunkCount && body < end; i++) {
+        const char *cut = end;
+        if (i < chunkCount) {
+            cut = nextSentenceEnd(max(body, start + i * stride) - 1, end,
+                    load.marker);
+            if (cut == NULL)
+                cut = end;
+        }
+        LoadChunk chunk = { body, cut, 0, 0 };
+        load.chunks.push_back(chunk);
+        body = cut;
+    }
+    pthread_mutex_init(&load.lock, NULL);
+
+    // Place the chunks; like the serial loader, read no more sentences than
+    // the header declares
+    load.counting = true;
+    runLoad(load, threads);
+    int total = 0;
+    for (unsigned int i = 0; i < load.chunks.size(); i++) {
+        load.chunks[i].first = total;
+        load.chunks[i].count = max(min(load.chunks[i].count,
+                declared - total), 0);
+        total += load.chunks[i].count;
+    }
+
+    doc.sentences.resize(total);
+    load.doc = &doc;
+    load.counting = false;
+    runLoad(load, threads);
+    pthread_mutex_destroy(&load.lock);
+}
+
+/**
+ * Collect all remaining sentences from a reader into a Document. Sentences
+ * are added as they are read: the count in the header is not trusted to
+ * size the document, so a file that declares more sentences than it holds
+ * costs no more memory than its contents.
+ * 	@param reader The sentence reader.
+ * 	@param doc Overwritten with the sentences.
  */
-Document DocumentSerializer::load(istream &stream) {
-    // First line from the stream should be start of sentences
-    string line;
-    getline(stream, line);
-    vector<string> tokens = tokenize(line);
-    assert(tokens.at(0).compare(START_SENTENCES) == 0);
-    int sentCount = atoi(tokens.at(1).c_str());
-    vector<Sentence> sentences;
-    int offset = 0;
-    while (offset < sentCount) {
-        sentences.push_back(loadSentence(stream));
-        offset += 1;
+void DocumentSerializer::load(SentenceReader &reader, Document &doc) {
+    // Sentences already in the document are loaded over
+    size_t count = 0;
+    while ((int) count < reader.size()) {
+        if (count == doc.sentences.size())
+            doc.sentences.append();
+        if (!reader.next(doc.sentences[count]))
+            break;
+        count++;
     }
-    Document doc(sentences);
-    return doc;
+    doc.sentences.resize(count);
 }
 
 /**
  * Print the NLP annotation to an output stream (file or string).
  * 	@param doc The annotated document.
  * 	@param out The output stream.
- * 	@return The output stream.
  */
-void DocumentSerializer::save(Document doc, ostream &out) {
-    out << START_SENTENCES << SEP << doc.sentences.size() << endl;
-    for (int i = 0; i < (int) doc.sentences.size(); i++) {
-        saveSentence(doc.sentences.at(i), out);
+void DocumentSerializer::save(const Document &doc, ostream &out) {
+    StreamSink sink(out);
+    save(doc, sink);
+}
+
+/**
+ * Print the NLP annotation to an output sink. The text is formatted into a
+ * large buffer and handed to the sink in blocks; nothing is copied per
+ * sentence or flushed per line.
+ * 	@param doc The annotated document.
+ * 	@param out The output sink.
+ * 	@return False if the sink reported an error.
+ */
+bool DocumentSerializer::save(const Document &doc, OutputSink &out) {
+    BufferedWriter writer(out);
+    writer.write(START_SENTENCES);
+    writer.put(SEP);
+    writer.writeInt(doc.sentences.size());
+    writer.put('\n');
+    for (unsigned int i = 0; i < doc.sentences.size(); i++) {
+        saveSentence(doc.sentences[i], writer);
     }
-    out << END_OF_DOCUMENT << endl;
+    writer.write(END_OF_DOCUMENT);
+    writer.put('\n');
+    return writer.flush();
+}
+
+/**
+ * Load the NLP annotation from a stream in the binary format.
+ * 	@param stream The input stream.
+ * 	@param doc Overwritten with the document.
+ * 	@return False if the stream does not hold a valid binary document.
+ */
+bool DocumentSerializer::loadBinary(istream &stream, Document &doc) {
+    string data((istreambuf_iterator<char>(stream)),
+            istreambuf_iterator<char>());
+    return loadBinary(data.data(), data.data() + data.size(), doc);
+}
+
+/**
+ * Load the NLP annotation from a memory-mapped file in the binary format.
+ * 	@param file The mapped file.
+ * 	@param doc Overwritten with the document.
+ * 	@return False if the file does not hold a valid binary document.
+ */
+bool DocumentSerializer::loadBinary(const MappedFile &file, Document &doc) {
+    return loadBinary(file.begin(), file.end(), doc);
+}
+
+/**
+ * Decode a document in the binary format. The input is not trusted: every
+ * count, id and length is checked against the bytes that are left, and a
+ * truncated or corrupt document is rejected rather than read out of bounds.
+ * 	@param begin Start of the encoded bytes.
+ * 	@param end One past the end of the encoded bytes.
+ * 	@param doc Overwritten with the document; left empty on failure.
+ * 	@return False if the bytes are not a valid binary document.
+ */
+bool DocumentSerializer::loadBinary(const char *begin, const char *end,
+        Document &doc) {
+    doc.sentences.clear();
+    if (end - begin <= (long) BINARY_MAGIC.size()
+            || !StringRef(begin, BINARY_MAGIC.size()).equals(BINARY_MAGIC))
+        return false;
+    BinaryCursor in(begin + BINARY_MAGIC.size(), end);
+    unsigned char version = in.byte();
+    if (version < 1 || version > BINARY_VERSION)
+        return false;
+
+    // Dictionary entries are views into the encoded bytes
+    vector<StringRef> dictionary(in.count(1));
+    for (unsigned int i = 0; i < dictionary.size(); i++)
+        dictionary[i] = in.take(in.varint());
+    if (in.bad())
+        return false;
+    vector<int> tagSymbols(dictionary.size(), -1);
+    vector<int> entitySymbols(dictionary.size(), -1);
+    vector<int> chunkSymbols(dictionary.size(), -1);
+    vector<int> roleSymbols(dictionary.size(), -1);
+
+    // Sizes are bounded by the bytes that are left: at least two per
+    // sentence, three per token, five per tree node, three per predicate
+    // and three per argument
+    doc.sentences.resize(in.count(2));
+    bool valid = true;
+    for (unsigned int s = 0; s < doc.sentences.size() && valid; s++) {
+        Sentence &sentence = doc.sentences[s];
+        unsigned int tokenCount = in.count(3);
+        unsigned char nils = in.byte();
+        if (version < 2)
+            nils |= NIL_TREE;
+        if (version < 3)
+            nils |= NIL_ROLES;
+
+        getColumn(in, dictionary, tokenCount, sentence.words);
+
+        sentence.startOffsets.resize(tokenCount);
+        sentence.endOffsets.resize(tokenCount);
+        int previous = 0;
+        for (unsigned int i = 0; i < tokenCount; i++) {
+            sentence.startOffsets[i] = previous + in.zigzag();
+            sentence.endOffsets[i] = sentence.startOffsets[i] + in.zigzag();
+            previous = sentence.endOffsets[i];
+        }
+
+        sentence.tags.resize((nils & NIL_TAGS) ? 0 : tokenCount);
+        getColumn(in, dictionary, SymbolTable::tags(), tagSymbols,
+                sentence.tags);
+        getColumn(in, dictionary, (nils & NIL_LEMMAS) ? 0 : tokenCount,
+                sentence.lemmas);
+        sentence.entities.resize((nils & NIL_ENTITIES) ? 0 : tokenCount);
+        getColumn(in, dictionary, SymbolTable::entities(), entitySymbols,
+                sentence.entities);
+        getColumn(in, dictionary, (nils & NIL_NORMS) ? 0 : tokenCount,
+                sentence.norms);
+        sentence.chunks.resize((nils & NIL_CHUNKS) ? 0 : tokenCount);
+        getColumn(in, dictionary, SymbolTable::chunks(), chunkSymbols,
+                sentence.chunks);
+
+        if (!(nils & NIL_TREE)) {
+            vector<SyntacticTree::Node> &nodes = sentence.syntacticTree.nodes;
+            nodes.resize(in.count(5));
+            for (unsigned int i = 0; i < nodes.size(); i++) {
+                StringRef value = in.entry(dictionary);
+                nodes[i].value.assign(value.data, value.length);
+                nodes[i].head = in.zigzag();
+                nodes[i].startOffset = in.zigzag();
+                nodes[i].endOffset = nodes[i].startOffset + in.zigzag();
+                nodes[i].children = in.varint();
+            }
+            if (!wellFormed(nodes))
+                valid = false;
+        }
+
+        if (!(nils & NIL_ROLES)) {
+            vector<SrlPredicate> &predicates = sentence.predicates;
+            predicates.resize(in.count(3));
+            for (unsigned int i = 0; i < predicates.size() && valid; i++) {
+                predicates[i].token = in.varint();
+                StringRef lemma = in.entry(dictionary);
+                predicates[i].lemma.assign(lemma.data, lemma.length);
+                valid = (unsigned int) predicates[i].token < tokenCount;
+                vector<SrlArgument> &arguments = predicates[i].arguments;
+                arguments.resize(in.count(3));
+                for (unsigned int j = 0; j < arguments.size() && valid; j++) {
+                    unsigned int id = in.id(dictionary.size());
+                    if (in.bad())
+                        break;
+                    if (roleSymbols[id] < 0)
+                        roleSymbols[id] = SymbolTable::roles().intern(
+                                dictionary[id].data, dictionary[id].length);
+                    arguments[j].label = roleSymbols[id];
+                    unsigned int start = in.varint();
+                    unsigned int length = in.varint();
+                    valid = start <= tokenCount && length <= tokenCount - start;
+                    arguments[j].startOffset = start;
+                    arguments[j].endOffset = start + length;
+                }
+            }
+        }
+        valid = valid && !in.bad();
+    }
+
+    if (!valid || in.bad()) {
+        doc.sentences.clear();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Save the NLP annotation to an output stream in the binary format.
+ * 	@param doc The annotated document.
+ * 	@param out The output stream.
+ */
+void DocumentSerializer::saveBinary(const Document &doc, ostream &out) {
+    // The dictionary is filled in order of first occurrence while the
+    // sentences are encoded, then written ahead of them.
+    SymbolTable dictionary;
+    string body;
+    putVarint(body, doc.sentences.size());
+    for (unsigned int s = 0; s < doc.sentences.size(); s++) {
+        const Sentence &sentence = doc.sentences[s];
+        unsigned char nils = 0;
+        if (sentence.tags.empty()) nils |= NIL_TAGS;
+        if (sentence.lemmas.empty()) nils |= NIL_LEMMAS;
+        if (sentence.entities.empty()) nils |= NIL_ENTITIES;
+        if (sentence.norms.empty()) nils |= NIL_NORMS;
+        if (sentence.chunks.empty()) nils |= NIL_CHUNKS;
+        if (sentence.syntacticTree.empty()) nils |= NIL_TREE;
+        if (sentence.predicates.empty()) nils |= NIL_ROLES;
+        putVarint(body, sentence.words.size());
+        body += (char) nils;
+
+        putColumn(body, dictionary, sentence.words);
+        int previous = 0;
+        for (unsigned int i = 0; i < sentence.words.size(); i++) {
+            putSigned(body, sentence.startOffsets.at(i) - previous);
+            putSigned(body, sentence.endOffsets.at(i)
+                    - sentence.startOffsets.at(i));
+            previous = sentence.endOffsets.at(i);
+        }
+
+        putColumn(body, dictionary, sentence.tags, SymbolTable::tags());
+        putColumn(body, dictionary, sentence.lemmas);
+        putColumn(body, dictionary, sentence.entities,
+                SymbolTable::entities());
+        putColumn(body, dictionary, sentence.norms);
+        putColumn(body, dictionary, sentence.chunks, SymbolTable::chunks());
+
+        const vector<SyntacticTree::Node> &nodes = sentence.syntacticTree.nodes;
+        if (!nodes.empty()) {
+            putVarint(body, nodes.size());
+            for (unsigned int i = 0; i < nodes.size(); i++) {
+                putVarint(body, dictionary.intern(nodes[i].value));
+                putSigned(body, nodes[i].head);
+                putSigned(body, nodes[i].startOffset);
+                putSigned(body, nodes[i].endOffset - nodes[i].startOffset);
+                putVarint(body, nodes[i].children);
+            }
+        }
+
+        const vector<SrlPredicate> &predicates = sentence.predicates;
+        if (!predicates.empty()) {
+            putVarint(body, predicates.size());
+            for (unsigned int i = 0; i < predicates.size(); i++) {
+                putVarint(body, predicates[i].token);
+                putVarint(body, dictionary.intern(predicates[i].lemma));
+                const vector<SrlArgument> &arguments = predicates[i].arguments;
+                putVarint(body, arguments.size());
+                for (unsigned int j = 0; j < arguments.size(); j++) {
+                    putVarint(body, dictionary.intern(arguments[j].role()));
+                    putVarint(body, arguments[j].startOffset);
+                    putVarint(body, arguments[j].endOffset
+                            - arguments[j].startOffset);
+                }
+            }
+        }
+    }
+
+    string header = BINARY_MAGIC;
+    header += (char) BINARY_VERSION;
+    putVarint(header, dictionary.size());
+    for (unsigned int i = 0; i < dictionary.size(); i++) {
+        putVarint(header, dictionary.name(i).size());
+        header += dictionary.name(i);
+    }
+    out.write(header.data(), header.size());
+    out.write(body.data(), body.size());
+}
+
+/**
+ * Check whether a stream holds the binary format, without consuming it.
+ * 	@param stream The input stream.
+ * 	@return True if the stream starts with the binary magic.
+ */
+bool DocumentSerializer::isBinary(istream &stream) {
+    streampos start = stream.tellg();
+    string magic(BINARY_MAGIC.size(), '\0');
+    stream.read(&magic[0], magic.size());
+    bool binary = stream.gcount() == (streamsize) magic.size()
+            && magic == BINARY_MAGIC;
+    stream.clear();
+    stream.seekg(start);
+    return binary;
 }
 
 /**
@@ -76,169 +799,469 @@ vector<string> DocumentSerializer::tokenize(const string &line) {
 }
 
 /**
- * Loads the annotation for the next sentence in the stream.
- * 	@param stream The input stream.
- * 	@return A sentence containing the annotations.
+ * Loads the annotation for the next sentence from a line reader.
+ * Every field is a view into the reader's buffer, numbers are parsed in
+ * place, and the vectors of the given sentence are reused. The string
+ * columns and the tree are parsed into the reader's scratch space and then
+ * copied, so that a new sentence gets storage of the exact size in one
+ * allocation per column instead of growing it.
+ *
+ * Columns that are not asked for cost nothing: token lines are split only
+ * up to the last field needed, and the blocks that are not needed are
+ * skipped line by line without being split.
+ * 	@param lines The source of annotation lines.
+ * 	@param fields Scratch space for the fields of each line.
+ * 	@param buffers The label caches and scratch space of the reader.
+ * 	@param columns Mask of the Columns to load; the others are left empty.
+ * 	@param sentence Overwritten with the annotations.
  */
-Sentence DocumentSerializer::loadSentence(istream &stream) {
+void DocumentSerializer::loadSentence(LineReader &lines,
+        vector<StringRef> &fields, LoadBuffers &buffers, unsigned int columns,
+        Sentence &sentence) {
     // First line should be the start of tokens
-    string line;
-    getline(stream, line);
-    vector<string> tokens = tokenize(line);
-    assert(tokens.at(0).compare(START_TOKENS) == 0);
-    int tokenCount = atoi(tokens.at(1).c_str());
-
-    // Initialize the vectors to hold the annotations
-    vector<string> wordBuffer;
-    vector<int> startOffsetBuffer;
-    vector<int> endOffsetBuffer;
-    vector<string> tagBuffer;
+    lines.nextFields(fields);
+    assert(fields.size() >= 2 && fields.at(0).equals(START_TOKENS));
+    int tokenCount = parseInt(fields.at(1));
+
+    // Only the fields up to the last one needed are split; all of them are
+    // split (and checked) when all are needed
+    size_t count = 1;
+    for (size_t i = 1; i < TOKEN_FIELDS; i++) {
+        if (columns & FIELD_COLUMNS[i])
+            count = i + 1;
+    }
+    size_t split = (count == TOKEN_FIELDS) ? (size_t) -1 : count;
+    bool offsets = (columns & COLUMN_OFFSETS) != 0;
+    bool tags = (columns & COLUMN_TAGS) != 0;
+    bool lemmas = (columns & COLUMN_LEMMAS) != 0;
+    bool entities = (columns & COLUMN_ENTITIES) != 0;
+    bool norms = (columns & COLUMN_NORMS) != 0;
+    bool chunks = (columns & COLUMN_CHUNKS) != 0;
+
+    // Size the vectors that hold the annotations
+    buffers.words.clear();
+    sentence.startOffsets.resize(offsets ? tokenCount : 0);
+    sentence.endOffsets.resize(offsets ? tokenCount : 0);
+    sentence.tags.resize(tags ? tokenCount : 0);
     bool nilTags = true;
-    vector<string> lemmaBuffer;
+    buffers.lemmas.clear();
     bool nilLemmas = true;
-    vector<string> entityBuffer;
+    sentence.entities.resize(entities ? tokenCount : 0);
     bool nilEntities = true;
-    vector<string> normBuffer;
+    buffers.norms.clear();
     bool nilNorms = true;
-    vector<string> chunkBuffer;
+    sentence.chunks.resize(chunks ? tokenCount : 0);
     bool nilChunks = true;
 
     // Each line = a token in the sentence
-    int offset = 0;
     string nil(1, NIL);
-    while (offset < tokenCount) {
-        getline(stream, line);
-        tokens = tokenize(line);
+    for (int offset = 0; offset < tokenCount; offset++) {
+        lines.nextFields(fields, split);
 
         // We expect 8 different annotations for each token
-        assert(tokens.size() == 8);
-
-        wordBuffer.push_back(tokens.at(0));
-        startOffsetBuffer.push_back(atoi(tokens.at(1).c_str()));
-        endOffsetBuffer.push_back(atoi(tokens.at(2).c_str()));
-
-        tagBuffer.push_back(tokens.at(3));
-        if (tokens.at(3).compare(nil) != 0)
-            nilTags = false;
-        lemmaBuffer.push_back(tokens.at(4));
-        if (tokens.at(4).compare(nil) != 0)
-            nilLemmas = false;
-        entityBuffer.push_back(tokens.at(5));
-        if (tokens.at(5).compare(nil) != 0)
-            nilEntities = false;
-        normBuffer.push_back(tokens.at(6));
-        if (tokens.at(6).compare(nil) != 0)
-            nilNorms = false;
-        chunkBuffer.push_back(tokens.at(7));
-        if (tokens.at(7).compare(nil) != 0)
-            nilChunks = false;
-
-        offset += 1;
-    }
-    assert((int) wordBuffer.size() == tokenCount);
-    assert((int) startOffsetBuffer.size() == tokenCount);
-    assert((int) endOffsetBuffer.size() == tokenCount);
-    assert((int) tagBuffer.size() == 0 || (int) tagBuffer.size() == tokenCount);
-    assert((int) lemmaBuffer.size() == 0
-                    || (int) lemmaBuffer.size() == tokenCount);
-    assert((int) entityBuffer.size() == 0
-                    || (int) entityBuffer.size() == tokenCount);
-    assert((int) normBuffer.size() == 0
-                    || (int) normBuffer.size() == tokenCount);
-    assert((int) chunkBuffer.size() == 0
-                    || (int) chunkBuffer.size() == tokenCount);
-
-    // Skip the rest of the information that we currently aren't processing
-    // (such as constituent trees and coref chains).
+        assert(fields.size()
+                == ((split == (size_t) -1) ? TOKEN_FIELDS : count));
+
+        buffers.words.push_back(fields[0]);
+        if (offsets) {
+            sentence.startOffsets[offset] = parseInt(fields[1]);
+            sentence.endOffsets[offset] = parseInt(fields[2]);
+        }
+
+        if (tags) {
+            sentence.tags[offset] = buffers.tags.intern(fields[3].data,
+                    fields[3].length);
+            if (sentence.tags[offset] != SymbolTable::NIL_SYMBOL)
+                nilTags = false;
+        }
+        if (lemmas) {
+            buffers.lemmas.push_back(fields[4]);
+            if (!fields[4].equals(nil))
+                nilLemmas = false;
+        }
+        if (entities) {
+            sentence.entities[offset] = buffers.entities.intern(
+                    fields[5].data, fields[5].length);
+            if (sentence.entities[offset] != SymbolTable::NIL_SYMBOL)
+                nilEntities = false;
+        }
+        if (norms) {
+            buffers.norms.push_back(fields[6]);
+            if (!fields[6].equals(nil))
+                nilNorms = false;
+        }
+        if (chunks) {
+            sentence.chunks[offset] = buffers.chunks.intern(fields[7].data,
+                    fields[7].length);
+            if (sentence.chunks[offset] != SymbolTable::NIL_SYMBOL)
+                nilChunks = false;
+        }
+    }
+
+    // Columns that are entirely NIL, or were not asked for, are dropped
+    sentence.words = buffers.words;
+    if (nilTags) sentence.tags.clear();
+    if (nilLemmas) sentence.lemmas.clear();
+    else sentence.lemmas = buffers.lemmas;
+    if (nilEntities) sentence.entities.clear();
+    if (nilNorms) sentence.norms.clear();
+    else sentence.norms = buffers.norms;
+    if (nilChunks) sentence.chunks.clear();
+
+    // Load the semantic roles and the constituent tree if asked for, and
+    // skip the rest of the information that we currently aren't processing
+    // (such as dependencies).
+    StringRef line;
+    sentence.predicates.clear();
+    sentence.syntacticTree.clear();
+    sentence.dependencies.clear();
     do {
-        getline(stream, line);
-        tokens = tokenize(line);
-        if (tokens.size() == 0) continue;
-        if (tokens.at(0).compare(START_DEPENDENCIES) == 0) {
+        if (!lines.nextFields(fields)) break;
+        if (fields.size() == 0) continue;
+        if (fields.at(0).equals(START_DEPENDENCIES)) {
+
+            if (columns & COLUMN_DEPENDENCIES) {
+                // Keep the block as it is, up to and including its EOX
+                string &text = sentence.dependencies;
+                for (unsigned int i = 0; i < fields.size(); i++) {
+                    if (i > 0)
+                        text += SEP;
+                    text.append(fields[i].data, fields[i].length);
+                }
+                text += '\n';
+                while (lines.nextLine(line)) {
+                    text.append(line.data, line.length);
+                    text += '\n';
+                    if (isMarker(line, END_OF_DEPENDENCIES))
+                        break;
+                }
+            } else {
+                // Eat up dependencies
+                while (lines.nextLine(line)
+                        && !isMarker(line, END_OF_DEPENDENCIES)) { }
+            }
 
-            do { // Eat up dependencies
-                getline(stream, line);
-                tokens = tokenize(line);
-            } while (tokens.size() == 0 ||
-                    tokens.at(0).compare(END_OF_DEPENDENCIES) != 0);
+        } else if (fields.at(0).equals(START_ROLES)) {
 
-        } else if (tokens.at(0).compare(START_CONSTITUENTS) == 0) {
+            if (columns & COLUMN_ROLES) {
+                loadRoles(lines, fields, buffers.roles, sentence.predicates);
+            } else {
+                // One line per predicate
+                assert(fields.size() >= 2);
+                int predicates = parseInt(fields.at(1));
+                for (int i = 0; i < predicates && lines.nextLine(line); i++) { }
+            }
 
-            do { // Eat up constituents
-                getline(stream, line);
-                tokens = tokenize(line);
-            } while (tokens.size() == 0 ||
-                    tokens.at(0).compare(END_OF_SENTENCE) != 0);
+        } else if (fields.at(0).equals(START_CONSTITUENTS)) {
+
+            // Constituents run up to the end of the sentence
+            if (columns & COLUMN_TREE) {
+                buffers.tree.clear();
+                loadTree(lines, fields, buffers.tree);
+                sentence.syntacticTree.nodes = buffers.tree.nodes;
+            } else {
+                fields.clear();
+                while (lines.nextLine(line)) {
+                    if (isMarker(line, END_OF_SENTENCE)) {
+                        fields.push_back(StringRef(line.data,
+                                END_OF_SENTENCE.size()));
+                        break;
+                    }
+                }
+            }
 
         }
-    } while (tokens.size() == 0 || tokens.at(0).compare(END_OF_SENTENCE) != 0);
+    } while (fields.size() == 0 || !fields.at(0).equals(END_OF_SENTENCE));
 
-    // Now let's create a sentence and return it
-    vector<string> empty;
-    Sentence sent(wordBuffer, startOffsetBuffer, endOffsetBuffer,
-            (nilTags) ? empty : tagBuffer,
-            (nilLemmas) ? empty : lemmaBuffer,
-            (nilEntities) ? empty : entityBuffer,
-            (nilNorms) ? empty : normBuffer, (nilChunks) ? empty : chunkBuffer);
+    // A truncated annotation ends without an EOS
+    assert(fields.size() > 0 && fields.at(0).equals(END_OF_SENTENCE));
+}
+
+/**
+ * Check that a text annotation has the structure the text loaders rely on,
+ * without asserting. This follows loadSentence() line by line.
+ * 	@param begin Start of the annotation.
+ * 	@param end One past the end of the annotation.
+ * 	@return False if the annotation is malformed.
+ */
+bool DocumentSerializer::checkText(const char *begin, const char *end) {
+    MappedLineReader lines(begin, end, SEP);
+    vector<StringRef> fields;
+    StringRef line;
+    int sentences;
+    if (!lines.nextFields(fields) || fields.size() < 2
+            || !fields[0].equals(START_SENTENCES)
+            || !parseCount(fields[1], sentences))
+        return false;
 
-    return sent;
+    for (int s = 0; s < sentences; s++) {
+        int tokenCount;
+        if (!lines.nextFields(fields) || fields.size() < 2
+                || !fields[0].equals(START_TOKENS)
+                || !parseCount(fields[1], tokenCount))
+            return false;
+        for (int i = 0; i < tokenCount; i++) {
+            if (!lines.nextFields(fields) || fields.size() != TOKEN_FIELDS)
+                return false;
+        }
+
+        // The blocks, up to the end of the sentence
+        bool ended = false;
+        while (!ended) {
+            if (!lines.nextFields(fields))
+                return false;
+            if (fields.size() == 0)
+                continue;
+            if (fields[0].equals(END_OF_SENTENCE)) {
+                ended = true;
+            } else if (fields[0].equals(START_DEPENDENCIES)) {
+                do {
+                    if (!lines.nextLine(line))
+                        return false;
+                } while (!isMarker(line, END_OF_DEPENDENCIES));
+            } else if (fields[0].equals(START_ROLES)) {
+                int predicates;
+                if (fields.size() < 2 || !parseCount(fields[1], predicates))
+                    return false;
+                for (int i = 0; i < predicates; i++) {
+                    int token, start, stop;
+                    if (!lines.nextFields(fields) || fields.size() < 2
+                            || fields.size() % 3 != 2
+                            || !parseCount(fields[0], token)
+                            || token >= tokenCount)
+                        return false;
+                    for (size_t j = 2; j < fields.size(); j += 3) {
+                        if (!parseCount(fields[j + 1], start)
+                                || !parseCount(fields[j + 2], stop)
+                                || start > stop || stop > tokenCount)
+                            return false;
+                    }
+                }
+            } else if (fields[0].equals(START_CONSTITUENTS)) {
+                // Only the shape of the tree matters to the loaders
+                vector<SyntacticTree::Node> nodes;
+                size_t position = 0;
+                while (!ended) {
+                    if (!lines.nextFields(fields))
+                        return false;
+                    ended = fields.size() == 1
+                            && fields[0].equals(END_OF_SENTENCE);
+                    for (size_t i = 0; !ended && i < fields.size(); i++) {
+                        if (position == 0)
+                            nodes.push_back(SyntacticTree::Node());
+                        if (position == 4
+                                && !parseCount(fields[i],
+                                        nodes.back().children))
+                            return false;
+                        position = (position + 1) % 5;
+                    }
+                }
+                if (position != 0 || !wellFormed(nodes))
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Loads the predicates of a sentence and their arguments: one line per
+ * predicate, holding its token and lemma followed by three fields (label,
+ * start offset, end offset) per argument.
+ * 	@param lines The source of annotation lines.
+ * 	@param fields Scratch space; holds the "R" line on entry.
+ * 	@param roles Cache in front of the table of role labels.
+ * 	@param predicates Filled with the predicates.
+ */
+void DocumentSerializer::loadRoles(LineReader &lines,
+        vector<StringRef> &fields, SymbolCache &roles,
+        vector<SrlPredicate> &predicates) {
+    assert(fields.size() >= 2);
+    predicates.resize(parseInt(fields.at(1)));
+    for (unsigned int i = 0; i < predicates.size(); i++) {
+        lines.nextFields(fields);
+        assert(fields.size() >= 2 && fields.size() % 3 == 2);
+        SrlPredicate &predicate = predicates[i];
+        predicate.token = parseInt(fields[0]);
+        predicate.lemma.assign(fields[1].data, fields[1].length);
+        predicate.arguments.resize((fields.size() - 2) / 3);
+        for (unsigned int j = 0; j < predicate.arguments.size(); j++) {
+            const StringRef *argument = &fields[2 + 3 * j];
+            predicate.arguments[j].label = roles.intern(argument[0].data,
+                    argument[0].length);
+            predicate.arguments[j].startOffset = parseInt(argument[1]);
+            predicate.arguments[j].endOffset = parseInt(argument[2]);
+        }
+    }
+}
+
+/**
+ * Loads a constituent tree, up to and including the end of the sentence.
+ * Nodes are stored in pre-order as five fields each (value, head, start
+ * offset, end offset, number of children); they are normally all on one
+ * line, but may be split across lines.
+ * 	@param lines The source of annotation lines.
+ * 	@param fields Scratch space; holds the EOS line on return.
+ * 	@param tree Filled with the nodes of the tree.
+ */
+void DocumentSerializer::loadTree(LineReader &lines, vector<StringRef> &fields,
+        SyntacticTree &tree) {
+    int position = 0;
+    while (lines.nextFields(fields)) {
+        if (fields.size() == 1 && fields.at(0).equals(END_OF_SENTENCE))
+            break;
+        for (unsigned int i = 0; i < fields.size(); i++) {
+            switch (position) {
+            case 0:
+                tree.nodes.push_back(SyntacticTree::Node());
+                tree.nodes.back().value.assign(fields[i].data,
+                        fields[i].length);
+                break;
+            case 1:
+                tree.nodes.back().head = parseInt(fields[i]);
+                break;
+            case 2:
+                tree.nodes.back().startOffset = parseInt(fields[i]);
+                break;
+            case 3:
+                tree.nodes.back().endOffset = parseInt(fields[i]);
+                break;
+            case 4:
+                tree.nodes.back().children = parseInt(fields[i]);
+                break;
+            }
+            position = (position + 1) % 5;
+        }
+    }
+    assert(position == 0);
 }
 
 /**
- * Print the NLP annotation for the sentence to an output stream.
+ * Print the NLP annotation for the sentence.
  * 	@param doc The annotated sentence.
- * 	@param out The output stream.
+ * 	@param out The buffered output.
  */
-void DocumentSerializer::saveSentence(Sentence sentence, ostream &out) {
-    out << START_TOKENS + SEP << sentence.size() << endl;
-    int offset = 0;
-    while (offset < sentence.size()) {
+void DocumentSerializer::saveSentence(const Sentence &sentence,
+        BufferedWriter &out) {
+    out.write(START_TOKENS);
+    out.put(SEP);
+    out.writeInt(sentence.size());
+    out.put('\n');
+    for (int offset = 0; offset < sentence.size(); offset++) {
         saveToken(sentence, offset, out);
-        offset += 1;
     }
-    out << END_OF_SENTENCE << endl;
+    out.write(sentence.dependencies);
+    if (!sentence.predicates.empty())
+        saveRoles(sentence.predicates, out);
+    if (!sentence.syntacticTree.empty()) {
+        out.write(START_CONSTITUENTS);
+        out.put('\n');
+        saveTree(sentence.syntacticTree, out);
+    }
+    out.write(END_OF_SENTENCE);
+    out.put('\n');
 }
 
 /**
- * Print the NLP annotation for the token to an output stream.
- * 	@param doc The annotated sentence.
- * 	@param offset The token offset in the sentence.
- * 	@param out The output stream.
+ * Print the predicates of a sentence and their arguments, one line per
+ * predicate.
+ * 	@param predicates The predicates.
+ * 	@param out The buffered output.
  */
-void DocumentSerializer::saveToken(Sentence sentence, int offset,
-        ostream &out) {
-    out << sentence.words.at(offset) + SEP << sentence.startOffsets.at(offset)
-            << SEP << sentence.endOffsets.at(offset);
+void DocumentSerializer::saveRoles(const vector<SrlPredicate> &predicates,
+        BufferedWriter &out) {
+    out.write(START_ROLES);
+    out.put(SEP);
+    out.writeInt(predicates.size());
+    out.put('\n');
+    for (unsigned int i = 0; i < predicates.size(); i++) {
+        out.writeInt(predicates[i].token);
+        out.put(SEP);
+        out.write(predicates[i].lemma);
+        const vector<SrlArgument> &arguments = predicates[i].arguments;
+        for (unsigned int j = 0; j < arguments.size(); j++) {
+            out.put(SEP);
+            out.write(arguments[j].role());
+            out.put(SEP);
+            out.writeInt(arguments[j].startOffset);
+            out.put(SEP);
+            out.writeInt(arguments[j].endOffset);
+        }
+        out.put('\n');
+    }
+}
 
-    out << SEP;
-    if (sentence.tags.size() > 0)
-        out << sentence.tags.at(offset);
-    else
-        out << NIL;
+/**
+ * Print a constituent tree on one line, in pre-order.
+ * 	@param tree The tree.
+ * 	@param out The buffered output.
+ */
+void DocumentSerializer::saveTree(const SyntacticTree &tree,
+        BufferedWriter &out) {
+    for (unsigned int i = 0; i < tree.nodes.size(); i++) {
+        const SyntacticTree::Node &node = tree.nodes[i];
+        if (i > 0)
+            out.put(SEP);
+        out.write(node.value);
+        out.put(SEP);
+        out.writeInt(node.head);
+        out.put(SEP);
+        out.writeInt(node.startOffset);
+        out.put(SEP);
+        out.writeInt(node.endOffset);
+        out.put(SEP);
+        out.writeInt(node.children);
+    }
+    out.put('\n');
+}
 
-    out << SEP;
-    if (sentence.lemmas.size() > 0)
-        out << sentence.lemmas.at(offset);
-    else
-        out << NIL;
+/**
+ * Print one optional column of a token, or NIL if the column is absent.
+ */
+static inline void saveColumn(const StringColumn &column, int offset,
+        BufferedWriter &out) {
+    out.put(DocumentSerializer::SEP);
+    if (!column.empty()) {
+        StringRef value = column.at(offset);
+        out.write(value.data, value.length);
+    } else {
+        out.put(DocumentSerializer::NIL);
+    }
+}
 
-    out << SEP;
-    if (sentence.entities.size() > 0)
-        out << sentence.entities.at(offset);
+/**
+ * Print one optional column of labels of a token, or NIL if the column is
+ * absent.
+ */
+static inline void saveColumn(const vector<Symbol> &column, int offset,
+        const SymbolTable &labels, BufferedWriter &out) {
+    out.put(DocumentSerializer::SEP);
+    if (!column.empty())
+        out.write(labels.name(column.at(offset)));
     else
-        out << NIL;
+        out.put(DocumentSerializer::NIL);
+}
 
-    out << SEP;
-    if (sentence.norms.size() > 0)
-        out << sentence.norms.at(offset);
-    else
-        out << NIL;
+/**
+ * Print the NLP annotation for the token.
+ * 	@param doc The annotated sentence.
+ * 	@param offset The token offset in the sentence.
+ * 	@param out The buffered output.
+ */
+void DocumentSerializer::saveToken(const Sentence &sentence, int offset,
+        BufferedWriter &out) {
+    StringRef word = sentence.words.at(offset);
+    out.write(word.data, word.length);
+    out.put(SEP);
+    out.writeInt(sentence.startOffsets.at(offset));
+    out.put(SEP);
+    out.writeInt(sentence.endOffsets.at(offset));
 
-    out << SEP;
-    if (sentence.chunks.size() > 0)
-        out << sentence.chunks.at(offset);
-    else
-        out << NIL;
+    saveColumn(sentence.tags, offset, SymbolTable::tags(), out);
+    saveColumn(sentence.lemmas, offset, out);
+    saveColumn(sentence.entities, offset, SymbolTable::entities(), out);
+    saveColumn(sentence.norms, offset, out);
+    saveColumn(sentence.chunks, offset, SymbolTable::chunks(), out);
 
-    out << endl;
+    out.put('\n');
 }
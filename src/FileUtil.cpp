@@ -0,0 +1,71 @@
+/*
+ * FileUtil.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "FileUtil.h"
+
+using namespace std;
+
+namespace processors {
+
+/**
+ * CRC-32 of a buffer of any size (zlib takes at most 4 GB at once).
+ * 	@param data The bytes.
+ * 	@param length Number of bytes.
+ * 	@param previous CRC-32 of the bytes before them, to checksum a file a
+ * 	block at a time.
+ */
+uint32_t bufferChecksum(const char *data, size_t length, uint32_t previous) {
+    uLong crc = previous;
+    while (length > 0) {
+        uInt chunk = (length > (1U << 30)) ? (1U << 30) : (uInt) length;
+        crc = crc32(crc, (const Bytef *) data, chunk);
+        data += chunk;
+        length -= chunk;
+    }
+    return (uint32_t) crc;
+}
+
+/**
+ * Flush a file or directory to disk; flushing a directory makes the files
+ * created in it persist.
+ * 	@param path The file or directory.
+ * 	@return False on error.
+ */
+bool syncPath(const string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    bool ok = (fsync(fd) == 0);
+    return (close(fd) == 0) && ok;
+}
+
+/**
+ * Write all bytes to a file descriptor, retrying short writes.
+ * 	@param fd The file descriptor.
+ * 	@param data The bytes.
+ * 	@param length Number of bytes.
+ * 	@return False on error (e.g. the other end is gone).
+ */
+bool writeAll(int fd, const char *data, size_t length) {
+    while (length > 0) {
+        ssize_t n = write(fd, data, length);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        length -= n;
+    }
+    return true;
+}
+
+}
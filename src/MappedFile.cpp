@@ -0,0 +1,53 @@
+/*
+ * MappedFile.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "MappedFile.h"
+
+using namespace std;
+using namespace processors;
+
+/**
+ * Constructor. Maps the file; check is_open() for success.
+ * 	@param filename Path to the file.
+ */
+MappedFile::MappedFile(const string &filename) :
+        data(NULL), length(0), opened(false) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+
+    struct stat info;
+    if (fstat(fd, &info) == 0) {
+        length = info.st_size;
+        if (length == 0) {
+            // mmap refuses empty mappings; an empty file is still valid
+            opened = true;
+        } else {
+            void *addr = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED) {
+                // The loaders read front to back
+                madvise(addr, length, MADV_SEQUENTIAL);
+                data = (const char *) addr;
+                opened = true;
+            } else {
+                length = 0;
+            }
+        }
+    }
+    close(fd);
+}
+
+/** Destructor. Unmaps the file. */
+MappedFile::~MappedFile() {
+    if (data != NULL)
+        munmap((void *) data, length);
+}
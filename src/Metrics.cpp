@@ -0,0 +1,408 @@
+/*
+ * Metrics.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Metrics.h"
+
+using namespace std;
+using namespace processors;
+
+/* Upper bounds of the sentence-length buckets, in tokens */
+static const int LENGTH_BOUNDS[] = { 10, 20, 40, 80 };
+
+/* Labels of the sentence-length buckets */
+static const char *LENGTH_NAMES[] = { "1-10", "11-20", "21-40", "41-80",
+        "81+" };
+
+/* Upper bounds of the latency buckets, in seconds */
+static const double LATENCY_BOUNDS[] = { 0.0001, 0.001, 0.01, 0.1, 1, 10 };
+
+/* Labels of the latency buckets */
+static const char *LATENCY_NAMES[] = { "0.0001", "0.001", "0.01", "0.1", "1",
+        "10", "+Inf" };
+
+/* Files whose summary a run keeps: the slowest ones */
+static const unsigned int SLOWEST_FILES = 100;
+
+/**
+ * Escape a string for a JSON string.
+ */
+static string escape(const string &s) {
+    string escaped;
+    for (string::size_type i = 0; i < s.size(); i++) {
+        char c = s[i];
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else if ((unsigned char) c < 0x20) {
+            char code[8];
+            snprintf(code, sizeof(code), "\\u%04x", c);
+            escaped += code;
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+/**
+ * Escape a string for a Prometheus label value, which only defines escapes
+ * for backslash, double quote and line feed.
+ */
+static string escapeLabel(const string &s) {
+    string escaped;
+    for (string::size_type i = 0; i < s.size(); i++) {
+        char c = s[i];
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+/** Name of a stage, as used in the output. */
+const char *Metrics::stageName(int stage) {
+    static const char *names[] = { "load", "encode", "cache", "parse",
+            "tree_serialize", "conll_serialize", "label" };
+    return names[stage];
+}
+
+/** Constructor. */
+Metrics::Metrics() : sentences(0), tokens(0), seconds(0) {
+    for (int s = 0; s < STAGES; s++) {
+        for (int l = 0; l < LENGTHS; l++) {
+            Cell &cell = cells[s][l];
+            cell.count = 0;
+            cell.sum = 0;
+            for (int b = 0; b < LATENCIES; b++)
+                cell.latencies[b] = 0;
+        }
+        slowest[s].seconds = -1;
+        slowest[s].tokens = 0;
+        slowest[s].sentence = -1;
+    }
+}
+
+/**
+ * Record the time one sentence spent in a stage.
+ * 	@param stage The stage.
+ * 	@param tokens Length of the sentence.
+ * 	@param seconds Time spent.
+ * 	@param sentence Index of the sentence in its file, if known.
+ */
+void Metrics::record(Stage stage, int tokens, double seconds,
+        long sentence) {
+    int length = 0;
+    while (length < LENGTHS - 1 && tokens > LENGTH_BOUNDS[length])
+        length++;
+    int latency = 0;
+    while (latency < LATENCIES - 1 && seconds > LATENCY_BOUNDS[latency])
+        latency++;
+
+    Cell &cell = cells[stage][length];
+    cell.count++;
+    cell.sum += seconds;
+    cell.latencies[latency]++;
+
+    Outlier &outlier = slowest[stage];
+    if (seconds > outlier.seconds) {
+        outlier.seconds = seconds;
+        outlier.tokens = tokens;
+        outlier.sentence = sentence;
+        outlier.file = file;
+    }
+}
+
+/**
+ * Add the measurements of another object (e.g. from a worker).
+ * 	@param other The measurements.
+ * 	@param sentence If not negative, the sentence the measurements belong
+ * 	to.
+ */
+void Metrics::merge(const Metrics &other, long sentence) {
+    for (int s = 0; s < STAGES; s++) {
+        for (int l = 0; l < LENGTHS; l++) {
+            Cell &cell = cells[s][l];
+            const Cell &add = other.cells[s][l];
+            cell.count += add.count;
+            cell.sum += add.sum;
+            for (int b = 0; b < LATENCIES; b++)
+                cell.latencies[b] += add.latencies[b];
+        }
+        if (other.slowest[s].seconds > slowest[s].seconds) {
+            slowest[s] = other.slowest[s];
+            if (sentence >= 0)
+                slowest[s].sentence = sentence;
+            if (slowest[s].file.empty())
+                slowest[s].file = other.file.empty() ? file : other.file;
+        }
+    }
+}
+
+/**
+ * Add the measurements of a file to a run, and keep its summary.
+ * 	@param file The measurements of the file.
+ */
+void Metrics::addFile(const Metrics &file) {
+    merge(file);
+    sentences += file.sentences;
+    tokens += file.tokens;
+
+    FileSummary summary;
+    summary.file = file.file;
+    summary.sentences = file.sentences;
+    summary.tokens = file.tokens;
+    summary.seconds = file.seconds;
+    for (int s = 0; s < STAGES; s++)
+        summary.stages[s] = file.stageSeconds(s);
+    files.push_back(summary);
+
+    // Only the slowest files are kept, so that a run over millions of
+    // files does not hold a summary of each
+    if (files.size() >= 2 * SLOWEST_FILES) {
+        nth_element(files.begin(), files.begin() + SLOWEST_FILES,
+                files.end(), slowerFile);
+        files.resize(SLOWEST_FILES);
+    }
+}
+
+/** Slower file first. */
+bool Metrics::slowerFile(const FileSummary &a, const FileSummary &b) {
+    return a.seconds > b.seconds;
+}
+
+/** Time spent in a stage over all sentences. */
+double Metrics::stageSeconds(int stage) const {
+    double sum = 0;
+    for (int l = 0; l < LENGTHS; l++)
+        sum += cells[stage][l].sum;
+    return sum;
+}
+
+/** Sentences that went through a stage. */
+long Metrics::stageCount(int stage) const {
+    long count = 0;
+    for (int l = 0; l < LENGTHS; l++)
+        count += cells[stage][l].count;
+    return count;
+}
+
+/**
+ * Append a compact encoding of the measurements (without the file
+ * summaries), for sending them between processes.
+ * 	@param out The encoding is appended here.
+ */
+void Metrics::encode(string &out) const {
+    char number[96];
+    snprintf(number, sizeof(number), "%ld %ld %.17g", sentences, tokens,
+            seconds);
+    out += number;
+    for (int s = 0; s < STAGES; s++) {
+        snprintf(number, sizeof(number), " %.17g %d %ld", slowest[s].seconds,
+                slowest[s].tokens, slowest[s].sentence);
+        out += number;
+        for (int l = 0; l < LENGTHS; l++) {
+            const Cell &cell = cells[s][l];
+            snprintf(number, sizeof(number), " %ld %.17g", cell.count,
+                    cell.sum);
+            out += number;
+            for (int b = 0; b < LATENCIES; b++) {
+                snprintf(number, sizeof(number), " %ld", cell.latencies[b]);
+                out += number;
+            }
+        }
+    }
+}
+
+/**
+ * Read the next number of an encoding.
+ * 	@return False if there is none.
+ */
+static bool nextNumber(const char *&p, double &value) {
+    char *end;
+    value = strtod(p, &end);
+    if (end == p)
+        return false;
+    p = end;
+    return true;
+}
+
+/**
+ * Replace the measurements with an encoding made by encode().
+ * 	@param in The encoding.
+ * 	@return False if the encoding is malformed.
+ */
+bool Metrics::decode(const string &in) {
+    *this = Metrics();
+    const char *p = in.c_str();
+    double v[3];
+    for (int i = 0; i < 3; i++) {
+        if (!nextNumber(p, v[i]))
+            return false;
+    }
+    sentences = (long) v[0];
+    tokens = (long) v[1];
+    seconds = v[2];
+    for (int s = 0; s < STAGES; s++) {
+        for (int i = 0; i < 3; i++) {
+            if (!nextNumber(p, v[i]))
+                return false;
+        }
+        slowest[s].seconds = v[0];
+        slowest[s].tokens = (int) v[1];
+        slowest[s].sentence = (long) v[2];
+        for (int l = 0; l < LENGTHS; l++) {
+            Cell &cell = cells[s][l];
+            if (!nextNumber(p, v[0]) || !nextNumber(p, v[1]))
+                return false;
+            cell.count = (long) v[0];
+            cell.sum = v[1];
+            for (int b = 0; b < LATENCIES; b++) {
+                if (!nextNumber(p, v[0]))
+                    return false;
+                cell.latencies[b] = (long) v[0];
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Write the measurements to a file, replacing it atomically. Files ending
+ * in ".prom" get the Prometheus text format, others JSON.
+ * 	@param filename Path to the file.
+ * 	@return False if the file could not be written.
+ */
+bool Metrics::save(const string &filename) const {
+    // Scrapers must never see a half-written file
+    string temporary = filename + ".tmp";
+    ofstream out(temporary.c_str());
+    if (!out.is_open())
+        return false;
+    string::size_type dot = filename.find_last_of(".");
+    if (dot != string::npos && filename.substr(dot) == ".prom")
+        writePrometheus(out);
+    else
+        writeJson(out);
+    out.close();
+    if (!out || rename(temporary.c_str(), filename.c_str()) != 0) {
+        remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+/** Write the measurements as a JSON object. */
+void Metrics::writeJson(ostream &out) const {
+    out << "{\n  \"sentences\": " << sentences << ",\n  \"tokens\": "
+            << tokens << ",\n  \"seconds\": " << seconds;
+    if (!file.empty())
+        out << ",\n  \"file\": \"" << escape(file) << "\"";
+    out << ",\n  \"stages\": {";
+    for (int s = 0; s < STAGES; s++) {
+        out << (s > 0 ? "," : "") << "\n    \"" << stageName(s)
+                << "\": {\"count\": " << stageCount(s) << ", \"seconds\": "
+                << stageSeconds(s);
+        const Outlier &outlier = slowest[s];
+        if (outlier.seconds >= 0) {
+            out << ", \"slowest\": {\"seconds\": " << outlier.seconds
+                    << ", \"tokens\": " << outlier.tokens
+                    << ", \"sentence\": " << outlier.sentence
+                    << ", \"file\": \"" << escape(outlier.file) << "\"}";
+        }
+        out << ", \"by_length\": [";
+        for (int l = 0; l < LENGTHS; l++) {
+            const Cell &cell = cells[s][l];
+            out << (l > 0 ? ", " : "") << "{\"length\": \""
+                    << LENGTH_NAMES[l] << "\", \"count\": " << cell.count
+                    << ", \"seconds\": " << cell.sum << ", \"latency\": {";
+            for (int b = 0; b < LATENCIES; b++) {
+                out << (b > 0 ? ", " : "") << "\"" << LATENCY_NAMES[b]
+                        << "\": " << cell.latencies[b];
+            }
+            out << "}}";
+        }
+        out << "]}";
+    }
+    out << "\n  }";
+
+    if (!files.empty()) {
+        vector<FileSummary> slowestFiles(files);
+        sort(slowestFiles.begin(), slowestFiles.end(), slowerFile);
+        if (slowestFiles.size() > SLOWEST_FILES)
+            slowestFiles.resize(SLOWEST_FILES);
+        out << ",\n  \"files\": [";
+        for (unsigned int i = 0; i < slowestFiles.size(); i++) {
+            const FileSummary &summary = slowestFiles[i];
+            out << (i > 0 ? "," : "") << "\n    {\"file\": \""
+                    << escape(summary.file) << "\", \"sentences\": "
+                    << summary.sentences << ", \"tokens\": "
+                    << summary.tokens << ", \"seconds\": " << summary.seconds
+                    << ", \"stages\": {";
+            for (int s = 0; s < STAGES; s++) {
+                out << (s > 0 ? ", " : "") << "\"" << stageName(s) << "\": "
+                        << summary.stages[s];
+            }
+            out << "}}";
+        }
+        out << "\n  ]";
+    }
+    out << "\n}\n";
+}
+
+/** Write the measurements in the Prometheus text format. */
+void Metrics::writePrometheus(ostream &out) const {
+    out << "# HELP swirl_stage_seconds Time spent per sentence in each stage"
+            << " of the SRL pipeline.\n"
+            << "# TYPE swirl_stage_seconds histogram\n";
+    for (int s = 0; s < STAGES; s++) {
+        for (int l = 0; l < LENGTHS; l++) {
+            const Cell &cell = cells[s][l];
+            string labels = string("stage=\"") + stageName(s)
+                    + "\",length=\"" + LENGTH_NAMES[l] + "\"";
+            long cumulative = 0;
+            for (int b = 0; b < LATENCIES; b++) {
+                cumulative += cell.latencies[b];
+                out << "swirl_stage_seconds_bucket{" << labels << ",le=\""
+                        << LATENCY_NAMES[b] << "\"} " << cumulative << "\n";
+            }
+            out << "swirl_stage_seconds_sum{" << labels << "} " << cell.sum
+                    << "\n";
+            out << "swirl_stage_seconds_count{" << labels << "} "
+                    << cell.count << "\n";
+        }
+    }
+
+    out << "# HELP swirl_stage_slowest_seconds Slowest sentence of each"
+            << " stage.\n# TYPE swirl_stage_slowest_seconds gauge\n";
+    for (int s = 0; s < STAGES; s++) {
+        const Outlier &outlier = slowest[s];
+        if (outlier.seconds < 0)
+            continue;
+        out << "swirl_stage_slowest_seconds{stage=\"" << stageName(s)
+                << "\",file=\"" << escapeLabel(outlier.file)
+                << "\",sentence=\"" << outlier.sentence << "\",tokens=\""
+                << outlier.tokens << "\"} " << outlier.seconds << "\n";
+    }
+
+    out << "# TYPE swirl_sentences gauge\nswirl_sentences " << sentences
+            << "\n# TYPE swirl_tokens gauge\nswirl_tokens " << tokens
+            << "\n# TYPE swirl_seconds gauge\nswirl_seconds " << seconds
+            << "\n";
+}
@@ -0,0 +1,22 @@
+/*
+ * OutputSink.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#include "FileUtil.h"
+#include "OutputSink.h"
+
+using namespace std;
+using namespace processors;
+
+/**
+ * Write a block of bytes to the file descriptor, retrying short writes.
+ * 	@param data The bytes.
+ * 	@param length Number of bytes.
+ * 	@return False on error.
+ */
+bool FileSink::write(const char *data, size_t length) {
+    return writeAll(descriptor, data, length);
+}
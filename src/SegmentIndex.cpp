@@ -0,0 +1,92 @@
+/*
+ * SegmentIndex.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#include <fstream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include "SegmentIndex.h"
+
+using namespace std;
+using namespace processors;
+
+/* Name of the index file in the output directory */
+const string SegmentIndex::FILENAME = "segments.idx";
+
+/**
+ * Name of a segment file.
+ * 	@param number Number of the segment.
+ */
+string SegmentIndex::segmentName(int number) {
+    char name[32];
+    snprintf(name, sizeof(name), "segment-%05d.seg", number);
+    return name;
+}
+
+/**
+ * Constructor. Reads the index of an output directory, if any. Entries that
+ * point past the end of their segment are dropped.
+ * 	@param directory The output directory.
+ */
+SegmentIndex::SegmentIndex(const string &directory) :
+        directory(directory), opened(false) {
+    ifstream in((directory + "/" + FILENAME).c_str());
+    if (!in)
+        return;
+    opened = true;
+    stringstream contents;
+    contents << in.rdbuf();
+    string text = contents.str();
+
+    // One entry per line; a line without its newline was torn by a crash
+    map<string, long long> sizes;
+    string::size_type start = 0, end;
+    while ((end = text.find('\n', start)) != string::npos) {
+        string line = text.substr(start, end - start);
+        start = end + 1;
+
+        string::size_type tab = line.find('\t');
+        string::size_type tab2 = (tab == string::npos)
+                ? string::npos : line.find('\t', tab + 1);
+        string::size_type tab3 = (tab2 == string::npos)
+                ? string::npos : line.find('\t', tab2 + 1);
+        if (tab3 == string::npos
+                || line.find('\t', tab3 + 1) != string::npos)
+            continue;
+        Entry entry;
+        entry.segment = line.substr(0, tab);
+        entry.offset = atoll(line.c_str() + tab + 1);
+        entry.length = atoll(line.c_str() + tab2 + 1);
+
+        // Each segment is checked once
+        map<string, long long>::iterator size = sizes.find(entry.segment);
+        if (size == sizes.end()) {
+            struct stat info;
+            long long bytes = (stat(path(entry).c_str(), &info) == 0)
+                    ? info.st_size : -1;
+            size = sizes.insert(make_pair(entry.segment, bytes)).first;
+        }
+        string name = line.substr(tab3 + 1);
+        if (entry.offset >= 0 && entry.length >= 0
+                && entry.offset + entry.length <= size->second)
+            index[name] = entry;
+        else
+            index.erase(name);
+    }
+}
+
+/**
+ * Find an output.
+ * 	@param name Name of the output.
+ * 	@return Its entry, or NULL if it is not in the index.
+ */
+const SegmentIndex::Entry *SegmentIndex::find(const string &name) const {
+    map<string, Entry>::const_iterator found = index.find(name);
+    return (found == index.end()) ? NULL : &found->second;
+}
@@ -0,0 +1,165 @@
+/*
+ * SegmentWriter.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "FileUtil.h"
+#include "SegmentIndex.h"
+#include "SegmentWriter.h"
+
+using namespace std;
+using namespace processors;
+
+/* Outputs, or bytes of output, that may be pending before a commit */
+static const int COMMIT_OUTPUTS = 256;
+static const long long COMMIT_BYTES = 64LL << 20;
+
+/**
+ * Constructor. No file is created until the first output.
+ * 	@param directory The output directory.
+ * 	@param codec Compression of each output.
+ * 	@param segmentBytes Size past which a new segment is started.
+ */
+SegmentWriter::SegmentWriter(const string &directory, Compression codec,
+        long long segmentBytes) : directory(directory), codec(codec),
+        segmentBytes(segmentBytes), fd(-1), size(0), next(0), indexed(false),
+        start(0), pendingCount(0), pendingBytes(0) {
+}
+
+/** Destructor. Commits the outputs still pending. */
+SegmentWriter::~SegmentWriter() {
+    commit();
+    if (fd >= 0)
+        ::close(fd);
+}
+
+/**
+ * Start an output.
+ * 	@param name Name of the output in the index; it may not contain a tab
+ * 	or newline.
+ * 	@return False if the segment could not be created.
+ */
+bool SegmentWriter::open(const string &name) {
+    // A full segment is committed and left behind
+    if (fd >= 0 && size >= segmentBytes) {
+        bool ok = commit();
+        ::close(fd);
+        fd = -1;
+        if (!ok) {
+            out.setstate(ios_base::failbit);
+            return false;
+        }
+    }
+    if (name.find_first_of("\t\n") != string::npos
+            || (fd < 0 && !createSegment())) {
+        out.setstate(ios_base::failbit);
+        return false;
+    }
+    this->name = name;
+    start = size;
+    out.open(fd, codec);
+    return out.good();
+}
+
+/**
+ * Finish the current output. It is pending until the next commit.
+ * 	@param length Set to the size of the output in the segment.
+ * 	@return False if the output could not be written.
+ */
+bool SegmentWriter::close(long long &length) {
+    out.close();
+    if (fd < 0)
+        return false;
+    off_t end = lseek(fd, 0, SEEK_CUR);
+    if (end < 0) {
+        // The segment can no longer be appended to reliably
+        commit();
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    size = end;
+    if (!out)
+        return false;
+
+    length = size - start;
+    char fields[64];
+    snprintf(fields, sizeof(fields), "\t%lld\t%lld\t", start, length);
+    lines += segment + fields + name + "\n";
+    pendingCount++;
+    pendingBytes += length;
+    return true;
+}
+
+/**
+ * Drop the current output. Its bytes stay in the segment but are never
+ * indexed.
+ */
+void SegmentWriter::cancel() {
+    out.close();
+    off_t end = (fd < 0) ? -1 : lseek(fd, 0, SEEK_CUR);
+    if (end >= 0)
+        size = end;
+}
+
+/** True if enough outputs are pending that they should be committed. */
+bool SegmentWriter::due() const {
+    return pendingCount >= COMMIT_OUTPUTS || pendingBytes >= COMMIT_BYTES
+            || (pendingCount > 0 && size >= segmentBytes);
+}
+
+/**
+ * Flush the pending outputs to disk and add them to the index.
+ * 	@return False if they could not be made durable.
+ */
+bool SegmentWriter::commit() {
+    if (pendingCount == 0)
+        return true;
+    string text;
+    text.swap(lines);
+    pendingCount = 0;
+    pendingBytes = 0;
+    if (fdatasync(fd) != 0)
+        return false;
+
+    // A single append, so lines of concurrent writers do not interleave
+    string path = directory + "/" + SegmentIndex::FILENAME;
+    int index = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (index < 0)
+        return false;
+    // A line torn by a crash is ended with a tab, which no name contains,
+    // so that it is not read as an entry
+    struct stat info;
+    char last = '\n';
+    if (fstat(index, &info) == 0 && info.st_size > 0
+            && pread(index, &last, 1, info.st_size - 1) == 1 && last != '\n')
+        text.insert(0, "\t\n");
+    bool ok = writeAll(index, text.data(), text.size()) && fsync(index) == 0;
+    ok = (::close(index) == 0) && ok;
+    if (ok && !indexed)
+        ok = indexed = syncPath(directory);
+    return ok;
+}
+
+/** Create the next free segment. */
+bool SegmentWriter::createSegment() {
+    while (true) {
+        segment = SegmentIndex::segmentName(next++);
+        string path = directory + "/" + segment;
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+        if (fd >= 0)
+            break;
+        if (errno != EEXIST)
+            return false;
+    }
+    size = 0;
+    return syncPath(directory);
+}
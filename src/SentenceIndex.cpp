@@ -0,0 +1,245 @@
+/*
+ * SentenceIndex.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#include <fstream>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "DocumentSerializer.h"
+#include "FileUtil.h"
+#include "SentenceIndex.h"
+
+using namespace std;
+using namespace processors;
+
+/* Layout of the index file: a header followed by the offsets */
+struct SentenceIndex::Header {
+    char magic[4];
+    uint32_t version;
+    uint64_t fileSize;  /* Size of the annotation */
+    int64_t modified;   /* Modification time of the annotation, in ns */
+    uint64_t sentences;
+};
+
+const string SentenceIndex::MAGIC = "SWSX";
+const uint32_t SentenceIndex::VERSION = 1;
+const string SentenceIndex::SUFFIX = ".sidx";
+
+/**
+ * Size and modification time of a file.
+ * 	@return False if the file cannot be read.
+ */
+static bool stamp(const string &path, uint64_t &size, int64_t &modified) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0)
+        return false;
+    size = info.st_size;
+    modified = modifiedNanos(info);
+    return true;
+}
+
+/**
+ * Find the next line.
+ * 	@param cursor Start of the line; advanced past its newline.
+ * 	@param end One past the end of the text.
+ * 	@return The line, without its newline.
+ */
+static StringRef nextLine(const char *&cursor, const char *end) {
+    const char *start = cursor;
+    const char *newline = (const char *) memchr(start, '\n', end - start);
+    cursor = (newline == NULL) ? end : newline + 1;
+    return StringRef(start, (newline == NULL ? end : newline) - start);
+}
+
+/**
+ * True if a line starts with a marker followed by a separator.
+ */
+static bool startsWith(const StringRef &line, const string &marker) {
+    return line.length > marker.size()
+            && line.data[marker.size()] == DocumentSerializer::SEP
+            && StringRef(line.data, marker.size()).equals(marker);
+}
+
+/** Constructor for an empty index. */
+SentenceIndex::SentenceIndex() : mapping(NULL), offsets(NULL), count(0) {
+}
+
+/** Destructor. */
+SentenceIndex::~SentenceIndex() {
+    clear();
+}
+
+/** Drop the offsets and any mapping. */
+void SentenceIndex::clear() {
+    delete mapping;
+    mapping = NULL;
+    built.clear();
+    offsets = NULL;
+    count = 0;
+}
+
+/**
+ * Index an annotation by scanning it once. Only the line structure is
+ * looked at: the token lines of each sentence are skipped by count, and the
+ * sentence runs up to its EOS line. As in the loader, a line ends the
+ * sentence if its first field is EOS, whatever fields follow.
+ * 	@param file The mapped annotation.
+ * 	@return False if the annotation is not in the text format or is
+ * 	truncated.
+ */
+bool SentenceIndex::build(const MappedFile &file) {
+    clear();
+    const char *begin = file.begin();
+    const char *end = file.end();
+    const char *cursor = begin;
+    if (!startsWith(nextLine(cursor, end), DocumentSerializer::START_SENTENCES))
+        return false;
+
+    while (cursor < end) {
+        const char *start = cursor;
+        StringRef line = nextLine(cursor, end);
+        if (line.equals(DocumentSerializer::END_OF_DOCUMENT))
+            break;
+        if (line.length == 0)
+            continue;
+        if (!startsWith(line, DocumentSerializer::START_TOKENS))
+            return false;
+
+        // Token lines first, then anything up to the end of the sentence
+        size_t skip = DocumentSerializer::START_TOKENS.size() + 1;
+        int tokens = parseInt(StringRef(line.data + skip, line.length - skip));
+        for (int i = 0; i < tokens && cursor < end; i++)
+            nextLine(cursor, end);
+        bool closed = false;
+        while (!closed && cursor < end) {
+            StringRef next = nextLine(cursor, end);
+            closed = next.equals(DocumentSerializer::END_OF_SENTENCE)
+                    || startsWith(next, DocumentSerializer::END_OF_SENTENCE);
+        }
+        if (!closed)
+            return false;
+        built.push_back(start - begin);
+        built.push_back(cursor - begin);
+    }
+    count = built.size() / 2;
+    offsets = built.empty() ? NULL : &built[0];
+    return true;
+}
+
+/**
+ * Write the index to the sidecar of an annotation. The index is written to
+ * a temporary file first and renamed into place.
+ * 	@param annotation Path of the annotation that was indexed.
+ * 	@return False if the sidecar could not be written.
+ */
+bool SentenceIndex::save(const string &annotation) const {
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAGIC.data(), sizeof(header.magic));
+    header.version = VERSION;
+    header.sentences = count;
+    if (!stamp(annotation, header.fileSize, header.modified))
+        return false;
+
+    string filename = annotation + SUFFIX;
+    char pid[32];
+    snprintf(pid, sizeof(pid), ".tmp.%d", (int) getpid());
+    string temporary = filename + pid;
+    ofstream out(temporary.c_str(), ios::binary);
+    out.write((const char *) &header, sizeof(header));
+    if (count > 0)
+        out.write((const char *) offsets, 2 * count * sizeof(uint64_t));
+    out.close();
+    if (!out || rename(temporary.c_str(), filename.c_str()) != 0) {
+        unlink(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Map the sidecar of an annotation.
+ * 	@param annotation Path of the annotation.
+ * 	@return False if there is no sidecar, or it is corrupt or older than the
+ * 	annotation.
+ */
+bool SentenceIndex::load(const string &annotation) {
+    clear();
+    uint64_t size;
+    int64_t modified;
+    if (!stamp(annotation, size, modified))
+        return false;
+    mapping = new MappedFile(annotation + SUFFIX);
+    if (!mapping->is_open() || mapping->size() < sizeof(Header)) {
+        clear();
+        return false;
+    }
+
+    Header header;
+    memcpy(&header, mapping->begin(), sizeof(header));
+    if (memcmp(header.magic, MAGIC.data(), sizeof(header.magic)) != 0
+            || header.version != VERSION || header.fileSize != size
+            || header.modified != modified
+            || header.sentences > (mapping->size() - sizeof(Header))
+                    / (2 * sizeof(uint64_t))) {
+        clear();
+        return false;
+    }
+    // The offsets are only checked against the annotation when used, so
+    // loading costs the same for any size
+    count = header.sentences;
+    offsets = (const uint64_t *) (mapping->begin() + sizeof(Header));
+    return true;
+}
+
+/**
+ * Load the sidecar of an annotation, or index the annotation in memory if
+ * there is no up-to-date sidecar.
+ * 	@param annotation Path of the annotation.
+ * 	@param file The mapped annotation.
+ * 	@return False if the annotation could not be indexed.
+ */
+bool SentenceIndex::open(const string &annotation, const MappedFile &file) {
+    return load(annotation) || build(file);
+}
+
+/**
+ * Parse a range of sentences: "N" for one sentence, "N-M" for sentences N
+ * to M inclusive, or "N-" for sentence N to the end (numbered from 0).
+ * 	@param text The range.
+ * 	@param first Set to the first sentence of the range.
+ * 	@param last Set to one past the last sentence of the range, or -1 for
+ * 	the end of the document.
+ * 	@return False if the range is malformed.
+ */
+bool SentenceIndex::parseRange(const string &text, int &first, int &last) {
+    char *rest;
+    long from = strtol(text.c_str(), &rest, 10);
+    if (rest == text.c_str() || from < 0 || from >= INT_MAX)
+        return false;
+    first = (int) from;
+    if (*rest == '\0') {
+        last = first + 1;
+        return true;
+    }
+    if (*rest++ != '-')
+        return false;
+    if (*rest == '\0') {
+        last = -1;
+        return true;
+    }
+    const char *start = rest;
+    long to = strtol(start, &rest, 10);
+    if (rest == start || *rest != '\0' || to < from || to >= INT_MAX)
+        return false;
+    last = (int) to + 1;
+    return true;
+}
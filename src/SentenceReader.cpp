@@ -0,0 +1,114 @@
+/*
+ * SentenceReader.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#include <algorithm>
+#include <assert.h>
+
+#include "DocumentSerializer.h"
+#include "SentenceReader.h"
+
+using namespace std;
+using namespace processors;
+
+/**
+ * Constructor. Reads the document header from the stream.
+ * 	@param stream The input stream.
+ */
+SentenceReader::SentenceReader(istream &stream) :
+        lines(new StreamLineReader(stream, DocumentSerializer::SEP)),
+        sentCount(0), offset(0), base(0),
+        columns(DocumentSerializer::COLUMN_ALL) {
+    readHeader();
+}
+
+/**
+ * Constructor. Reads the document header from the mapped file.
+ * 	@param file The mapped file.
+ */
+SentenceReader::SentenceReader(const MappedFile &file) :
+        lines(new MappedLineReader(file, DocumentSerializer::SEP)),
+        sentCount(0), offset(0), base(0),
+        columns(DocumentSerializer::COLUMN_ALL) {
+    readHeader();
+}
+
+/**
+ * Constructor. Reads a range of sentences of the mapped file, starting
+ * straight at the first one; nothing before it is read.
+ * 	@param file The mapped file.
+ * 	@param index The sentence index of the file.
+ * 	@param first First sentence to read.
+ * 	@param last One past the last sentence to read, or -1 for the end of the
+ * 	document; clamped to the size of the index.
+ */
+SentenceReader::SentenceReader(const MappedFile &file,
+        const SentenceIndex &index, int first, int last) :
+        lines(NULL), sentCount(0), offset(0), base(first),
+        columns(DocumentSerializer::COLUMN_ALL) {
+    int size = (int) index.size();
+    if (last < 0 || last > size)
+        last = size;
+    uint64_t begin = file.size(), end = file.size();
+    if (first < last) {
+        begin = index.begin(first);
+        end = index.end(last - 1);
+    }
+
+    // An index that does not fit the file reads nothing
+    if (begin <= end && end <= file.size()) {
+        sentCount = max(last - first, 0);
+    } else {
+        begin = end = file.size();
+    }
+    lines = new MappedLineReader(file.begin() + begin, file.begin() + end,
+            DocumentSerializer::SEP);
+}
+
+/**
+ * Constructor. Reads sentences from part of a mapped document that starts at
+ * the "T" line of a sentence, without a document header.
+ * 	@param begin Start of the first sentence.
+ * 	@param end One past the end of the last sentence.
+ * 	@param count Number of sentences to read.
+ * 	@param first Position in the document of the first sentence.
+ */
+SentenceReader::SentenceReader(const char *begin, const char *end, int count,
+        int first) :
+        lines(new MappedLineReader(begin, end, DocumentSerializer::SEP)),
+        sentCount(count), offset(0), base(first),
+        columns(DocumentSerializer::COLUMN_ALL) {
+}
+
+/** Destructor. */
+SentenceReader::~SentenceReader() {
+    delete lines;
+}
+
+/**
+ * Read the header line with the sentence count.
+ */
+void SentenceReader::readHeader() {
+    // First line from the stream should be start of sentences
+    lines->nextFields(fields);
+    assert(fields.size() >= 2
+            && fields.at(0).equals(DocumentSerializer::START_SENTENCES));
+    sentCount = parseInt(fields.at(1));
+}
+
+/**
+ * Load the next sentence, reusing the storage of the given one.
+ * 	@param sentence Overwritten with the next sentence.
+ * 	@return False once all sentences have been read.
+ */
+bool SentenceReader::next(Sentence &sentence) {
+    if (offset >= sentCount)
+        return false;
+    DocumentSerializer::loadSentence(*lines, fields, buffers, columns,
+            sentence);
+    offset += 1;
+    return true;
+}
@@ -0,0 +1,394 @@
+/*
+ * SrlCache.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#include <algorithm>
+#include <vector>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "SrlCache.h"
+
+using namespace std;
+using namespace processors;
+
+/* Layout of the index file: a header followed by the slots */
+struct SrlCache::Header {
+    char magic[4];
+    uint32_t version;
+    uint64_t capacity;  /* Number of slots, a power of two */
+    uint64_t count;     /* Number of used slots */
+    uint64_t hits;
+    uint64_t misses;
+    uint32_t stale;     /* Set once the index was replaced by a bigger one */
+    uint32_t reserved;
+};
+
+/* One entry of the index; a hash of 0 marks an empty slot */
+struct SrlCache::Slot {
+    uint64_t hash;
+    uint64_t offset;    /* Start of the record in the data log */
+    uint64_t length;    /* Length of the whole record */
+};
+
+/* Each record in the data log: key length, value length, key, value */
+static const size_t RECORD_HEADER = 2 * sizeof(uint32_t);
+
+static const char INDEX_MAGIC[4] = { 'S', 'W', 'R', 'C' };
+static const uint32_t INDEX_VERSION = 1;
+static const uint64_t INITIAL_CAPACITY = 1 << 16;
+
+/**
+ * 64-bit FNV-1a hash with a final avalanche step; never returns 0.
+ */
+static uint64_t hashBytes(const string &bytes) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < bytes.size(); i++) {
+        hash ^= (unsigned char) bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return (hash == 0) ? 1 : hash;
+}
+
+/**
+ * Size in bytes of an index file with the given number of slots.
+ */
+static size_t indexBytes(uint64_t capacity) {
+    return sizeof(SrlCache::Header) + capacity * sizeof(SrlCache::Slot);
+}
+
+/**
+ * Create an empty index file of the given capacity.
+ */
+static bool createIndex(int fd, uint64_t capacity) {
+    if (ftruncate(fd, indexBytes(capacity)) != 0)
+        return false;
+    SrlCache::Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header.version = INDEX_VERSION;
+    header.capacity = capacity;
+    return pwrite(fd, &header, sizeof(header), 0) == (ssize_t) sizeof(header);
+}
+
+/**
+ * Constructor. Opens (or creates) the cache; check is_open().
+ * 	@param directory Directory holding the cache files.
+ * 	@param identity Prefix for every key, e.g. a fingerprint of the models,
+ * 	so that output from other models is never replayed.
+ */
+SrlCache::SrlCache(const string &directory, const string &identity) :
+        path(directory), prefix(identity), owner(0), indexFd(-1),
+        dataFd(-1), header(NULL), indexSize(0), data(NULL), dataSize(0) {
+    mkdir(path.c_str(), 0755);
+    open();
+}
+
+/** Destructor. */
+SrlCache::~SrlCache() {
+    close();
+}
+
+/**
+ * Open the cache files, creating them if needed.
+ */
+bool SrlCache::open() {
+    string indexPath = path + "/index";
+    string dataPath = path + "/data";
+    owner = getpid();
+
+    indexFd = ::open(indexPath.c_str(), O_RDWR | O_CREAT, 0644);
+    if (indexFd < 0)
+        return false;
+    dataFd = ::open(dataPath.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (dataFd < 0) {
+        close();
+        return false;
+    }
+
+    // Initialize a new index under the lock, so only one process does it
+    struct stat info;
+    flock(indexFd, LOCK_EX);
+    bool ok = fstat(indexFd, &info) == 0
+            && (info.st_size > 0 || createIndex(indexFd, INITIAL_CAPACITY))
+            && fstat(indexFd, &info) == 0;
+    flock(indexFd, LOCK_UN);
+    if (!ok || info.st_size < (off_t) sizeof(Header)) {
+        close();
+        return false;
+    }
+
+    void *addr = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+            indexFd, 0);
+    if (addr == MAP_FAILED) {
+        close();
+        return false;
+    }
+    header = (Header *) addr;
+    indexSize = info.st_size;
+    if (memcmp(header->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0
+            || header->version != INDEX_VERSION
+            || indexBytes(header->capacity) != indexSize) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Release the mappings and file descriptors.
+ */
+void SrlCache::close() {
+    if (header != NULL)
+        munmap(header, indexSize);
+    if (data != NULL)
+        munmap((void *) data, dataSize);
+    if (indexFd >= 0)
+        ::close(indexFd);
+    if (dataFd >= 0)
+        ::close(dataFd);
+    header = NULL;
+    data = NULL;
+    indexSize = dataSize = 0;
+    indexFd = dataFd = -1;
+}
+
+/**
+ * Reopen the index if it was replaced by a bigger one, or if this process
+ * is a fork of the one that opened it (locks are per open file).
+ */
+bool SrlCache::refresh() {
+    if (header != NULL && owner == getpid() && !header->stale)
+        return true;
+    close();
+    return open();
+}
+
+/**
+ * Map enough of the data log to read [0, size).
+ */
+bool SrlCache::mapData(uint64_t size) {
+    if (size <= dataSize)
+        return true;
+    struct stat info;
+    if (fstat(dataFd, &info) != 0 || (uint64_t) info.st_size < size)
+        return false;
+    if (data != NULL)
+        munmap((void *) data, dataSize);
+    void *addr = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, dataFd, 0);
+    if (addr == MAP_FAILED) {
+        data = NULL;
+        dataSize = 0;
+        return false;
+    }
+    data = (const char *) addr;
+    dataSize = info.st_size;
+    return true;
+}
+
+/**
+ * Find the slot holding a key, or the empty slot where it belongs.
+ */
+SrlCache::Slot *SrlCache::find(const string &qualified, uint64_t hash) {
+    Slot *slots = (Slot *) (header + 1);
+    uint64_t mask = header->capacity - 1;
+    for (uint64_t i = hash & mask;; i = (i + 1) & mask) {
+        Slot *slot = &slots[i];
+        if (slot->hash == 0)
+            return slot;
+        if (slot->hash != hash || !mapData(slot->offset + slot->length))
+            continue;
+        const char *record = data + slot->offset;
+        uint32_t keyLength;
+        memcpy(&keyLength, record, sizeof(keyLength));
+        if (keyLength == qualified.size() && memcmp(record + RECORD_HEADER,
+                qualified.data(), keyLength) == 0)
+            return slot;
+    }
+}
+
+/**
+ * Look up the output for an input line and count a hit or a miss.
+ * 	@param key The SwiRL input line.
+ * 	@param value Set to the cached output on a hit.
+ * 	@return True on a hit.
+ */
+bool SrlCache::lookup(const string &key, string &value) {
+    // Lock an index that is current (it may be replaced while we wait)
+    do {
+        if (!refresh())
+            return false;
+        flock(indexFd, LOCK_SH);
+        if (!header->stale)
+            break;
+        flock(indexFd, LOCK_UN);
+    } while (true);
+
+    string qualified = prefix + "\n" + key;
+    uint64_t hash = hashBytes(qualified);
+    Slot *slot = find(qualified, hash);
+    bool hit = (slot->hash != 0);
+    if (hit) {
+        const char *record = data + slot->offset;
+        uint32_t valueLength;
+        memcpy(&valueLength, record + sizeof(uint32_t), sizeof(valueLength));
+        value.assign(record + RECORD_HEADER + qualified.size(), valueLength);
+        __sync_fetch_and_add(&header->hits, 1);
+    } else {
+        __sync_fetch_and_add(&header->misses, 1);
+    }
+    flock(indexFd, LOCK_UN);
+    return hit;
+}
+
+/**
+ * Store the output for an input line.
+ * 	@param key The SwiRL input line.
+ * 	@param value SwiRL's output for it.
+ * 	@return False if the cache could not be written.
+ */
+bool SrlCache::insert(const string &key, const string &value) {
+    do {
+        if (!refresh())
+            return false;
+        flock(indexFd, LOCK_EX);
+        if (!header->stale)
+            break;
+        flock(indexFd, LOCK_UN);
+    } while (true);
+
+    string qualified = prefix + "\n" + key;
+    uint64_t hash = hashBytes(qualified);
+    Slot *slot = find(qualified, hash);
+    bool ok = true;
+    if (slot->hash == 0) {
+        // Append the record, then publish it in the index
+        uint32_t lengths[2] = { (uint32_t) qualified.size(),
+                (uint32_t) value.size() };
+        string record((const char *) lengths, RECORD_HEADER);
+        record += qualified;
+        record += value;
+        off_t offset = lseek(dataFd, 0, SEEK_END);
+        ok = offset >= 0 && write(dataFd, record.data(), record.size())
+                == (ssize_t) record.size();
+        if (ok) {
+            slot->offset = offset;
+            slot->length = record.size();
+            slot->hash = hash;
+            header->count++;
+            if (header->count * 10 > header->capacity * 7)
+                ok = grow();
+        }
+    }
+    flock(indexFd, LOCK_UN);
+    return ok;
+}
+
+/**
+ * Replace the index with one twice as large.
+ * Precondition: the exclusive lock is held.
+ */
+bool SrlCache::grow() {
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".%d", (int) getpid());
+    string indexPath = path + "/index";
+    string tempPath = indexPath + suffix;
+
+    uint64_t capacity = header->capacity * 2;
+    int fd = ::open(tempPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return false;
+    void *addr = MAP_FAILED;
+    if (createIndex(fd, capacity))
+        addr = mmap(NULL, indexBytes(capacity), PROT_READ | PROT_WRITE,
+                MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        ::close(fd);
+        unlink(tempPath.c_str());
+        return false;
+    }
+
+    // Re-insert every entry; the hashes are stored, so no key is reread
+    Header *bigger = (Header *) addr;
+    Slot *from = (Slot *) (header + 1);
+    Slot *to = (Slot *) (bigger + 1);
+    for (uint64_t i = 0; i < header->capacity; i++) {
+        if (from[i].hash == 0)
+            continue;
+        uint64_t j = from[i].hash & (capacity - 1);
+        while (to[j].hash != 0)
+            j = (j + 1) & (capacity - 1);
+        to[j] = from[i];
+    }
+    bigger->count = header->count;
+    bigger->hits = header->hits;
+    bigger->misses = header->misses;
+    munmap(addr, indexBytes(capacity));
+    ::close(fd);
+
+    if (rename(tempPath.c_str(), indexPath.c_str()) != 0) {
+        unlink(tempPath.c_str());
+        return false;
+    }
+    // Everyone still using the old index reopens on their next access
+    header->stale = 1;
+    return true;
+}
+
+/** Total hits recorded in the cache, over all processes and runs. */
+uint64_t SrlCache::hits() const {
+    return (header != NULL) ? header->hits : 0;
+}
+
+/** Total misses recorded in the cache, over all processes and runs. */
+uint64_t SrlCache::misses() const {
+    return (header != NULL) ? header->misses : 0;
+}
+
+/**
+ * Fingerprint of a directory (names, sizes and modification times of its
+ * files), to tell different model directories apart.
+ * 	@param directory The directory.
+ * 	@return A hex string; empty if the directory cannot be read.
+ */
+string SrlCache::fingerprint(const string &directory) {
+    DIR *dir = opendir(directory.c_str());
+    if (dir == NULL)
+        return "";
+    vector<string> names;
+    dirent *entry;
+    while ((entry = readdir(dir)) != 0) {
+        string name = entry->d_name;
+        if (name != "." && name != "..")
+            names.push_back(name);
+    }
+    closedir(dir);
+    sort(names.begin(), names.end());
+
+    string listing;
+    char line[64];
+    for (unsigned int i = 0; i < names.size(); i++) {
+        struct stat info;
+        if (stat((directory + "/" + names[i]).c_str(), &info) != 0)
+            continue;
+        snprintf(line, sizeof(line), " %lld %lld\n", (long long) info.st_size,
+                (long long) info.st_mtime);
+        listing += names[i] + line;
+    }
+    snprintf(line, sizeof(line), "%016llx",
+            (unsigned long long) hashBytes(listing));
+    return line;
+}
@@ -0,0 +1,195 @@
+/*
+ * SrlExtractor.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#include <stdio.h>
+
+#include "SrlExtractor.h"
+
+using namespace std;
+using namespace processors;
+
+/* Lemma column of a token that is not a predicate */
+static const string NO_PREDICATE = "-";
+
+/* Label of the span of the predicate itself */
+static const string VERB = "V";
+
+/**
+ * Split a line into fields on runs of spaces and tabs.
+ */
+static void splitFields(const string &line, vector<string> &fields) {
+    fields.clear();
+    string::size_type start = line.find_first_not_of(" \t");
+    while (start != string::npos) {
+        string::size_type end = line.find_first_of(" \t", start);
+        fields.push_back(line.substr(start, end - start));
+        start = (end == string::npos) ? end
+                : line.find_first_not_of(" \t", end);
+    }
+}
+
+/**
+ * Extract the predicates from SwiRL's output for a sentence.
+ * 	@param output The output.
+ * 	@param predicates Overwritten with the predicates, in token order.
+ * 	@return False if the output is malformed; the predicates found up to
+ * 	that point are kept.
+ */
+bool SrlExtractor::extract(const string &output,
+        vector<SrlPredicate> &predicates) {
+    predicates.clear();
+    vector<vector<string> > rows;
+    int offset = 0;
+    string::size_type start = 0;
+    while (start < output.size()) {
+        string::size_type end = output.find('\n', start);
+        if (end == string::npos)
+            end = output.size();
+        string line = output.substr(start, end - start);
+        start = end + 1;
+
+        if (line.empty() || line.find_first_not_of(" \t") == string::npos) {
+            // A blank line ends a table
+            if (!rows.empty()) {
+                if (!extractTable(rows, offset, predicates))
+                    return false;
+                offset += rows.size();
+                rows.clear();
+            }
+        } else if (rows.empty() && line[0] == '#') {
+            // A chunk line gives the offset of the chunk's table
+            int begin;
+            if (sscanf(line.c_str(), "# chunk %d-", &begin) == 1)
+                offset = begin;
+        } else if (rows.empty() && isTree(line)) {
+            continue;
+        } else {
+            rows.push_back(vector<string>());
+            splitFields(line, rows.back());
+        }
+    }
+    return rows.empty() || extractTable(rows, offset, predicates);
+}
+
+/**
+ * Extract the predicates of one CoNLL table.
+ * 	@param rows The fields of each row.
+ * 	@param offset Offset of the first row in the sentence.
+ * 	@param predicates The predicates are appended to it.
+ * 	@return False if the table is malformed.
+ */
+bool SrlExtractor::extractTable(const vector<vector<string> > &rows,
+        int offset, vector<SrlPredicate> &predicates) {
+    size_t columns = rows[0].size();
+    for (unsigned int i = 1; i < rows.size(); i++) {
+        if (rows[i].size() != columns)
+            return false;
+    }
+    if (columns < 2)
+        return false;
+
+    // The predicate columns are the trailing ones in bracket notation; the
+    // lemmas come just before them, after at least the words
+    size_t lemmas = columns - 1;
+    while (lemmas > 1) {
+        bool brackets = true;
+        for (unsigned int i = 0; i < rows.size() && brackets; i++)
+            brackets = isBracket(rows[i][lemmas]);
+        if (!brackets)
+            break;
+        lemmas--;
+    }
+    vector<int> marked;
+    for (unsigned int i = 0; i < rows.size(); i++) {
+        if (rows[i][lemmas] != NO_PREDICATE)
+            marked.push_back(i);
+    }
+
+    for (size_t column = lemmas + 1; column < columns; column++) {
+        SrlPredicate predicate;
+        predicate.token = -1;
+        int open = -1;
+        string label;
+        for (unsigned int i = 0; i < rows.size(); i++) {
+            const string &cell = rows[i][column];
+            string::size_type star = cell.find('*');
+            if (cell[0] == '(') {
+                if (open >= 0)
+                    return false;
+                open = i;
+                label = cell.substr(1, star - 1);
+            }
+            if (star + 1 < cell.size()) {
+                if (open < 0)
+                    return false;
+                if (label == VERB) {
+                    if (predicate.token < 0)
+                        predicate.token = open;
+                } else {
+                    SrlArgument argument;
+                    argument.label = SymbolTable::roles().intern(label);
+                    argument.startOffset = offset + open;
+                    argument.endOffset = offset + i + 1;
+                    predicate.arguments.push_back(argument);
+                }
+                open = -1;
+            }
+        }
+        if (open >= 0)
+            return false;
+
+        // Without a verb span, fall back on the rows marked with a lemma
+        size_t index = column - lemmas - 1;
+        if (predicate.token < 0) {
+            if (marked.size() != columns - lemmas - 1)
+                return false;
+            predicate.token = marked[index];
+        }
+        predicate.lemma = rows[predicate.token][lemmas];
+        predicate.token += offset;
+        predicates.push_back(predicate);
+    }
+    return true;
+}
+
+/**
+ * True if a line is an extended Treebank tree: a single bracketed
+ * constituent.
+ */
+bool SrlExtractor::isTree(const string &line) {
+    string::size_type last = line.find_last_not_of(" \t");
+    if (line[0] != '(' || line[last] != ')')
+        return false;
+    int depth = 0;
+    for (string::size_type i = 0; i <= last; i++) {
+        if (line[i] == '(') {
+            depth++;
+        } else if (line[i] == ')') {
+            depth--;
+            if (depth == 0 && i != last)
+                return false;
+        }
+    }
+    return depth == 0;
+}
+
+/**
+ * True if a cell is in bracket notation: an optional "(LABEL" opening a
+ * span, a "*", and an optional "LABEL)" or ")" closing it.
+ */
+bool SrlExtractor::isBracket(const string &cell) {
+    string::size_type star = cell.find('*');
+    if (star == string::npos || cell.find('*', star + 1) != string::npos)
+        return false;
+    if (star > 0 && (cell[0] != '(' || star == 1
+            || cell.find_first_of("()", 1) < star))
+        return false;
+    if (star + 1 == cell.size())
+        return true;
+    return cell[cell.size() - 1] == ')'
+            && cell.find_first_of("()", star + 1) == cell.size() - 1;
+}
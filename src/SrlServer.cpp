@@ -0,0 +1,414 @@
+/*
+ * SrlServer.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#include <sstream>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#include "DocumentSerializer.h"
+#include "FileUtil.h"
+#include "SentenceReader.h"
+#include "SrlServer.h"
+
+using namespace std;
+using namespace processors;
+
+/* Largest document accepted in a request */
+const long SrlServer::MAX_DOCUMENT = 256L << 20;
+
+/* Longest header line accepted in a request */
+static const size_t MAX_HEADER = 1024;
+
+/* Seconds an answer may wait for a client that does not read; the client
+ * is then dropped so it cannot stall the others */
+static const int SEND_TIMEOUT = 10;
+
+/* Bytes read from a connection at once */
+static const size_t READ_SIZE = 1 << 16;
+
+/**
+ * A client. It is closed once its reader is done and every item it queued
+ * is answered.
+ */
+struct SrlServer::Connection {
+    SrlServer *server;
+    int in;
+    int out;
+    bool owned;         /* close the descriptors when done */
+    int references;     /* the reader, plus one per queued item */
+    bool broken;        /* answers can no longer be written */
+    string pending;     /* bytes read but not consumed yet */
+};
+
+/**
+ * Read more bytes from a descriptor into a buffer.
+ * 	@return False at the end of the input or on error.
+ */
+static bool fill(int fd, string &buffer) {
+    char chunk[READ_SIZE];
+    for (;;) {
+        ssize_t n = ::read(fd, chunk, sizeof(chunk));
+        if (n > 0) {
+            buffer.append(chunk, n);
+            return true;
+        }
+        if (n < 0 && errno == EINTR)
+            continue;
+        return false;
+    }
+}
+
+/**
+ * Constructor.
+ * 	@param handler Function run for each sentence.
+ * 	@param context Passed through to the handler.
+ * 	@param capacity Sentences that may be queued at once.
+ */
+SrlServer::SrlServer(SentenceHandler handler, void *context,
+        size_t capacity) :
+        handler(handler), context(context), queue(capacity), listener(-1),
+        stopping(false), answered(0), labeled(0) {
+    pthread_mutex_init(&mutex, NULL);
+    pthread_cond_init(&closed, NULL);
+}
+
+/** Destructor. Removes the socket, if any. */
+SrlServer::~SrlServer() {
+    if (listener >= 0) {
+        close(listener);
+        unlink(socketPath.c_str());
+    }
+    pthread_cond_destroy(&closed);
+    pthread_mutex_destroy(&mutex);
+}
+
+/**
+ * Create the Unix domain socket to serve on, replacing a stale one.
+ * 	@param path Path of the socket.
+ * 	@return False if the socket could not be created.
+ */
+bool SrlServer::listen(const string &path) {
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path))
+        return false;
+    memcpy(address.sun_path, path.c_str(), path.size());
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return false;
+
+    // A socket nobody answers on is left over from a previous server
+    if (connect(fd, (sockaddr *) &address, sizeof(address)) == 0) {
+        close(fd);
+        return false;
+    }
+    unlink(path.c_str());
+    if (bind(fd, (sockaddr *) &address, sizeof(address)) != 0
+            || ::listen(fd, SOMAXCONN) != 0) {
+        close(fd);
+        return false;
+    }
+    listener = fd;
+    socketPath = path;
+    return true;
+}
+
+/**
+ * Accept connections on the socket until stop() is called, then answer the
+ * sentences already queued.
+ * 	@return False if the server could not be started.
+ */
+bool SrlServer::serve() {
+    pthread_t labeler;
+    if (listener < 0 || pthread_create(&labeler, NULL, labelThread, this) != 0)
+        return false;
+
+    while (!stopping) {
+        int fd = ::accept(listener, NULL, NULL);
+        if (fd >= 0) {
+            timeval timeout = { SEND_TIMEOUT, 0 };
+            setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout,
+                    sizeof(timeout));
+            if (!accept(fd, fd, true))
+                close(fd);
+        } else if (errno == EMFILE || errno == ENFILE) {
+            usleep(100000);
+        } else if (errno != EINTR && errno != ECONNABORTED) {
+            break;
+        }
+    }
+
+    // Read no more requests, but answer those already queued
+    pthread_mutex_lock(&mutex);
+    for (set<Connection *>::iterator it = connections.begin();
+            it != connections.end(); ++it)
+        shutdown((*it)->in, SHUT_RD);
+    pthread_mutex_unlock(&mutex);
+    drain();
+    queue.close();
+    pthread_join(labeler, NULL);
+    return true;
+}
+
+/**
+ * Serve a single client over a pair of file descriptors, until the input
+ * ends and every request is answered.
+ * 	@param in Descriptor the requests are read from.
+ * 	@param out Descriptor the answers are written to.
+ * 	@return False if the server could not be started.
+ */
+bool SrlServer::serve(int in, int out) {
+    pthread_t labeler;
+    if (pthread_create(&labeler, NULL, labelThread, this) != 0)
+        return false;
+    bool started = accept(in, out, false);
+    drain();
+    queue.close();
+    pthread_join(labeler, NULL);
+    return started;
+}
+
+/** Stop accepting connections. Safe to call from a signal handler. */
+void SrlServer::stop() {
+    stopping = true;
+    if (listener >= 0)
+        shutdown(listener, SHUT_RDWR);
+}
+
+/** Entry point of a reader thread. */
+void *SrlServer::readThread(void *argument) {
+    Connection *connection = (Connection *) argument;
+    connection->server->read(connection);
+    return NULL;
+}
+
+/** Entry point of the labeling thread. */
+void *SrlServer::labelThread(void *argument) {
+    ((SrlServer *) argument)->label();
+    return NULL;
+}
+
+/**
+ * Start a reader thread for a connection.
+ * 	@param in Descriptor the requests are read from.
+ * 	@param out Descriptor the answers are written to.
+ * 	@param owned Close the descriptors once the connection is done.
+ * 	@return False if the thread could not be started.
+ */
+bool SrlServer::accept(int in, int out, bool owned) {
+    Connection *connection = new Connection();
+    connection->server = this;
+    connection->in = in;
+    connection->out = out;
+    connection->owned = owned;
+    connection->references = 1;
+    connection->broken = false;
+
+    pthread_mutex_lock(&mutex);
+    connections.insert(connection);
+    pthread_mutex_unlock(&mutex);
+
+    pthread_t reader;
+    pthread_attr_t attributes;
+    pthread_attr_init(&attributes);
+    pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+    bool started = pthread_create(&reader, &attributes, readThread,
+            connection) == 0;
+    pthread_attr_destroy(&attributes);
+    if (!started) {
+        pthread_mutex_lock(&mutex);
+        connections.erase(connection);
+        pthread_cond_broadcast(&closed);
+        pthread_mutex_unlock(&mutex);
+        delete connection;
+    }
+    return started;
+}
+
+/**
+ * Read requests from a connection until it ends. The sentences of each
+ * request are parsed here, off the labeling thread, and queued one by one.
+ * 	@param connection The connection.
+ */
+void SrlServer::read(Connection *connection) {
+    string &pending = connection->pending;
+    string header, document;
+    Item item;
+    item.connection = connection;
+    bool reading = true;
+    while (reading) {
+        // Header line
+        string::size_type newline;
+        while ((newline = pending.find('\n')) == string::npos
+                && pending.size() <= MAX_HEADER
+                && fill(connection->in, pending))
+            ;
+        if (newline == string::npos) {
+            if (pending.empty())
+                break;
+            item.id = "-";
+            item.error = "malformed request";
+            item.sentence = NULL;
+            item.index = 0;
+        } else {
+            header.assign(pending, 0, newline);
+            pending.erase(0, newline + 1);
+
+            istringstream fields(header);
+            string kind, rest;
+            long bytes = -1;
+            item.id = "-";
+            fields >> kind >> item.id >> bytes;
+            bool valid = !fields.fail() && !(fields >> rest) && kind == "DOC"
+                    && bytes >= 0 && bytes <= MAX_DOCUMENT;
+
+            // Document
+            if (valid) {
+                while ((long) pending.size() < bytes
+                        && fill(connection->in, pending))
+                    ;
+                if ((long) pending.size() < bytes) {
+                    item.error = "truncated request";
+                } else {
+                    document.assign(pending, 0, bytes);
+                    pending.erase(0, bytes);
+                    // The loader asserts on what it does not expect
+                    if (!DocumentSerializer::checkText(document.data(),
+                            document.data() + document.size()))
+                        item.error = "malformed document";
+                }
+            } else {
+                item.error = "malformed request";
+            }
+        }
+
+        // Queue the sentences, then the end of the request
+        if (item.error.empty()) {
+            istringstream stream(document);
+            SentenceReader sentences(stream);
+            item.index = 0;
+            item.sentence = new Sentence();
+            while (reading && sentences.next(*item.sentence)) {
+                pthread_mutex_lock(&mutex);
+                connection->references++;
+                pthread_mutex_unlock(&mutex);
+                reading = queue.push(item);
+                if (reading) {
+                    item.index++;
+                    item.sentence = new Sentence();
+                } else {
+                    release(connection);
+                }
+            }
+            delete item.sentence;
+            item.sentence = NULL;
+            if (!reading)
+                break;
+        } else {
+            reading = false;
+        }
+        pthread_mutex_lock(&mutex);
+        connection->references++;
+        pthread_mutex_unlock(&mutex);
+        if (!queue.push(item)) {
+            release(connection);
+            break;
+        }
+        item.error.clear();
+    }
+    release(connection);
+}
+
+/**
+ * Label queued sentences until the queue is closed and drained.
+ */
+void SrlServer::label() {
+    Item item;
+    while (queue.pop(item)) {
+        answer(item);
+        delete item.sentence;
+        release(item.connection);
+    }
+}
+
+/**
+ * Answer one queued item: label a sentence, or end or reject a request.
+ * Nothing is done for clients that went away.
+ * 	@param item The item.
+ */
+void SrlServer::answer(Item &item) {
+    Connection *connection = item.connection;
+    if (connection->broken)
+        return;
+
+    char header[64];
+    string frame;
+    if (!item.error.empty()) {
+        frame = "ERR " + item.id + " " + item.error + "\n";
+    } else if (item.sentence == NULL) {
+        snprintf(header, sizeof(header), " %d\n", item.index);
+        frame = "END " + item.id + header;
+        answered++;
+    } else {
+        string result;
+        int status = handler(*item.sentence, result, context);
+        labeled++;
+        if (status == 0) {
+            snprintf(header, sizeof(header), " %d %lu\n", item.index,
+                    (unsigned long) result.size());
+            frame = "SENT " + item.id + header + result;
+        } else {
+            snprintf(header, sizeof(header), " %d %d\n", item.index, status);
+            frame = "FAIL " + item.id + header;
+        }
+    }
+    if (!writeAll(connection->out, frame.data(), frame.size())) {
+        // Also stops the reader, so the connection can be closed
+        connection->broken = true;
+        if (connection->owned)
+            shutdown(connection->in, SHUT_RDWR);
+    }
+}
+
+/**
+ * Drop a reference to a connection, closing it with the last one.
+ * 	@param connection The connection.
+ */
+void SrlServer::release(Connection *connection) {
+    pthread_mutex_lock(&mutex);
+    bool done = (--connection->references == 0);
+    if (done) {
+        connections.erase(connection);
+        pthread_cond_broadcast(&closed);
+    }
+    pthread_mutex_unlock(&mutex);
+    if (done) {
+        if (connection->owned) {
+            close(connection->in);
+            if (connection->out != connection->in)
+                close(connection->out);
+        }
+        delete connection;
+    }
+}
+
+/**
+ * Wait until every connection is closed.
+ */
+void SrlServer::drain() {
+    pthread_mutex_lock(&mutex);
+    while (!connections.empty())
+        pthread_cond_wait(&closed, &mutex);
+    pthread_mutex_unlock(&mutex);
+}
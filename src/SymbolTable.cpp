@@ -0,0 +1,139 @@
+/*
+ * SymbolTable.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#include <iostream>
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "DocumentSerializer.h"
+#include "SymbolTable.h"
+
+using namespace std;
+using namespace processors;
+
+/** ID of the NIL label in each of the global tables. */
+const Symbol SymbolTable::NIL_SYMBOL = 0;
+
+/**
+ * FNV-1a hash of a run of characters.
+ */
+static unsigned int hashChars(const char *data, size_t length) {
+    unsigned int hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char) data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * Constructor.
+ * 	@param capacity Maximum number of symbols; names can be looked up
+ * 	concurrently with interning only when this is set.
+ */
+SymbolTable::SymbolTable(size_t capacity) :
+        slots(64, -1), maxSize(capacity) {
+    if (maxSize > 0)
+        names.reserve(maxSize);
+    pthread_mutex_init(&lock, NULL);
+}
+
+/** Destructor. */
+SymbolTable::~SymbolTable() {
+    pthread_mutex_destroy(&lock);
+}
+
+/**
+ * Get the ID of a string, adding it to the table if it is new. Adding a
+ * string to a table that holds its capacity aborts the program.
+ * 	@param data Characters of the string.
+ * 	@param length Number of characters.
+ * 	@return The ID of the string.
+ */
+unsigned int SymbolTable::intern(const char *data, size_t length) {
+    pthread_mutex_lock(&lock);
+    size_t mask = slots.size() - 1;
+    size_t slot = hashChars(data, length) & mask;
+    while (slots[slot] >= 0) {
+        const string &candidate = *names[slots[slot]];
+        if (candidate.size() == length
+                && memcmp(candidate.data(), data, length) == 0) {
+            unsigned int id = slots[slot];
+            pthread_mutex_unlock(&lock);
+            return id;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    // New string. A full table cannot hand out another ID that fits a
+    // Symbol, nor grow under the readers of name(), so the run stops here
+    // whether or not assertions are compiled in
+    if (maxSize > 0 && names.size() >= maxSize) {
+        cerr << "Symbol table full: more than " << maxSize
+                << " distinct labels" << endl;
+        abort();
+    }
+    unsigned int id = names.size();
+    strings.push_back(string(data, length));
+    names.push_back(&strings.back());
+    slots[slot] = id;
+    if (names.size() * 2 > slots.size())
+        grow();
+    pthread_mutex_unlock(&lock);
+    return id;
+}
+
+/**
+ * Double the hash index once it is half full.
+ */
+void SymbolTable::grow() {
+    vector<int> bigger(slots.size() * 2, -1);
+    size_t mask = bigger.size() - 1;
+    for (size_t id = 0; id < names.size(); id++) {
+        size_t slot = hashChars(names[id]->data(), names[id]->size()) & mask;
+        while (bigger[slot] >= 0)
+            slot = (slot + 1) & mask;
+        bigger[slot] = id;
+    }
+    slots.swap(bigger);
+}
+
+/**
+ * Create one of the global label tables, with NIL as its first symbol.
+ */
+static SymbolTable *createLabelTable() {
+    SymbolTable *table = new SymbolTable(65536);
+    Symbol nil = table->intern(string(1, DocumentSerializer::NIL));
+    assert(nil == SymbolTable::NIL_SYMBOL);
+    (void) nil;
+    return table;
+}
+
+/** Global table of POS tags. */
+SymbolTable &SymbolTable::tags() {
+    static SymbolTable *table = createLabelTable();
+    return *table;
+}
+
+/** Global table of named entity labels. */
+SymbolTable &SymbolTable::entities() {
+    static SymbolTable *table = createLabelTable();
+    return *table;
+}
+
+/** Global table of shallow parsing (chunk) labels. */
+SymbolTable &SymbolTable::chunks() {
+    static SymbolTable *table = createLabelTable();
+    return *table;
+}
+
+/** Global table of semantic role labels. */
+SymbolTable &SymbolTable::roles() {
+    static SymbolTable *table = createLabelTable();
+    return *table;
+}
@@ -0,0 +1,364 @@
+/*
+ * WorkerPool.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#include <iostream>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "FileUtil.h"
+#include "Metrics.h"
+#include "WorkerPool.h"
+
+using namespace std;
+using namespace processors;
+
+/** Status reported for a task whose worker died while running it. */
+const int WorkerPool::WORKER_DIED = -1;
+
+/** Status reported for a task that ran out of time. */
+const int WorkerPool::TIMED_OUT = -2;
+
+/**
+ * Read exactly the requested number of bytes from a file descriptor.
+ * 	@return False on error or end of file.
+ */
+static bool readAll(int fd, char *data, size_t length) {
+    while (length > 0) {
+        ssize_t n = read(fd, data, length);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (n == 0)
+            return false;
+        data += n;
+        length -= n;
+    }
+    return true;
+}
+
+/**
+ * Write one message: a fixed header followed by a payload.
+ *
+ * A write to a pipe whose reader is gone raises SIGPIPE, which would kill
+ * the writer. Instead of ignoring the signal for the whole process, it is
+ * blocked on this thread for the duration of the write, so the write fails
+ * with EPIPE; a SIGPIPE that the write raised is consumed before the mask
+ * is restored, and one that was already pending is left alone.
+ */
+static bool writeMessage(int fd, int64_t id, int32_t status,
+        const string &payload) {
+    sigset_t pipeSignal, previous, pending;
+    sigemptyset(&pipeSignal);
+    sigaddset(&pipeSignal, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipeSignal, &previous);
+    sigpending(&pending);
+    bool wasPending = sigismember(&pending, SIGPIPE);
+
+    int64_t header[3] = { id, status, (int64_t) payload.size() };
+    bool ok = writeAll(fd, (const char *) header, sizeof(header))
+            && writeAll(fd, payload.data(), payload.size());
+
+    if (!ok && errno == EPIPE && !wasPending) {
+        struct timespec zero = { 0, 0 };
+        while (sigtimedwait(&pipeSignal, NULL, &zero) < 0
+                && errno == EINTR) { }
+    }
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+    return ok;
+}
+
+/**
+ * Read one message written by writeMessage().
+ */
+static bool readMessage(int fd, int64_t &id, int32_t &status,
+        string &payload) {
+    int64_t header[3];
+    if (!readAll(fd, (char *) header, sizeof(header)))
+        return false;
+    id = header[0];
+    status = (int32_t) header[1];
+    payload.resize(header[2]);
+    return header[2] == 0 || readAll(fd, &payload[0], header[2]);
+}
+
+/**
+ * Constructor.
+ * 	@param workers Number of worker processes.
+ * 	@param handler Function run by the workers for each task.
+ * 	@param context Passed through to the handler.
+ */
+WorkerPool::WorkerPool(int workers, TaskHandler handler, void *context) :
+        count(workers), handler(handler), context(context), running(0),
+        failures(0), timeout(0) {
+}
+
+/** Destructor. Shuts down the workers if needed. */
+WorkerPool::~WorkerPool() {
+    shutdown();
+}
+
+/**
+ * Fork the workers.
+ * 	@return False if the pipes or processes could not be created.
+ */
+bool WorkerPool::start() {
+    workers.resize(count);
+    for (int i = 0; i < count; i++) {
+        workers[i].pid = -1;
+        workers[i].taskFd = workers[i].resultFd = -1;
+        workers[i].busy = false;
+    }
+    for (int i = 0; i < count; i++) {
+        if (!spawn(i))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Fork one worker into the given slot.
+ */
+bool WorkerPool::spawn(int slot) {
+    int taskPipe[2], resultPipe[2];
+    if (pipe(taskPipe) != 0)
+        return false;
+    if (pipe(resultPipe) != 0) {
+        close(taskPipe[0]);
+        close(taskPipe[1]);
+        return false;
+    }
+
+    // Buffered output would otherwise be written once per process
+    cout.flush();
+    cerr.flush();
+    fflush(NULL);
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(taskPipe[0]);
+        close(taskPipe[1]);
+        close(resultPipe[0]);
+        close(resultPipe[1]);
+        return false;
+    }
+
+    if (pid == 0) {
+        // Worker: drop the parent's ends of every pipe
+        close(taskPipe[1]);
+        close(resultPipe[0]);
+        for (unsigned int i = 0; i < workers.size(); i++) {
+            if (workers[i].pid > 0) {
+                close(workers[i].taskFd);
+                close(workers[i].resultFd);
+            }
+        }
+        serve(taskPipe[0], resultPipe[1]);
+    }
+
+    close(taskPipe[0]);
+    close(resultPipe[1]);
+    Worker &worker = workers[slot];
+    worker.pid = pid;
+    worker.taskFd = taskPipe[1];
+    worker.resultFd = resultPipe[0];
+    worker.busy = false;
+    return true;
+}
+
+/**
+ * Main loop of a worker process; never returns.
+ */
+void WorkerPool::serve(int taskFd, int resultFd) {
+    int64_t id;
+    int32_t status;
+    string task, result;
+    while (readMessage(taskFd, id, status, task)) {
+        result.clear();
+        status = handler(task, result, context);
+        if (!writeMessage(resultFd, id, status, result))
+            break;
+    }
+    cout.flush();
+    cerr.flush();
+    _exit(0);
+}
+
+/**
+ * Send a task to an idle worker.
+ * 	@param id Identifier reported back with the result.
+ * 	@param task The task.
+ * 	@return False if no worker is idle.
+ */
+bool WorkerPool::submit(long id, const string &task) {
+    for (unsigned int i = 0; i < workers.size(); i++) {
+        Worker &worker = workers[i];
+        if (worker.pid <= 0 || worker.busy)
+            continue;
+        if (!writeMessage(worker.taskFd, id, 0, task)) {
+            retire(worker);
+            continue;
+        }
+        worker.busy = true;
+        worker.task = id;
+        worker.started = Metrics::now();
+        running++;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Wait for the next task to complete.
+ * 	@param id Set to the identifier of the completed task.
+ * 	@param status Set to the status returned by the handler, or
+ * 	WORKER_DIED.
+ * 	@param result Set to the bytes returned by the handler.
+ * 	@return False if no task is running.
+ */
+bool WorkerPool::collect(long &id, int &status, string &result) {
+    if (running == 0)
+        return false;
+
+    vector<struct pollfd> fds;
+    vector<int> slots;
+    for (unsigned int i = 0; i < workers.size(); i++) {
+        if (workers[i].pid > 0 && workers[i].busy) {
+            struct pollfd fd;
+            fd.fd = workers[i].resultFd;
+            fd.events = POLLIN;
+            fd.revents = 0;
+            fds.push_back(fd);
+            slots.push_back(i);
+        }
+    }
+
+    while (true) {
+        // Wake up for the first task to run out of time, if any
+        int wait = -1;
+        if (timeout > 0) {
+            double now = Metrics::now(), first = now + timeout;
+            for (unsigned int i = 0; i < slots.size(); i++) {
+                if (workers[slots[i]].started < first)
+                    first = workers[slots[i]].started;
+            }
+            double left = first + timeout - now;
+            wait = (left > 0) ? (int) (left * 1000) + 1 : 0;
+        }
+
+        int ready = poll(&fds[0], fds.size(), wait);
+        if (ready < 0) {
+            if (errno != EINTR)
+                return false;
+            continue;
+        }
+
+        for (unsigned int i = 0; i < fds.size(); i++) {
+            if (fds[i].revents == 0)
+                continue;
+            int slot = slots[i];
+            Worker &worker = workers[slot];
+            int64_t taskId;
+            int32_t taskStatus;
+            worker.busy = false;
+            running--;
+            if (readMessage(worker.resultFd, taskId, taskStatus, result)) {
+                id = taskId;
+                status = taskStatus;
+            } else {
+                // The worker crashed (or was killed) in the middle of the
+                // task
+                id = worker.task;
+                status = WORKER_DIED;
+                result.clear();
+                replace(slot);
+            }
+            return true;
+        }
+
+        // Nothing finished: kill the first worker over its budget
+        double now = Metrics::now();
+        for (unsigned int i = 0; ready == 0 && i < slots.size(); i++) {
+            Worker &worker = workers[slots[i]];
+            if (now - worker.started >= timeout) {
+                id = worker.task;
+                status = TIMED_OUT;
+                result.clear();
+                replace(slots[i]);
+                return true;
+            }
+        }
+    }
+}
+
+/** Number of live workers. */
+int WorkerPool::size() const {
+    int live = 0;
+    for (unsigned int i = 0; i < workers.size(); i++) {
+        if (workers[i].pid > 0)
+            live++;
+    }
+    return live;
+}
+
+/**
+ * Mark a worker as gone and reap it.
+ */
+void WorkerPool::retire(Worker &worker) {
+    if (worker.pid <= 0)
+        return;
+    close(worker.taskFd);
+    close(worker.resultFd);
+    int status = 0;
+    while (waitpid(worker.pid, &status, 0) < 0 && errno == EINTR)
+        ;
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        failures++;
+    worker.pid = -1;
+    worker.taskFd = worker.resultFd = -1;
+    if (worker.busy) {
+        worker.busy = false;
+        running--;
+    }
+}
+
+/**
+ * Kill the worker in a slot and fork a new one in its place. The slot stays
+ * empty if the fork fails.
+ */
+void WorkerPool::replace(int slot) {
+    Worker &worker = workers[slot];
+    if (worker.pid > 0) {
+        kill(worker.pid, SIGKILL);
+        retire(worker);
+    }
+    spawn(slot);
+}
+
+/**
+ * Stop the workers and wait for them to exit. Running tasks are abandoned.
+ * 	@return Number of workers that did not exit cleanly.
+ */
+int WorkerPool::shutdown() {
+    // Closing the task pipe tells an idle worker to exit
+    for (unsigned int i = 0; i < workers.size(); i++) {
+        if (workers[i].pid > 0) {
+            if (workers[i].busy)
+                kill(workers[i].pid, SIGKILL);
+            retire(workers[i]);
+        }
+    }
+    workers.clear();
+    return failures;
+}
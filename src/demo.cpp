@@ -5,20 +5,137 @@
  *      Author: trananh
  */
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <string>
+#include <deque>
+#include <map>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
 #include <sys/stat.h>
 
 #include <Swirl.h>
 
+#include "BatchJournal.h"
+#include "BatchPipeline.h"
+#include "CompressedStream.h"
 #include "DocumentSerializer.h"
+#include "FileUtil.h"
+#include "Metrics.h"
+#include "SegmentIndex.h"
+#include "SegmentWriter.h"
+#include "SentenceIndex.h"
+#include "SentenceReader.h"
+#include "SrlCache.h"
+#include "SrlExtractor.h"
+#include "SrlServer.h"
+#include "WorkerPool.h"
 
 using namespace std;
 using namespace processors;
 using namespace srl;
 
+/**
+ * Settings for a batch run.
+ */
+struct BatchOptions {
+    BatchOptions() : overwrite(false), workers(1), splitSentences(false),
+            useTrees(false), cache(NULL), compress(COMPRESSION_NONE),
+            shard(0), shards(1), dryRun(false), maxTokens(0),
+            chunkLong(true), sentenceTimeout(0), enrich(false),
+            firstSentence(0), lastSentence(-1), segmentBytes(0) { }
+
+    /* Overwrite all files in the output directory */
+    bool overwrite;
+
+    /* Number of worker processes; they are forked after SwiRL was
+     * initialized and share its models. With 1, files are processed in
+     * this process. */
+    int workers;
+
+    /* Spread the sentences of each file across the workers, rather than
+     * giving each worker whole files. */
+    bool splitSentences;
+
+    /* Classify the constituent trees that come with the annotation instead
+     * of re-parsing with Charniak (which is still used for sentences
+     * without a tree). */
+    bool useTrees;
+
+    /* Optional persistent cache of SwiRL output, keyed by input line */
+    SrlCache* cache;
+
+    /* Compression of the output files */
+    Compression compress;
+
+    /* Where to write stage timings (JSON, or Prometheus for ".prom");
+     * nothing is measured when empty */
+    string metricsFile;
+
+    /* Process only the inputs of one shard out of this many; every node
+     * computes the same partition of the input directory */
+    int shard;
+    int shards;
+
+    /* Print the planned work instead of doing it */
+    bool dryRun;
+
+    /* Sentences longer than this many tokens are split into chunks of at
+     * most this length, or skipped; 0 for no limit */
+    int maxTokens;
+    bool chunkLong;
+
+    /* Wall-clock budget of each sentence in seconds; a worker that
+     * overruns it is killed and the sentence skipped. 0 for no budget. */
+    double sentenceTimeout;
+
+    /* Where skipped and chunked sentences are listed; nowhere when empty */
+    string skipLog;
+
+    /* Write each input back with the predicates and argument spans merged
+     * into its sentences (see DocumentSerializer), instead of SwiRL's
+     * Treebank and CoNLL text */
+    bool enrich;
+
+    /* Label only sentences [firstSentence, lastSentence) of each input,
+     * read through its sentence index; lastSentence is -1 for the end of
+     * the input. Such partial runs are not journaled. */
+    int firstSentence;
+    int lastSentence;
+
+    /* Append the outputs to segments of about this many bytes in the
+     * output directory (see SegmentWriter), instead of writing a file for
+     * each input; 0 for files */
+    long long segmentBytes;
+
+    /** True if only a range of sentences is labeled. */
+    bool ranged() const {
+        return firstSentence > 0 || lastSentence >= 0;
+    }
+};
+
+/**
+ * An input file planned for a batch run.
+ */
+struct BatchFile {
+    string infile;
+    string outfile;
+    long long tokens;   /* estimated */
+    int shard;
+};
+
+/* Typical bytes of annotation per token, to estimate the work of a file */
+const long long BYTES_PER_TOKEN = 40;
+
 /**
  * Check if a file exists.
  *  @param filename Name of the file.
@@ -67,82 +184,1016 @@ string escapeQuotes(const string &before) {
 }
 
 /**
- * Use Swirl to parse the NLP annotation from a single file.
+ * Form the SwiRL input line for a sentence.
+ *  @param sentence The sentence.
+ *  @param useTrees Hand SwiRL the sentence's constituent tree, if any.
+ *  @param line Overwritten with the line for Swirl::parse: the swirl code
+ *      followed by the escaped text, or by the tree.
+ *  @param header Overwritten with the lines printed ahead of SwiRL's output
+ *      for the sentence (token count and escaped text).
+ */
+void swirlInput(const Sentence& sentence, bool useTrees, string& line,
+        string& header) {
+    // Form the escaped sentence text with the necessary tags
+    sentence.getSwirlInput(line);
+
+    char count[32];
+    snprintf(count, sizeof(count), "%d tokens.\n", (int) sentence.words.size());
+    header.assign(count);
+    header.append(line, 2, string::npos);
+    header += "\n\n";
+
+    // An existing tree spares the Charniak parse: swirl code 0 takes a
+    // parsed sentence in Charniak's bracketed format, rooted at S1
+    if (useTrees && !sentence.syntacticTree.empty()) {
+        line = string("0 ") + escapeQuotes(sentence.syntacticTree.toString("S1"));
+    }
+}
+
+/**
+ * End of the chunk of a long sentence that starts at a given token: at most
+ * max tokens, cut after the last punctuation of the chunk's second half if
+ * there is any.
+ *  @param sentence The sentence.
+ *  @param begin First token of the chunk.
+ *  @param max Longest chunk.
+ *  @return One past the last token of the chunk.
+ */
+int chunkEnd(const Sentence& sentence, int begin, int max) {
+    int end = begin + max;
+    if (end >= sentence.size())
+        return sentence.size();
+    for (int i = end - 1; i >= begin + max / 2; i--) {
+        StringRef word = sentence.words[i];
+        if (word.equals(".") || word.equals(";") || word.equals(":")
+                || word.equals(","))
+            return i + 1;
+    }
+    return end;
+}
+
+/**
+ * Form the SwiRL input of a sentence like swirlInput, applying the token
+ * limit of the run. Parsing time grows faster than linearly with sentence
+ * length, so a long sentence is split into chunks that are parsed one
+ * after the other (their output follows the sentence's header), or skipped.
+ * SwiRL numbers the tokens of each chunk from 0, so each chunk's input line
+ * is preceded by a "# chunk <begin>-<end>" line giving its token range in
+ * the sentence (end excluded), which labelLines copies to the output.
+ *  @param sentence The sentence.
+ *  @param options Settings for the run.
+ *  @param lines Overwritten with the SwiRL input lines, one per chunk and
+ *      each after its chunk line, separated by newlines.
+ *  @param header Overwritten with the lines printed ahead of SwiRL's output
+ *      for the sentence.
+ *  @return Number of input lines: 0 if the sentence is skipped, more than
+ *      1 if it was chunked.
+ */
+int guardedInput(const Sentence& sentence, const BatchOptions& options,
+        string& lines, string& header) {
+    swirlInput(sentence, options.useTrees, lines, header);
+    if (options.maxTokens <= 0 || sentence.size() <= options.maxTokens)
+        return 1;
+    lines.clear();
+    if (!options.chunkLong)
+        return 0;
+
+    Sentence part;
+    string line, partHeader;
+    int chunks = 0;
+    for (int begin = 0; begin < sentence.size(); chunks++) {
+        int end = chunkEnd(sentence, begin, options.maxTokens);
+        sentence.slice(begin, end, part);
+        swirlInput(part, false, line, partHeader);
+        char marker[64];
+        snprintf(marker, sizeof(marker), "# chunk %d-%d\n", begin, end);
+        if (chunks > 0)
+            lines += '\n';
+        lines += marker;
+        lines += line;
+        begin = end;
+    }
+    return chunks;
+}
+
+/**
+ * What is printed instead of SwiRL's output for a skipped sentence.
+ *  @param reason Why the sentence was skipped.
+ */
+string skipNote(const string& reason) {
+    return "# skipped: " + reason + "\n\n";
+}
+
+/**
+ * Append a sentence to the skip log of the run. Each entry is written at
+ * once, so workers may share the log.
+ *  @param options Settings for the run.
+ *  @param filename The annotation file of the sentence.
+ *  @param index Index of the sentence in the file.
+ *  @param tokens Length of the sentence.
+ *  @param reason What happened to the sentence.
+ */
+void logSkip(const BatchOptions& options, const string& filename, long index,
+        int tokens, const string& reason) {
+    if (options.skipLog.empty())
+        return;
+    ostringstream entry;
+    entry << filename << "\t" << index << "\t" << tokens << "\t" << reason
+            << "\n";
+    string line = entry.str();
+    int fd = open(options.skipLog.c_str(), O_WRONLY | O_CREAT | O_APPEND,
+            0644);
+    if (fd < 0 || write(fd, line.data(), line.size()) != (ssize_t) line.size())
+        cerr << "Failed to write skip log!\n";
+    if (fd >= 0)
+        close(fd);
+}
+
+/**
+ * Reason logged for a sentence that was too long.
+ *  @param chunks Number of input lines made of the sentence (see
+ *      guardedInput).
+ *  @param options Settings for the run.
+ */
+string longReason(int chunks, const BatchOptions& options) {
+    ostringstream reason;
+    if (chunks == 0)
+        reason << "over " << options.maxTokens << " tokens";
+    else
+        reason << "chunked into " << chunks;
+    return reason.str();
+}
+
+/**
+ * Classify all predicates of one sentence and print SwiRL's output.
  * Precondition: SwiRL must have been initialized.
- *  @param filename Path to file containing the NLP annotation.
+ *  @param line The SwiRL input line (see swirlInput).
  *  @param out The output stream to print role labels.
+ *  @param tokens Length of the sentence.
+ *  @param metrics Optional stage timings.
  */
-void processFile(const string& filename, ostream& out = std::cout) {
-    ifstream stream(filename.c_str());
-    // Always check to see if file opening succeeded
-    if (stream.is_open()) {
-
-        // Load annotation
-        Document doc = DocumentSerializer::load(stream);
-
-        // For each sentence, parse with swirl
-        TreePtr tree;
-        string text, swirlCode;
-        const char * line;
-        out << (int) doc.sentences.size() << " sentences." << endl << endl;
-        for (int i = 0; i < (int) doc.sentences.size(); i++) {
-            // Form the sentence text with the necessary tags
-            Sentence sentence = doc.sentences.at(i);
-            if (sentence.entities.size() == sentence.words.size()) {
-                if (sentence.tags.size() == sentence.words.size()) {
-                    text = sentence.getTokenizedTextWithTagsEntities();
-                    swirlCode = "1";
-                } else {
-                    text = sentence.getTokenizedTextWithEntities();
-                    swirlCode = "2";
-                }
-            } else {
-                text = sentence.getTokenizedText();
-                swirlCode = "3";
-            }
+void labelSentence(const string& line, ostream& out, int tokens,
+        Metrics* metrics) {
+    StageTimer timer(metrics);
 
-            // Escape quotes and add swirl parse code
-            text = escapeQuotes(text);
-            out << (int) sentence.words.size() << " tokens." << endl;
-            out << text << endl << endl;
-            text = swirlCode + string(" ") + text;
-            line = text.c_str();
+    // Classify all predicates in this sentence
+    TreePtr tree = Swirl::parse(line.c_str());
+    timer.stop(Metrics::PARSE, tokens);
 
-            // Classify all predicates in this sentence
-            tree = Swirl::parse(line);
+    // Dump extended Treebank format
+    if (tree != (const Tree *) NULL) {
+        tree->serialize(out);
+        out << endl << endl;
+        timer.stop(Metrics::TREE, tokens);
+    }
 
-            // Dump extended Treebank format
-            if (tree != (const Tree *) NULL) {
-                tree->serialize(out);
-                out << endl << endl;
+    // Dump extended CoNLL format
+    Swirl::serialize(tree, line.c_str(), out);
+    timer.stop(Metrics::CONLL, tokens);
+}
+
+/**
+ * Label one sentence, replaying SwiRL's output from the cache if this exact
+ * input line was labeled before.
+ *  @param line The SwiRL input line (see swirlInput).
+ *  @param out The output stream to print role labels.
+ *  @param cache Optional cache of SwiRL output.
+ *  @param tokens Length of the sentence.
+ *  @param metrics Optional stage timings.
+ */
+void labelSentence(const string& line, ostream& out, SrlCache* cache,
+        int tokens, Metrics* metrics) {
+    StageTimer timer(metrics);
+    if (cache == NULL) {
+        labelSentence(line, out, tokens, metrics);
+    } else {
+        StageTimer cacheTimer(metrics);
+        string output;
+        bool hit = cache->lookup(line, output);
+        double cacheSeconds = cacheTimer.elapsed();
+        if (!hit) {
+            ostringstream buffer;
+            labelSentence(line, buffer, tokens, metrics);
+            output = buffer.str();
+            cacheTimer.restart();
+            cache->insert(line, output);
+            cacheSeconds += cacheTimer.elapsed();
+        }
+        if (metrics != NULL)
+            metrics->record(Metrics::CACHE, tokens, cacheSeconds);
+        out << output;
+    }
+    timer.stop(Metrics::LABEL, tokens);
+}
+
+/**
+ * Label every line of a SwiRL input made by guardedInput, in order. Lines
+ * starting with "#" (chunk lines) are copied to the output instead.
+ *  @param lines The SwiRL input lines, separated by newlines.
+ *  @param out The output stream to print role labels.
+ *  @param cache Optional cache of SwiRL output.
+ *  @param tokens Length of the sentence.
+ *  @param metrics Optional stage timings.
+ */
+void labelLines(const string& lines, ostream& out, SrlCache* cache,
+        int tokens, Metrics* metrics) {
+    string::size_type start = 0;
+    while (start <= lines.size()) {
+        string::size_type end = lines.find('\n', start);
+        if (end == string::npos)
+            end = lines.size();
+        if (end > start && lines[start] == '#')
+            out << lines.substr(start, end - start) << "\n";
+        else
+            labelSentence(lines.substr(start, end - start), out, cache,
+                    tokens, metrics);
+        start = end + 1;
+    }
+}
+
+/**
+ * Merge the semantic roles SwiRL printed for a sentence into it, and move it
+ * to the end of an enriched document.
+ *  @param sentence The sentence; it is swapped into the document, leaving
+ *      it empty.
+ *  @param labels SwiRL's output for the sentence.
+ *  @param filename The annotation file, for warnings.
+ *  @param index Index of the sentence in the file.
+ *  @param doc The enriched document.
+ */
+void enrichSentence(Sentence& sentence, const string& labels,
+        const string& filename, long index, Document& doc) {
+    doc.sentences.append().swap(sentence);
+    if (!SrlExtractor::extract(labels, doc.sentences.back().predicates))
+        cerr << "Failed to read the roles of sentence " << index << " of "
+                << filename << endl;
+}
+
+/**
+ * Prefix the result of a worker with its stage timings, on one line.
+ *  @param metrics The timings.
+ *  @param result The result; the timings are appended to it.
+ */
+void packMetrics(const Metrics& metrics, string& result) {
+    metrics.encode(result);
+    result += '\n';
+}
+
+/**
+ * Split the stage timings off the result of a worker.
+ *  @param result The result; the timings are removed from it.
+ *  @param metrics Set to the timings.
+ *  @return False if the result carries no timings.
+ */
+bool unpackMetrics(string& result, Metrics& metrics) {
+    string::size_type split = result.find('\n');
+    if (split == string::npos || !metrics.decode(result.substr(0, split)))
+        return false;
+    result.erase(0, split + 1);
+    return true;
+}
+
+/**
+ * Worker-side handler for the sentence pool: label one sentence.
+ *  @param task The length of the sentence and its SwiRL input lines (see
+ *      guardedInput), separated by newlines.
+ *  @param result Set to SwiRL's output for the sentence, preceded by the
+ *      stage timings if they are measured.
+ *  @param context The BatchOptions of the run.
+ *  @return 0 on success.
+ */
+int processSentenceTask(const string& task, string& result, void* context) {
+    const BatchOptions& options = *(const BatchOptions*) context;
+    string::size_type split = task.find('\n');
+    int tokens = atoi(task.c_str());
+    string line = task.substr(split + 1);
+
+    Metrics metrics;
+    bool measure = !options.metricsFile.empty();
+    ostringstream out;
+    labelLines(line, out, options.cache, tokens, measure ? &metrics : NULL);
+    result.clear();
+    if (measure)
+        packMetrics(metrics, result);
+    result += out.str();
+    return 0;
+}
+
+/**
+ * Label the sentences of one document on a pool of worker processes,
+ * printing the results in the original sentence order. Sentences whose
+ * worker runs out of time or crashes are skipped.
+ *  @param reader The reader positioned at the first sentence.
+ *  @param pool The started sentence pool.
+ *  @param out The output stream to print role labels.
+ *  @param filename The annotation file, for the skip log.
+ *  @param options Settings for the run.
+ *  @param metrics Optional stage timings of the file.
+ *  @param enriched If given, the sentences are added to it with their roles
+ *      instead of being printed.
+ *  @return False if the workers died.
+ */
+bool processSentences(SentenceReader& reader, WorkerPool& pool, ostream& out,
+        const string& filename, const BatchOptions& options,
+        Metrics* metrics, Document* enriched) {
+    // Headers and results of sentences that were not printed yet, indexed
+    // from the first unprinted sentence. At most one sentence per worker
+    // is in flight, so these stay small. Sentences are not copyable, so the
+    // ones to enrich are held through pointers.
+    deque<string> headers, results;
+    deque<bool> finished;
+    deque<int> lengths;
+    deque<Sentence*> sentences;
+    long first = reader.first(), next = first;
+
+    Sentence sentence;
+    string header, lines, task, result;
+    StageTimer timer(metrics);
+    bool more = reader.next(sentence);
+    bool ready = false;     /* task holds the next sentence */
+    while (more || pool.pending() > 0) {
+        // Keep every worker busy
+        while (more) {
+            int tokens = sentence.size();
+            bool skipped = false;
+            if (!ready) {
+                timer.stop(Metrics::LOAD, tokens, next);
+                int chunks = guardedInput(sentence, options, lines, header);
+                timer.stop(Metrics::ENCODE, tokens, next);
+                if (metrics != NULL)
+                    metrics->countSentence(tokens);
+                if (chunks != 1)
+                    logSkip(options, filename, next, tokens,
+                            longReason(chunks, options));
+                skipped = (chunks == 0);
+                char count[16];
+                snprintf(count, sizeof(count), "%d\n", tokens);
+                task.assign(count);
+                task += lines;
+                ready = true;
+            }
+            if (!skipped && !pool.submit(next, task))
+                break;
+            ready = false;
+            headers.push_back(header);
+            results.push_back(skipped ? skipNote(longReason(0, options))
+                    : string());
+            finished.push_back(skipped);
+            lengths.push_back(tokens);
+            if (enriched != NULL) {
+                sentences.push_back(new Sentence());
+                sentences.back()->swap(sentence);
             }
+            next++;
+            timer.restart();
+            more = reader.next(sentence);
+        }
 
-            // Dump extended CoNLL format
-            Swirl::serialize(tree, line, out);
+        if (pool.pending() > 0) {
+            long id;
+            int status;
+            if (!pool.collect(id, status, result)) {
+                cerr << "All worker processes died!\n";
+                for (unsigned int i = 0; i < sentences.size(); i++)
+                    delete sentences[i];
+                return false;
+            }
+            if (status == WorkerPool::TIMED_OUT
+                    || status == WorkerPool::WORKER_DIED) {
+                ostringstream reason;
+                if (status == WorkerPool::TIMED_OUT)
+                    reason << "timed out after " << options.sentenceTimeout
+                            << "s";
+                else
+                    reason << "worker crashed";
+                cerr << "Skipping sentence " << id << " of " << filename
+                        << ": " << reason.str() << endl;
+                logSkip(options, filename, id, lengths[id - first],
+                        reason.str());
+                result = skipNote(reason.str());
+            } else if (status != 0) {
+                cerr << "Failed to label sentence " << id << endl;
+            } else if (metrics != NULL) {
+                Metrics sentenceMetrics;
+                if (unpackMetrics(result, sentenceMetrics))
+                    metrics->merge(sentenceMetrics, id);
+            }
+            results[id - first].swap(result);
+            finished[id - first] = true;
         }
 
-        // Close the stream
-		stream.close();
+        // Print everything that is now complete, in order
+        while (!finished.empty() && finished.front()) {
+            if (enriched != NULL) {
+                enrichSentence(*sentences.front(), results.front(), filename,
+                        first, *enriched);
+                delete sentences.front();
+                sentences.pop_front();
+            } else {
+                out << headers.front() << results.front();
+            }
+            headers.pop_front();
+            results.pop_front();
+            finished.pop_front();
+            lengths.pop_front();
+            first++;
+        }
+    }
+    return true;
+}
 
+/**
+ * Label a sentence in this process: print its header (unless enriching)
+ * and SwiRL's output for it, applying the token limit of the run.
+ *  @param sentence The sentence.
+ *  @param index Index of the sentence in its file.
+ *  @param filename The annotation file, for the skip log.
+ *  @param options Settings for the run.
+ *  @param metrics Optional stage timings of the file.
+ *  @param out The output stream.
+ *  @param lines Scratch space for the SwiRL input.
+ *  @param header Scratch space for the header.
+ */
+void labelRead(const Sentence& sentence, long index, const string& filename,
+        const BatchOptions& options, Metrics* metrics, ostream& out,
+        string& lines, string& header) {
+    int tokens = sentence.size();
+    StageTimer timer(metrics);
+    int chunks = guardedInput(sentence, options, lines, header);
+    timer.stop(Metrics::ENCODE, tokens, index);
+    if (!options.enrich)
+        out << header;
+    if (chunks != 1)
+        logSkip(options, filename, index, tokens, longReason(chunks, options));
+    if (chunks == 0) {
+        out << skipNote(longReason(0, options));
+    } else if (metrics == NULL) {
+        labelLines(lines, out, options.cache, tokens, NULL);
     } else {
+        // Timed like a worker would, then attributed to this sentence
+        Metrics sentenceMetrics;
+        labelLines(lines, out, options.cache, tokens, &sentenceMetrics);
+        metrics->merge(sentenceMetrics, index);
+    }
+    if (metrics != NULL)
+        metrics->countSentence(tokens);
+}
+
+/**
+ * Use Swirl to parse the NLP annotation read from a sentence reader.
+ * Precondition: SwiRL must have been initialized.
+ *  @param reader The annotation, one sentence at a time.
+ *  @param out The output stream to print role labels.
+ *  @param filename The annotation file, for the skip log.
+ *  @param options Settings for the run.
+ *  @param pool Optional sentence pool.
+ *  @param metrics Optional stage timings of the file.
+ *  @return False if the sentence pool failed.
+ */
+bool processReader(SentenceReader& reader, ostream& out,
+        const string& filename, const BatchOptions& options, WorkerPool* pool,
+        Metrics* metrics) {
+    // The document grows as sentences are read; the count in the header is
+    // not trusted to size it
+    Document enriched;
+    if (!options.enrich)
+        out << reader.size() << " sentences." << endl << endl;
+    if (pool != NULL) {
+        if (!processSentences(reader, *pool, out, filename, options, metrics,
+                options.enrich ? &enriched : NULL))
+            return false;
+        if (options.enrich)
+            DocumentSerializer::save(enriched, out);
+        return true;
+    }
 
+    // For each sentence, parse with swirl; when enriching, SwiRL's output
+    // is only kept until its roles are read
+    string header, lines;
+    Sentence sentence;
+    long index = reader.first();
+    ostringstream roles;
+    ostream& labels = options.enrich ? roles : out;
+    StageTimer timer(metrics);
+    while (reader.next(sentence)) {
+        timer.stop(Metrics::LOAD, sentence.size(), index);
+        labelRead(sentence, index, filename, options, metrics, labels, lines,
+                header);
+        if (options.enrich) {
+            enrichSentence(sentence, roles.str(), filename, index, enriched);
+            roles.str("");
+        }
+        index++;
+        timer.restart();
+    }
+    if (options.enrich)
+        DocumentSerializer::save(enriched, out);
+    return true;
+}
+
+/**
+ * Parts of each sentence a run needs: SwiRL reads the words, POS tags and
+ * named entities (and the tree, with --use-trees); the rest of the
+ * annotation is skipped while loading unless it is carried into an enriched
+ * document.
+ *  @param options Settings for the run.
+ *  @return Mask of DocumentSerializer::Column values.
+ */
+unsigned int loadColumns(const BatchOptions& options) {
+    if (options.enrich)
+        return DocumentSerializer::COLUMN_ALL;
+    unsigned int columns = DocumentSerializer::COLUMN_WORDS
+            | DocumentSerializer::COLUMN_TAGS
+            | DocumentSerializer::COLUMN_ENTITIES;
+    if (options.useTrees)
+        columns |= DocumentSerializer::COLUMN_TREE;
+    return columns;
+}
+
+/**
+ * Use Swirl to parse the NLP annotation from a single file.
+ * Files ending in .gz or .zst are decompressed on the fly.
+ * Precondition: SwiRL must have been initialized.
+ *  @param filename Path to file containing the NLP annotation.
+ *  @param out The output stream to print role labels.
+ *  @param options Settings for the run.
+ *  @param pool Optional sentence pool; when given, the sentences of the
+ *      file are labeled in parallel by its workers.
+ *  @param metrics Optional stage timings, filled in for this file.
+ *  @param checksum Optional; set to the CRC-32 of the file as it was read,
+ *      for the journal. Left alone for sentence ranges.
+ *  @return False if the annotation file could not be opened.
+ */
+bool processFile(const string& filename, ostream& out = std::cout,
+        const BatchOptions& options = BatchOptions(), WorkerPool* pool = NULL,
+        Metrics* metrics = NULL, uint32_t* checksum = NULL) {
+    double started = Metrics::now();
+    if (metrics != NULL)
+        metrics->file = filename;
+
+    bool opened = false, ok = false;
+    if (compressionOf(filename) == COMPRESSION_NONE) {
+        MappedFile file(filename);
+        // Always check to see if file opening succeeded
+        if (file.is_open() && options.ranged()) {
+            // Seek straight to the range through the sentence index
+            SentenceIndex index;
+            opened = true;
+            if (index.open(filename, file)) {
+                SentenceReader reader(file, index, options.firstSentence,
+                        options.lastSentence);
+                reader.setColumns(loadColumns(options));
+                ok = processReader(reader, out, filename, options, pool,
+                        metrics);
+            } else {
+                cerr << "Failed to index annotation file: " << filename
+                        << endl;
+            }
+        } else if (file.is_open()) {
+            // Stream the annotation one sentence at a time
+            SentenceReader reader(file);
+            reader.setColumns(loadColumns(options));
+            opened = true;
+            ok = processReader(reader, out, filename, options, pool, metrics);
+            if (checksum != NULL)
+                *checksum = bufferChecksum(file.begin(), file.size());
+        }
+    } else if (options.ranged()) {
+        cerr << "Sentence ranges need an uncompressed annotation file: "
+                << filename << endl;
+        return false;
+    } else {
+        // Decompression runs on its own thread, ahead of the parser
+        CompressedInputStream stream(filename);
+        if (stream.is_open()) {
+            SentenceReader reader(stream);
+            reader.setColumns(loadColumns(options));
+            opened = true;
+            ok = processReader(reader, out, filename, options, pool, metrics);
+            stream.close();
+            if (stream.fail()) {
+                cerr << "Corrupt compressed file: " << filename << endl;
+                ok = false;
+            }
+            if (checksum != NULL)
+                *checksum = stream.checksum();
+        }
+    }
+
+    if (!opened) {
         cerr << "Failed to find annotation file!\n";
+        return false;
+    }
+    if (metrics != NULL)
+        metrics->seconds = Metrics::now() - started;
+    return ok;
+}
+
+/**
+ * Name of an output in the segments: the name of the file it would
+ * otherwise be written to.
+ *  @param outfile Path of the output file.
+ */
+string segmentEntry(const string& outfile) {
+    return outfile.substr(outfile.find_last_of('/') + 1);
+}
+
+/* Most files a worker packs into its segment per task; the outputs of a
+ * task are committed, and then journaled, together */
+const int FILES_PER_COMMIT = 16;
+
+/**
+ * Worker-side handler for the file pool: process a group of input files.
+ * Each output is written to a temporary file and renamed into place once
+ * complete, or appended to the worker's own segment, which is committed once
+ * for the whole group; the results are only sent back after that, since the
+ * parent journals the files as soon as it hears back.
+ *  @param task The input and output path of each file, on a line each.
+ *  @param result Set to a line per file with its status (0 on success),
+ *      the size of its output in the segment (-1 for a file) and the
+ *      checksum of the input, each followed by the stage timings of the
+ *      file if they are measured.
+ *  @param context The BatchOptions of the run.
+ *  @return 0 unless the outputs of the group could not be committed.
+ */
+int processFileTask(const string& task, string& result, void* context) {
+    const BatchOptions& options = *(const BatchOptions*) context;
+    vector<string> paths;
+    string::size_type start = 0, end;
+    while ((end = task.find('\n', start)) != string::npos) {
+        paths.push_back(task.substr(start, end - start));
+        start = end + 1;
+    }
+
+    // Created in the worker, so that each worker has a segment of its own
+    static SegmentWriter* segments = NULL;
+    if (options.segmentBytes > 0 && segments == NULL && paths.size() >= 2)
+        segments = new SegmentWriter(paths[1].substr(0,
+                paths[1].find_last_of('/')), options.compress,
+                options.segmentBytes);
+
+    bool measure = !options.metricsFile.empty();
+    result.clear();
+    for (unsigned int i = 0; i + 1 < paths.size(); i += 2) {
+        const string& infile = paths[i];
+        const string& outfile = paths[i + 1];
+        Metrics metrics;
+        long long size = -1;
+        uint32_t checksum = 0;
+        bool ok;
+        if (segments != NULL) {
+            segments->open(segmentEntry(outfile));
+            ok = processFile(infile, segments->stream(), options, NULL,
+                    measure ? &metrics : NULL, &checksum);
+            if (ok)
+                ok = segments->close(size);
+            else
+                segments->cancel();
+        } else {
+            CompressedOutputStream outstream(BatchJournal::partial(outfile),
+                    options.compress);
+            ok = processFile(infile, outstream, options, NULL,
+                    measure ? &metrics : NULL, &checksum);
+            outstream.close();
+            ok = ok && outstream && BatchJournal::commit(outfile);
+        }
+
+        char line[64];
+        snprintf(line, sizeof(line), "%d %lld %08lx\n", ok ? 0 : 1, size,
+                (unsigned long) checksum);
+        result += line;
+        if (measure)
+            packMetrics(metrics, result);
+    }
+    return (segments == NULL || segments->commit()) ? 0 : 1;
+}
+
+/**
+ * Commit the outputs pending in this process's segment, then journal their
+ * inputs, whose records were added as the outputs were closed, with a
+ * single flush. Exits if the segment cannot be committed.
+ *  @param segments The segments, or NULL if outputs are files of their own.
+ *  @param journal The journal of the output directory.
+ */
+void commitOutputs(SegmentWriter* segments, BatchJournal& journal) {
+    if (segments != NULL && !segments->commit()) {
+        cerr << "Failed to commit output segment!\n";
         exit(1);
+    }
+    if (!journal.flush())
+        cerr << "Failed to update journal!\n";
+}
 
+/**
+ * Name of an annotation file without its compression suffix.
+ *  @param filename Name of a file (e.g. "doc.txt.gz").
+ *  @return The name of the uncompressed file (e.g. "doc.txt"), or an empty
+ *      string if it is not an annotation file.
+ */
+string annotationName(const string& filename) {
+    string name = filename.substr(0, filename.size()
+            - strlen(compressionSuffix(compressionOf(filename))));
+    string::size_type dot = name.find_last_of(".");
+    if (dot != string::npos && name.substr(dot) == ".txt")
+        return name;
+    return "";
+}
+
+/**
+ * Shard of an input: a 64-bit FNV-1a hash of its name, so that nodes sharing
+ * nothing agree on the partition, and a file keeps its shard whatever else
+ * is in the directory.
+ *  @param name Name of the annotation (without compression suffix).
+ *  @param shards Number of shards.
+ *  @return The shard, in [0, shards).
+ */
+int shardOf(const string& name, int shards) {
+    unsigned long long hash = 14695981039346656037ULL;
+    for (unsigned int i = 0; i < name.size(); i++) {
+        hash ^= (unsigned char) name[i];
+        hash *= 1099511628211ULL;
     }
+    return (int) (hash % shards);
 }
 
+/**
+ * Larger estimated work first, then by name.
+ */
+bool largerFirst(const BatchFile& a, const BatchFile& b) {
+    if (a.tokens != b.tokens)
+        return a.tokens > b.tokens;
+    return a.infile < b.infile;
+}
+
+/**
+ * Collect the inputs of this node's shard that still need processing,
+ * ordered largest first so that the longest files do not end up alone at
+ * the end of the run. The inputs of other shards are only counted, without
+ * touching them, except in a dry run, which plans every shard.
+ *  @param inPath The directory containing NLP annotation files.
+ *  @param outPath The output directory.
+ *  @param options Settings for the run.
+ *  @param journal The journal of the output directory.
+ *  @param segments The index of the segments, if outputs are packed.
+ *  @param plan Set to the inputs to process.
+ *  @param elsewhere Set to the number of inputs left to other shards.
+ *  @return Number of inputs the journal shows as completed, or -1 if two
+ *      inputs would write the same output (e.g. doc.txt and doc.txt.gz).
+ */
+int planBatch(const string& inPath, const string& outPath,
+        const BatchOptions& options, const BatchJournal& journal,
+        const SegmentIndex* segments, vector<BatchFile>& plan,
+        int& elsewhere) {
+    dirent* pdir;
+    string filename;
+    DIR* dir = opendir(inPath.c_str());
+    int done = 0;
+    map<string, string> outputs;
+    bool collided = false;
+
+    // Collect all files in the input directory that need processing
+    plan.clear();
+    elsewhere = 0;
+    while ((pdir = readdir(dir)) != 0) {
+        filename = string(pdir->d_name);
+        BatchFile file;
+        file.infile = inPath + string("/") + filename;
+        string name = annotationName(filename);
+        if (!name.empty()) {
+            // We only work with txt files, possibly compressed
+            if (!compressionSupported(compressionOf(filename))) {
+                cerr << "Skipping file (no zstd support): " << file.infile
+                        << endl;
+                continue;
+            }
+            file.outfile = outPath + string("/") + name
+                    + compressionSuffix(options.compress);
+
+            // Each output (and journal record) belongs to a single input
+            map<string, string>::iterator other = outputs.find(name);
+            if (other != outputs.end()) {
+                cerr << "Inputs share an output: " << other->second
+                        << " and " << file.infile << endl;
+                collided = true;
+                continue;
+            }
+            outputs[name] = file.infile;
+
+            // The shard only depends on the name, so the files of other
+            // shards are skipped before any of them is read
+            file.shard = shardOf(name, options.shards);
+            if (file.shard != options.shard && !options.dryRun) {
+                elsewhere++;
+                continue;
+            }
+            bool completed;
+            if (segments != NULL) {
+                // A packed output is still there if the index has it
+                const SegmentIndex::Entry* entry =
+                        segments->find(segmentEntry(file.outfile));
+                completed = (entry != NULL) && journal.completed(
+                        file.infile, file.outfile, entry->length);
+            } else {
+                completed = journal.completed(file.infile, file.outfile);
+            }
+            if (options.overwrite || options.ranged() || !completed) {
+                // Process the file unless an earlier run completed it and
+                // neither it nor its output changed since (or if overwrite
+                // is specified, or only a range of it is wanted).
+                file.tokens = uncompressedSize(file.infile) / BYTES_PER_TOKEN;
+                plan.push_back(file);
+            } else {
+                done++;
+            }
+        }
+    }
+    closedir(dir);
+    if (collided)
+        return -1;
+    sort(plan.begin(), plan.end(), largerFirst);
+    return done;
+}
+
+/**
+ * Print the work planned for each shard, and the files of this node's shard
+ * (or of all shards) in the order they would be processed.
+ *  @param plan The inputs to process.
+ *  @param done Number of inputs already completed.
+ *  @param options Settings for the run.
+ */
+void printPlan(const vector<BatchFile>& plan, int done,
+        const BatchOptions& options) {
+    vector<int> files(options.shards, 0);
+    vector<long long> tokens(options.shards, 0);
+    for (unsigned int i = 0; i < plan.size(); i++) {
+        files[plan[i].shard]++;
+        tokens[plan[i].shard] += plan[i].tokens;
+    }
+    cout << "Files already completed: " << done << endl;
+    for (int s = 0; s < options.shards; s++) {
+        cout << "Shard " << s << "/" << options.shards << ": " << files[s]
+                << " files, ~" << tokens[s] << " tokens" << endl;
+    }
+    for (unsigned int i = 0; i < plan.size(); i++) {
+        if (options.shards == 1 || plan[i].shard == options.shard)
+            cout << plan[i].shard << "\t" << plan[i].tokens << "\t"
+                    << plan[i].infile << endl;
+    }
+}
+
+/**
+ * The stages of a batch run labeled by this process (see BatchPipeline):
+ * SwiRL runs on the calling thread, while the writer thread formats the
+ * output, keeps the journal and collects the stage timings of each file.
+ */
+class BatchStages : public PipelineStages {
+
+public:
+
+    /**
+     * Constructor.
+     *  @param infiles Inputs of the run.
+     *  @param outfiles Outputs of the run.
+     *  @param options Settings for the run.
+     *  @param journal Journal of completed files.
+     *  @param run Optional stage timings of the run.
+     */
+    BatchStages(const vector<string>& infiles, const vector<string>& outfiles,
+            const BatchOptions& options, BatchJournal& journal, Metrics* run)
+            : infiles(infiles), outfiles(outfiles), options(options),
+            journal(journal), run(run), current(NULL), completed(0) {
+        pthread_mutex_init(&lock, NULL);
+    }
+
+    ~BatchStages() {
+        pthread_mutex_destroy(&lock);
+    }
+
+    void begin(int file) {
+        cout << "Procesing new file: " << infiles[file] << endl;
+        if (run == NULL)
+            return;
+        // Entries do not move, so the writer may finish other files
+        pthread_mutex_lock(&lock);
+        InFlight& entry = active[file];
+        pthread_mutex_unlock(&lock);
+        entry.started = Metrics::now();
+        entry.metrics.file = infiles[file];
+        current = &entry.metrics;
+    }
+
+    void label(int file, const Sentence& sentence, long index,
+            double loadSeconds, string& labels) {
+        Metrics* metrics = (run != NULL) ? current : NULL;
+        if (metrics != NULL)
+            metrics->record(Metrics::LOAD, sentence.size(), loadSeconds,
+                    index);
+        buffer.str("");
+        labelRead(sentence, index, infiles[file], options, metrics, buffer,
+                lines, header);
+        labels = buffer.str();
+    }
+
+    void open(int file, int sentences, string& text) {
+        text.clear();
+        if (!options.enrich) {
+            ostringstream count;
+            count << sentences << " sentences." << endl << endl;
+            text = count.str();
+        }
+    }
+
+    void format(int file, Sentence& sentence, long index, string& labels,
+            string& text) {
+        text.clear();
+        if (options.enrich)
+            enrichSentence(sentence, labels, infiles[file], index, enriched);
+        else
+            text.swap(labels);
+    }
+
+    void close(int file, string& text) {
+        text.clear();
+        if (options.enrich) {
+            ostringstream document;
+            DocumentSerializer::save(enriched, document);
+            text = document.str();
+            enriched.sentences.clear();
+        }
+    }
+
+    void finished(int file, bool ok, long long size, uint32_t checksum) {
+        if (run != NULL) {
+            pthread_mutex_lock(&lock);
+            map<int, InFlight>::iterator entry = active.find(file);
+            if (entry != active.end()) {
+                if (ok) {
+                    Metrics& metrics = entry->second.metrics;
+                    metrics.seconds = Metrics::now() - entry->second.started;
+                    run->addFile(metrics);
+                }
+                active.erase(entry);
+            }
+            pthread_mutex_unlock(&lock);
+        }
+        if (!ok)
+            return;
+        if (!options.ranged() && !journal.add(infiles[file], outfiles[file],
+                size, checksum))
+            cerr << "Failed to update journal!\n";
+        completed++;
+    }
+
+    void committed() {
+        if (!journal.flush())
+            cerr << "Failed to update journal!\n";
+    }
+
+    /** Number of files written so far. */
+    int count() const {
+        return completed;
+    }
+
+private:
+
+    const vector<string>& infiles;
+    const vector<string>& outfiles;
+    const BatchOptions& options;
+    BatchJournal& journal;
+    Metrics* run;
+
+    /** Stage timings of a file that has not finished yet. */
+    struct InFlight {
+        double started;
+        Metrics metrics;
+    };
+
+    // Labeling thread
+    ostringstream buffer;
+    string lines, header;
+    Metrics* current;
+
+    // Files begun and not yet finished, guarded by the lock
+    map<int, InFlight> active;
+    pthread_mutex_t lock;
+
+    // Writer thread
+    Document enriched;
+    int completed;
+
+};
+
 /**
  * Swirl parse all NLP annotations contained in the given directory.
- * All NLP annotations are expected to be stored in txt files.
+ * All NLP annotations are expected to be stored in txt files, optionally
+ * compressed (.txt.gz or .txt.zst).
  * Precondition: SwiRL must have been initialized.
  *  @param directory The directory containing NLP annotation files.
  *  @param outdir The output directory.
- *  @param overwrite Overwrite all files in the output directory if True.
- *      Defaults to false.
+ *  @param options Settings for the run.
  */
 void processBatch(const string& directory, const string& outdir,
-        bool overwrite = false) {
+        const BatchOptions& options = BatchOptions()) {
 
     if (!exists(directory) || !exists(outdir)) {
         cerr << "Failed to find directory!\n";
@@ -153,36 +1204,338 @@ void processBatch(const string& directory, const string& outdir,
     string inPath = removeTrailingSlash(directory);
     string outPath = removeTrailingSlash(outdir);
 
+    // Plan the work, largest files first
+    BatchJournal journal(outPath);
+    SegmentIndex* index = NULL;
+    if (options.segmentBytes > 0)
+        index = new SegmentIndex(outPath);
+    vector<BatchFile> plan;
+    int elsewhere;
+    int done = planBatch(inPath, outPath, options, journal, index, plan,
+            elsewhere);
+    delete index;
+    if (done < 0) {
+        cerr << "Rename or move the inputs that share an output!\n";
+        exit(1);
+    }
+    if (options.dryRun) {
+        printPlan(plan, done, options);
+        return;
+    }
+    if (done > 0)
+        cout << "Files already completed: " << done << endl;
+
+    vector<string> infiles, outfiles;
+    for (unsigned int i = 0; i < plan.size(); i++) {
+        infiles.push_back(plan[i].infile);
+        outfiles.push_back(plan[i].outfile);
+    }
+    if (elsewhere > 0)
+        cout << "Files in other shards: " << elsewhere << endl;
+
+    // Cache counters are shared by all processes; report this run's share
+    long cacheHits = 0, cacheMisses = 0;
+    if (options.cache != NULL) {
+        cacheHits = options.cache->hits();
+        cacheMisses = options.cache->misses();
+    }
+
+    // Stage timings of the whole run, with a summary of the slowest files
+    Metrics run;
+    bool measure = !options.metricsFile.empty();
+    double started = Metrics::now();
+
+    // Outputs written by this process, when they are packed
+    SegmentWriter segmentWriter(outPath, options.compress,
+            options.segmentBytes);
+    SegmentWriter* segments = (options.segmentBytes > 0)
+            ? &segmentWriter : NULL;
+
     int count = 0;
-    dirent* pdir;
-    string filename, infile, outfile;
-    DIR* dir = opendir(inPath.c_str());
+    bool timed = (options.sentenceTimeout > 0);
+    if (options.workers <= 1 || options.splitSentences || timed) {
 
-    // Iterate over all files in the input directory
-    while ((pdir = readdir(dir)) != 0) {
-        filename = string(pdir->d_name);
-        infile = inPath + string("/") + filename;
-        if (filename.substr(filename.find_last_of(".")) == ".txt") {
-            // We only work with txt files
-            outfile = outPath + string("/") + filename;
-            if (overwrite || !exists(outfile)) {
-                // Process the file if it doesn't already exist
-                // in the output directory (or if overwrite is specified).
-                cout << "Procesing new file: " << infile << endl;
-
-                // Process nlp annotation and save swirl's output to file
-                ofstream outstream;
-                outstream.open(outfile.c_str());
-                processFile(infile, outstream);
-                outstream.close();
+        // Files are processed one at a time, optionally with their
+        // sentences spread across a pool of workers. Time budgets need
+        // workers that can be killed, so they always get a pool.
+        WorkerPool sentencePool(max(options.workers, 1), processSentenceTask,
+                (void*) &options);
+        sentencePool.setTimeout(options.sentenceTimeout);
+        WorkerPool* pool = NULL;
+        if (options.workers > 1 || timed) {
+            if (!sentencePool.start()) {
+                cerr << "Failed to start worker processes!\n";
+                exit(1);
+            }
+            pool = &sentencePool;
+        }
+
+        // Without workers, upcoming files are read and finished ones
+        // written on their own threads while SwiRL labels on this one
+        if (pool == NULL) {
+            BatchStages stages(infiles, outfiles, options, journal,
+                    measure ? &run : NULL);
+            BatchPipeline pipeline(stages, options.compress);
+            pipeline.setRange(options.firstSentence, options.lastSentence);
+            pipeline.setColumns(loadColumns(options));
+            pipeline.setSegments(segments);
+            for (unsigned int i = 0; i < infiles.size(); i++)
+                pipeline.add(infiles[i], outfiles[i]);
+            if (!pipeline.run())
+                exit(1);
+            count = stages.count();
+        } else {
+            for (int i = 0; i < (int) infiles.size(); i++) {
+                cout << "Procesing new file: " << infiles[i] << endl;
+
+                // Process nlp annotation and save swirl's output to a
+                // temporary file, which replaces the output only once
+                // complete, or to the segment
+                Metrics metrics;
+                CompressedOutputStream outstream;
+                ostream* out = &outstream;
+                if (segments != NULL) {
+                    segments->open(segmentEntry(outfiles[i]));
+                    out = &segments->stream();
+                } else {
+                    outstream.open(BatchJournal::partial(outfiles[i]),
+                            options.compress);
+                }
+                uint32_t checksum = 0;
+                if (!processFile(infiles[i], *out, options, pool,
+                        measure ? &metrics : NULL, &checksum)) {
+                    // Files before a failed one are kept
+                    if (segments != NULL)
+                        segments->cancel();
+                    commitOutputs(segments, journal);
+                    exit(1);
+                }
+                long long size = -1;
+                bool written;
+                if (segments != NULL) {
+                    written = segments->close(size);
+                } else {
+                    outstream.close();
+                    written = outstream && BatchJournal::commit(outfiles[i]);
+                }
+                if (!written) {
+                    cerr << "Failed to write output file: " << outfiles[i]
+                            << endl;
+                    commitOutputs(segments, journal);
+                    exit(1);
+                }
+                if (!options.ranged() && !journal.add(infiles[i], outfiles[i],
+                        size, checksum))
+                    cerr << "Failed to update journal!\n";
+                if (segments == NULL || segments->due())
+                    commitOutputs(segments, journal);
+                if (measure)
+                    run.addFile(metrics);
 
                 // Keep acount of files processed
                 count++;
             }
+            commitOutputs(segments, journal);
         }
+
+    } else {
+
+        WorkerPool pool(options.workers, processFileTask, (void*) &options);
+        if (!pool.start()) {
+            cerr << "Failed to start worker processes!\n";
+            exit(1);
+        }
+
+        // Hand out files as workers become idle. Packed outputs go in
+        // groups, committed and journaled at once; the groups shrink
+        // towards the end so that the workers finish together.
+        long id;
+        int status;
+        string result;
+        int next = 0, failed = 0;
+        vector<int> groupEnd(infiles.size());
+        while (next < (int) infiles.size() || pool.pending() > 0) {
+            while (next < (int) infiles.size()) {
+                int group = 1;
+                if (options.segmentBytes > 0)
+                    group = max(1, min(FILES_PER_COMMIT,
+                            ((int) infiles.size() - next)
+                            / (2 * options.workers)));
+                int end = next + group;
+                string task;
+                for (int i = next; i < end; i++)
+                    task += infiles[i] + "\n" + outfiles[i] + "\n";
+                if (!pool.submit(next, task))
+                    break;
+                groupEnd[next] = end;
+                for (; next < end; next++)
+                    cout << "Procesing new file: " << infiles[next] << endl;
+            }
+            if (!pool.collect(id, status, result)) {
+                cerr << "All worker processes died!\n";
+                exit(1);
+            }
+            for (int i = id; i < groupEnd[id]; i++) {
+                // A line per file, then its timings if they are measured
+                int fileStatus = 1;
+                long long size = -1;
+                unsigned long checksum = 0;
+                string::size_type split = result.find('\n');
+                if (status == 0 && split != string::npos) {
+                    sscanf(result.c_str(), "%d %lld %lx", &fileStatus, &size,
+                            &checksum);
+                    result.erase(0, split + 1);
+                }
+                Metrics metrics;
+                bool measured = (status == 0 && measure
+                        && unpackMetrics(result, metrics));
+                if (status != 0 || fileStatus != 0) {
+                    cerr << "Failed to process file: " << infiles[i] << endl;
+                    failed++;
+                    continue;
+                }
+                // Only this process writes the journal
+                if (!options.ranged() && !journal.add(infiles[i],
+                        outfiles[i], size, (uint32_t) checksum))
+                    cerr << "Failed to update journal!\n";
+                count++;
+                if (measured) {
+                    metrics.file = infiles[i];
+                    run.addFile(metrics);
+                }
+            }
+            if (!journal.flush())
+                cerr << "Failed to update journal!\n";
+        }
+        pool.shutdown();
+
+        if (failed > 0)
+            cout << "Files failed: " << failed << endl;
     }
 
     cout << "Files processed: " << count << endl;
+    if (options.cache != NULL) {
+        cout << "Cache hits: " << options.cache->hits() - cacheHits
+                << ", misses: " << options.cache->misses() - cacheMisses
+                << endl;
+    }
+    if (measure) {
+        run.seconds = Metrics::now() - started;
+        cout << "Sentences: " << run.sentences << ", tokens: " << run.tokens
+                << ", seconds: " << run.seconds << endl;
+        if (!run.save(options.metricsFile))
+            cerr << "Failed to write metrics file!\n";
+    }
+}
+
+/**
+ * State of the labeling thread of a server.
+ */
+struct ServeContext {
+    const BatchOptions* options;
+    Metrics* metrics;
+};
+
+/**
+ * Server-side handler: label one sentence of a request.
+ *  @param sentence The sentence; swapped into the enriched document.
+ *  @param result Set to what batch mode prints for the sentence, or to a
+ *      document holding just the enriched sentence.
+ *  @param context The ServeContext of the server.
+ *  @return 0 on success.
+ */
+int serveSentence(Sentence& sentence, string& result, void* context) {
+    const ServeContext& serve = *(const ServeContext*) context;
+    string line, header;
+    int tokens = sentence.size();
+    StageTimer timer(serve.metrics);
+    int chunks = guardedInput(sentence, *serve.options, line, header);
+    timer.stop(Metrics::ENCODE, tokens);
+
+    ostringstream out;
+    if (!serve.options->enrich)
+        out << header;
+    if (chunks == 0)
+        out << skipNote(longReason(0, *serve.options));
+    else
+        labelLines(line, out, serve.options->cache, tokens, serve.metrics);
+    if (serve.metrics != NULL)
+        serve.metrics->countSentence(tokens);
+    result = out.str();
+
+    if (serve.options->enrich) {
+        Document doc;
+        enrichSentence(sentence, result, "request", 0, doc);
+        ostringstream enriched;
+        DocumentSerializer::save(doc, enriched);
+        result = enriched.str();
+    }
+    return 0;
+}
+
+/* The running server, for the signal handler */
+SrlServer* activeServer = NULL;
+
+/**
+ * Signal handler: stop the running server.
+ *  @param signum The signal.
+ */
+void stopServer(int signum) {
+    if (activeServer != NULL)
+        activeServer->stop();
+}
+
+/**
+ * Serve labeling requests until stopped (see SrlServer for the protocol).
+ * Precondition: SwiRL must have been initialized.
+ *  @param socket Path of the Unix domain socket, or "-" to read requests
+ *      from stdin and answer on stdout.
+ *  @param options Settings for the server.
+ */
+void serveRequests(const string& socket, const BatchOptions& options) {
+    Metrics metrics;
+    bool measure = !options.metricsFile.empty();
+    ServeContext context = { &options, measure ? &metrics : NULL };
+    SrlServer server(serveSentence, &context);
+    double started = Metrics::now();
+
+    // Clients that go away must not take the server down
+    signal(SIGPIPE, SIG_IGN);
+
+    bool ok;
+    if (socket == "-") {
+        // Anything else printed to stdout would corrupt the answers
+        int out = dup(1);
+        dup2(2, 1);
+        ok = server.serve(0, out);
+        close(out);
+    } else {
+        if (!server.listen(socket)) {
+            cerr << "Failed to create socket: " << socket << endl;
+            exit(1);
+        }
+        activeServer = &server;
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = stopServer;
+        sigaction(SIGINT, &action, NULL);
+        sigaction(SIGTERM, &action, NULL);
+        cerr << "Serving on " << socket << endl;
+        ok = server.serve();
+        activeServer = NULL;
+    }
+    if (!ok) {
+        cerr << "Failed to start server!\n";
+        exit(1);
+    }
+
+    cerr << "Requests: " << server.requests() << ", sentences: "
+            << server.sentences() << endl;
+    if (measure) {
+        metrics.seconds = Metrics::now() - started;
+        if (!metrics.save(options.metricsFile))
+            cerr << "Failed to write metrics file!\n";
+    }
 }
 
 /**
@@ -194,9 +1547,16 @@ void processBatch(const string& directory, const string& outdir,
 int main(int argc, char ** argv) {
 
     /**
-     * TODO: Expose command line arguments & remove hardcoded values!
+     * TODO: Expose the model paths as command line arguments!
      * For now, make sure you update the hardcoded paths below appropriately
      * before running the demo.
+     *
+     * usage: demo [--workers N] [--split-sentences] [--use-trees]
+     *             [--cache DIR] [--compress gzip|zstd] [--metrics FILE]
+     *             [--shard i/N] [--dry-run] [--max-tokens N]
+     *             [--long-sentences chunk|skip] [--sentence-timeout SECONDS]
+     *             [--skip-log FILE] [--enrich] [--sentences N|N-M|N-]
+     *             [--pack MB] [--serve SOCKET|- | input-dir output-dir]
      */
 
     /* IMPORTANT: UPDATE THESE PATHS!
@@ -213,6 +1573,104 @@ int main(int argc, char ** argv) {
     string path = "/path/to/NLP-annotations";
     string out = "/path/to/Swirl-output";
 
+    BatchOptions options;
+    string cacheDir;
+    string serveOn;
+    vector<string> positional;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--workers" && i + 1 < argc) {
+            options.workers = atoi(argv[++i]);
+        } else if (arg == "--split-sentences") {
+            options.splitSentences = true;
+        } else if (arg == "--use-trees") {
+            options.useTrees = true;
+        } else if (arg == "--cache" && i + 1 < argc) {
+            cacheDir = argv[++i];
+        } else if (arg == "--metrics" && i + 1 < argc) {
+            options.metricsFile = argv[++i];
+        } else if (arg == "--serve" && i + 1 < argc) {
+            serveOn = argv[++i];
+        } else if (arg == "--shard" && i + 1 < argc) {
+            if (sscanf(argv[++i], "%d/%d", &options.shard,
+                    &options.shards) != 2 || options.shards < 1
+                    || options.shard < 0 || options.shard >= options.shards) {
+                cerr << "Invalid shard (expected i/N with 0 <= i < N): "
+                        << argv[i] << endl;
+                exit(1);
+            }
+        } else if (arg == "--dry-run") {
+            options.dryRun = true;
+        } else if (arg == "--max-tokens" && i + 1 < argc) {
+            options.maxTokens = atoi(argv[++i]);
+        } else if (arg == "--long-sentences" && i + 1 < argc) {
+            string policy = argv[++i];
+            if (policy != "chunk" && policy != "skip") {
+                cerr << "Unknown policy for long sentences: " << policy
+                        << endl;
+                exit(1);
+            }
+            options.chunkLong = (policy == "chunk");
+        } else if (arg == "--sentence-timeout" && i + 1 < argc) {
+            options.sentenceTimeout = atof(argv[++i]);
+        } else if (arg == "--skip-log" && i + 1 < argc) {
+            options.skipLog = argv[++i];
+        } else if (arg == "--enrich") {
+            options.enrich = true;
+        } else if (arg == "--sentences" && i + 1 < argc) {
+            if (!SentenceIndex::parseRange(argv[++i], options.firstSentence,
+                    options.lastSentence)) {
+                cerr << "Invalid sentence range (expected N, N-M or N-): "
+                        << argv[i] << endl;
+                exit(1);
+            }
+        } else if (arg == "--pack" && i + 1 < argc) {
+            options.segmentBytes = atoll(argv[++i]) * (1LL << 20);
+            if (options.segmentBytes <= 0) {
+                cerr << "Invalid segment size (expected MB > 0): " << argv[i]
+                        << endl;
+                exit(1);
+            }
+        } else if (arg == "--compress" && i + 1 < argc) {
+            string codec = argv[++i];
+            if (codec == "gzip") {
+                options.compress = COMPRESSION_GZIP;
+            } else if (codec == "zstd"
+                    && compressionSupported(COMPRESSION_ZSTD)) {
+                options.compress = COMPRESSION_ZSTD;
+            } else {
+                cerr << "Unsupported compression: " << codec << endl;
+                exit(1);
+            }
+        } else {
+            positional.push_back(arg);
+        }
+    }
+    if (positional.size() == 2 && serveOn.empty()) {
+        path = positional[0];
+        out = positional[1];
+    } else if (positional.size() != 0) {
+        cerr << "usage: " << argv[0] << " [--workers N] [--split-sentences]"
+                << " [--use-trees] [--cache DIR] [--compress gzip|zstd]"
+                << " [--metrics FILE]"
+                << " [--shard i/N] [--dry-run] [--max-tokens N]"
+                << " [--long-sentences chunk|skip] [--sentence-timeout SECONDS]"
+                << " [--skip-log FILE] [--enrich] [--sentences N|N-M|N-]"
+                << " [--pack MB] [--serve SOCKET|- | input-dir output-dir]\n";
+        exit(1);
+    }
+
+    // Guarded sentences are listed next to the output by default
+    bool guarded = options.maxTokens > 0 || options.sentenceTimeout > 0;
+    if (guarded && options.skipLog.empty() && serveOn.empty())
+        options.skipLog = removeTrailingSlash(out) + "/skipped.log";
+
+    // Planning needs no models
+    if (options.dryRun) {
+        processBatch(path, out, options);
+        return 0;
+    }
+
     // Initialize SwiRL
     bool caseSensitive = true;
     if (!Swirl::initialize(swirl.c_str(), charniak.c_str(), caseSensitive)) {
@@ -220,8 +1678,25 @@ int main(int argc, char ** argv) {
         exit(1);
     }
 
-	// Process an entire directory of NLP annotations
-    processBatch(path, out);
+    // Cached output is only valid for the models that produced it
+    SrlCache* cache = NULL;
+    if (!cacheDir.empty()) {
+        cache = new SrlCache(cacheDir, SrlCache::fingerprint(swirl) + " "
+                + SrlCache::fingerprint(charniak));
+        if (!cache->is_open()) {
+            cerr << "Failed to open cache directory!\n";
+            exit(1);
+        }
+        options.cache = cache;
+    }
+
+    // Answer requests as they come, or process an entire directory of NLP
+    // annotations
+    if (!serveOn.empty())
+        serveRequests(serveOn, options);
+    else
+        processBatch(path, out, options);
+    delete cache;
 
     return 0;
 }
@@ -0,0 +1,890 @@
+/*
+ * tester.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "BatchJournal.h"
+#include "CompressedStream.h"
+#include "DocumentSerializer.h"
+#include "FileUtil.h"
+#include "MappedFile.h"
+#include "SegmentIndex.h"
+#include "SegmentWriter.h"
+#include "SentenceIndex.h"
+#include "SentenceReader.h"
+#include "SrlCache.h"
+#include "SrlExtractor.h"
+#include "SrlServer.h"
+#include "WorkerPool.h"
+
+using namespace std;
+using namespace processors;
+
+/* Number of failed checks */
+static int failures = 0;
+
+/**
+ * Report a check that failed.
+ *  @param ok The outcome of the check.
+ *  @param what What was checked.
+ */
+static void check(bool ok, const string &what) {
+    if (!ok) {
+        cerr << "FAILED: " << what << endl;
+        failures++;
+    }
+}
+
+/**
+ * Create an empty temporary directory.
+ */
+static string temporaryDirectory() {
+    char name[] = "/tmp/tester-XXXXXX";
+    if (mkdtemp(name) == NULL) {
+        cerr << "Cannot create a temporary directory!\n";
+        exit(1);
+    }
+    return name;
+}
+
+/**
+ * Remove a directory made by temporaryDirectory, and the files in it.
+ */
+static void removeDirectory(const string &path) {
+    DIR *dir = opendir(path.c_str());
+    if (dir == NULL)
+        return;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        string name = entry->d_name;
+        if (name != "." && name != "..")
+            unlink((path + "/" + name).c_str());
+    }
+    closedir(dir);
+    rmdir(path.c_str());
+}
+
+/**
+ * A handler that answers with the words of the sentence.
+ */
+static int echoWords(Sentence &sentence, string &result, void *) {
+    for (unsigned int i = 0; i < sentence.words.size(); i++)
+        result += sentence.words[i].str() + "\n";
+    return 0;
+}
+
+/**
+ * Wrap a document in a request.
+ *  @param id The request id.
+ *  @param document The document.
+ */
+static string request(const string &id, const string &document) {
+    ostringstream out;
+    out << "DOC " << id << " " << document.size() << "\n" << document;
+    return out.str();
+}
+
+/**
+ * Send requests to a server over a pair of files and collect the answers.
+ *  @param requests The requests.
+ *  @return Everything the server wrote back.
+ */
+static string exchange(const string &requests) {
+    char inName[] = "/tmp/tester-in-XXXXXX";
+    char outName[] = "/tmp/tester-out-XXXXXX";
+    int in = mkstemp(inName);
+    int out = mkstemp(outName);
+    if (in < 0 || out < 0
+            || write(in, requests.data(), requests.size())
+                    != (ssize_t) requests.size()
+            || lseek(in, 0, SEEK_SET) != 0) {
+        cerr << "Cannot create temporary files!\n";
+        exit(1);
+    }
+
+    SrlServer server(echoWords, NULL);
+    check(server.serve(in, out), "server starts");
+    close(in);
+    close(out);
+
+    ifstream answers(outName);
+    stringstream text;
+    text << answers.rdbuf();
+    unlink(inName);
+    unlink(outName);
+    return text.str();
+}
+
+/** A token line with all eight fields. */
+static string token(const string &word) {
+    return word + "\t0\t1\tNN\t" + word + "\tO\t_\tB-NP\n";
+}
+
+/** A sentence with dependencies, roles and a constituent tree. */
+static string annotatedSentence() {
+    return "T\t2\n" + token("a") + token("b")
+            + "D\n0\t1\tdet\nEOX\n"
+            + "R\t1\n1\tb\tA0\t0\t1\n"
+            + "Y\nS\t1\t0\t2\t2\ta\t0\t0\t1\t0\tb\t1\t1\t2\t0\n"
+            + "EOS\n";
+}
+
+/**
+ * Well-formed and malformed documents are told apart before they are loaded.
+ */
+static void testCheckText() {
+    string good = "S\t1\n" + annotatedSentence() + "EOD\n";
+    const char *malformed[] = {
+        "",
+        "X\t1\n",
+        "S\tone\n",
+        "S\t1\nT\t1\nfoo\n",
+        "S\t2\nT\t0\nEOS\n",
+        "S\t1\nT\t1\na\t0\t1\tNN\ta\tO\t_\tB-NP\n",
+        "S\t1\nT\t1\na\t0\t1\tNN\ta\tO\t_\tB-NP\nD\n0\t1\tdet\nEOS\n",
+        "S\t1\nT\t1\na\t0\t1\tNN\ta\tO\t_\tB-NP\nR\t1\n3\tb\nEOS\n",
+        "S\t1\nT\t1\na\t0\t1\tNN\ta\tO\t_\tB-NP\nR\t1\n0\tb\tA0\t0\t2\nEOS\n",
+        "S\t1\nT\t1\na\t0\t1\tNN\ta\tO\t_\tB-NP\nR\t1\n0\tb\tA0\nEOS\n",
+        "S\t1\nT\t1\na\t0\t1\tNN\ta\tO\t_\tB-NP\nY\nS\t0\t0\t1\t2\nEOS\n",
+        "S\t1\nT\t1\na\t0\t1\tNN\ta\tO\t_\tB-NP\nY\nS\t0\t0\nEOS\n",
+    };
+
+    check(DocumentSerializer::checkText(good.data(),
+            good.data() + good.size()), "well-formed document passes");
+    for (unsigned int i = 0; i < sizeof(malformed) / sizeof(*malformed);
+            i++) {
+        string text = malformed[i];
+        check(!DocumentSerializer::checkText(text.data(),
+                text.data() + text.size()),
+                "malformed document " + text + " is rejected");
+    }
+
+    // Every saved document passes
+    istringstream in(good);
+    Document doc;
+    DocumentSerializer::load(in, doc);
+    ostringstream saved;
+    DocumentSerializer::save(doc, saved);
+    string text = saved.str();
+    check(DocumentSerializer::checkText(text.data(), text.data()
+            + text.size()), "saved document passes");
+}
+
+/**
+ * The server labels a well-formed request, and rejects a malformed document
+ * instead of loading it.
+ */
+static void testServer() {
+    string good = "S\t1\nT\t2\n" + token("a") + token("b") + "EOS\n";
+    string answers = exchange(request("ok", good));
+    check(answers == "SENT ok 0 4\na\nb\nEND ok 1\n",
+            "well-formed request is labeled: " + answers);
+
+    answers = exchange(request("a", "S\t1\nT\t1\nfoo\n"));
+    check(answers == "ERR a malformed document\n",
+            "short token line is rejected: " + answers);
+
+    answers = exchange(request("b", "S\t1\nT\t1\n" + token("a")));
+    check(answers == "ERR b malformed document\n",
+            "sentence without EOS is rejected: " + answers);
+
+    // Requests before the malformed one are still answered
+    answers = exchange(request("c", good) + request("d", "S\t1\nT\t9\n"));
+    check(answers == "SENT c 0 4\na\nb\nEND c 1\nERR d malformed document\n",
+            "earlier request is answered: " + answers);
+}
+
+/** True if two lists of predicates are the same. */
+static bool samePredicates(const vector<SrlPredicate> &a,
+        const vector<SrlPredicate> &b) {
+    if (a.size() != b.size())
+        return false;
+    for (unsigned int i = 0; i < a.size(); i++) {
+        if (a[i].token != b[i].token || a[i].lemma != b[i].lemma
+                || a[i].arguments.size() != b[i].arguments.size())
+            return false;
+        for (unsigned int j = 0; j < a[i].arguments.size(); j++) {
+            const SrlArgument &x = a[i].arguments[j];
+            const SrlArgument &y = b[i].arguments[j];
+            if (x.label != y.label || x.startOffset != y.startOffset
+                    || x.endOffset != y.endOffset)
+                return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * The roles of a sentence are the same whether SwiRL just printed its
+ * output or the output was replayed from the cache, and the tables of a
+ * chunked sentence count their tokens from the start of the sentence.
+ */
+static void testExtractor() {
+    string table = "John\t-\t(A0*)\t*\n"
+            "wants\twant\t(V*)\t*\n"
+            "to\t-\t(A1*\t*\n"
+            "sleep\tsleep\t*)\t(V*)\n";
+    string output = "(S1 (S (NP John) (VP wants (S (VP to (VP sleep))))))"
+            "\n\n" + table + "\n";
+
+    vector<SrlPredicate> fresh;
+    check(SrlExtractor::extract(output, fresh), "SwiRL output is read");
+    check(fresh.size() == 2, "both predicates are found");
+    if (fresh.size() == 2) {
+        check(fresh[0].token == 1 && fresh[0].lemma == "want"
+                && fresh[0].arguments.size() == 2,
+                "first predicate and its arguments");
+        check(fresh[0].arguments.size() == 2
+                && fresh[0].arguments[0].role() == "A0"
+                && fresh[0].arguments[0].startOffset == 0
+                && fresh[0].arguments[0].endOffset == 1
+                && fresh[0].arguments[1].role() == "A1"
+                && fresh[0].arguments[1].startOffset == 2
+                && fresh[0].arguments[1].endOffset == 4,
+                "argument spans");
+        check(fresh[1].token == 3 && fresh[1].lemma == "sleep"
+                && fresh[1].arguments.empty(), "second predicate");
+    }
+
+    string directory = temporaryDirectory();
+    {
+        SrlCache cache(directory, "models");
+        string line = "0 John wants to sleep", replayed;
+        check(cache.is_open() && cache.insert(line, output)
+                && cache.lookup(line, replayed), "output is cached");
+        vector<SrlPredicate> cached;
+        check(SrlExtractor::extract(replayed, cached)
+                && samePredicates(fresh, cached),
+                "cached output gives the same predicates");
+    }
+    removeDirectory(directory);
+
+    // The sentence labeled in two chunks, each with its own predicates
+    string chunked = "# chunk 0-2\nJohn\t-\t(A0*)\nwants\twant\t(V*)\n\n"
+            "# chunk 2-4\nto\t-\t(A1*)\nsleep\tsleep\t(V*)\n\n";
+    vector<SrlPredicate> chunks;
+    check(SrlExtractor::extract(chunked, chunks) && chunks.size() == 2
+            && chunks[0].token == 1 && chunks[1].token == 3
+            && chunks[1].lemma == "sleep" && chunks[1].arguments.size() == 1
+            && chunks[1].arguments[0].startOffset == 2,
+            "chunks count their tokens from the start of the sentence");
+}
+
+/**
+ * Write text to a new temporary file.
+ *  @return The path of the file.
+ */
+static string temporaryFile(const string &text) {
+    char name[] = "/tmp/tester-file-XXXXXX";
+    int fd = mkstemp(name);
+    if (fd < 0 || write(fd, text.data(), text.size())
+            != (ssize_t) text.size()) {
+        cerr << "Cannot create a temporary file!\n";
+        exit(1);
+    }
+    close(fd);
+    return name;
+}
+
+/**
+ * Write text to a file.
+ *  @param path Path of the file.
+ *  @param text The text.
+ *  @param append Append to the file instead of replacing it.
+ */
+static void writeFile(const string &path, const string &text, bool append) {
+    ofstream out(path.c_str(), append ? ios::app : ios::trunc);
+    out << text;
+}
+
+/** Contents of a file; empty if it cannot be read. */
+static string readFile(const string &path) {
+    ifstream in(path.c_str());
+    ostringstream text;
+    text << in.rdbuf();
+    return text.str();
+}
+
+/**
+ * A text document of many sentences, large enough to be loaded in chunks.
+ *  @param sentences Number of sentences.
+ *  @param every Every how many sentences one ends with "EOS" and more
+ *  fields instead of a bare "EOS" line.
+ */
+static string largeDocument(int sentences, int every) {
+    ostringstream text;
+    text << "S\t" << sentences << "\n";
+    for (int i = 0; i < sentences; i++) {
+        text << "T\t8\n";
+        for (int j = 0; j < 8; j++) {
+            ostringstream word;
+            word << "w" << i << "_" << j;
+            text << token(word.str());
+        }
+        text << ((i % every == 0) ? "EOS\tend\n" : "EOS\n");
+    }
+    text << "EOD\n";
+    return text.str();
+}
+
+/** Text of a document as the serializer writes it. */
+static string savedText(const Document &doc) {
+    ostringstream out;
+    DocumentSerializer::save(doc, out);
+    return out.str();
+}
+
+/**
+ * Loading a large file on several threads gives the same document as
+ * loading it serially, including when sentences end in "EOS" lines with
+ * more fields, where the chunks are then cut.
+ */
+static void testParallelLoad() {
+    int every[] = { 1, 3 };
+    for (int i = 0; i < 2; i++) {
+        string path = temporaryFile(largeDocument(30000, every[i]));
+        {
+            MappedFile file(path);
+            Document serial, parallel;
+            DocumentSerializer::load(file, serial);
+            DocumentSerializer::load(file, 4, parallel);
+            check(serial.sentences.size() == 30000,
+                    "every sentence is loaded serially");
+            check(parallel.sentences.size() == serial.sentences.size()
+                    && savedText(parallel) == savedText(serial),
+                    "parallel load matches the serial one");
+        }
+        unlink(path.c_str());
+    }
+}
+
+/**
+ * The checksum of a possibly compressed input covers the whole file once it
+ * is closed, although the reader stops after the declared sentences, long
+ * before the end of the file.
+ */
+static void testStreamChecksum() {
+    string text = largeDocument(30000, 3);
+    text.replace(0, text.find('\n'), "S\t1");
+    Compression codecs[] = { COMPRESSION_NONE, COMPRESSION_GZIP };
+    for (int i = 0; i < 2; i++) {
+        string path = temporaryFile("");
+        CompressedOutputStream out(path, codecs[i]);
+        out << text;
+        out.close();
+
+        CompressedInputStream in(path, codecs[i]);
+        Document doc;
+        DocumentSerializer::load(in, doc);
+        in.close();
+        MappedFile file(path);
+        check(doc.sentences.size() == 1 && file.is_open()
+                && in.checksum() == bufferChecksum(file.begin(),
+                        file.size()),
+                string("checksum covers the whole file, compression ")
+                        + compressionSuffix(codecs[i]));
+        unlink(path.c_str());
+    }
+}
+
+/**
+ * Load a document in the binary format from a string.
+ *  @param bytes The encoded document.
+ *  @param doc Overwritten with the document.
+ *  @return False if it was rejected.
+ */
+static bool loadBinary(const string &bytes, Document &doc) {
+    istringstream in(bytes);
+    return DocumentSerializer::loadBinary(in, doc);
+}
+
+/**
+ * A document saved in the binary format loads back to the same text. A
+ * truncated file, an overlong varint and a NIL bitmap that declares more
+ * columns than the sentence stores are rejected, leaving the document
+ * empty.
+ */
+static void testBinary() {
+    string sentence = "T\t2\n" + token("a") + token("b")
+            + "R\t1\n1\tb\tA0\t0\t1\n"
+            + "Y\nS\t1\t0\t2\t2\ta\t0\t0\t1\t0\tb\t1\t1\t2\t0\n"
+            + "EOS\n";
+    string text = largeDocument(50, 7);
+    text.replace(0, text.find('\n'), "S\t51");
+    text.insert(text.size() - 4, sentence);
+    istringstream in(text);
+    Document doc;
+    DocumentSerializer::load(in, doc);
+    ostringstream binary;
+    DocumentSerializer::saveBinary(doc, binary);
+    string bytes = binary.str();
+
+    Document loaded;
+    check(loadBinary(bytes, loaded) && loaded.sentences.size() == 51
+            && savedText(loaded) == savedText(doc),
+            "binary document loads back to the same text");
+
+    // Every byte of the file is needed
+    bool rejected = true;
+    for (size_t length = 0; length < bytes.size(); length++) {
+        if (loadBinary(bytes.substr(0, length), loaded)
+                || !loaded.sentences.empty())
+            rejected = false;
+    }
+    check(rejected, "truncated binary document is rejected");
+
+    // A dictionary holding "a", then one sentence of two tokens "a" with
+    // only the words and offsets stored
+    string header = DocumentSerializer::BINARY_MAGIC + "\x03\x01\x01" "a";
+    string words("\x00\x00" "\x00\x02\x02\x02", 6);
+    check(loadBinary(header + "\x01\x02\x7f" + words, loaded)
+            && loaded.sentences.size() == 1
+            && loaded.sentences[0].words.str(1) == "a"
+            && loaded.sentences[0].endOffsets[1] == 3,
+            "hand-made binary document loads");
+    check(!loadBinary(header + string("\x81\x80\x80\x80\x80\x00", 6)
+            + "\x02\x7f" + words, loaded) && loaded.sentences.empty(),
+            "overlong varint is rejected");
+    check(!loadBinary(header + "\x01\x02\x7e" + words + string(1, '\0'),
+            loaded) && loaded.sentences.empty(),
+            "NIL bitmap that does not match the sentence is rejected");
+}
+
+/**
+ * A run resumed from a journal whose last record was torn by a crash skips
+ * only the inputs recorded in full, whatever part of the record was
+ * written, and the next record is read after the torn one.
+ */
+static void testJournalResume() {
+    string dir = temporaryDirectory();
+    const char *names[] = { "a", "b", "c" };
+    string inputs[3], outputs[3];
+    for (int i = 0; i < 3; i++) {
+        inputs[i] = dir + "/" + names[i] + ".txt";
+        outputs[i] = dir + "/" + names[i] + ".srl";
+        writeFile(inputs[i], string("input ") + names[i], false);
+        writeFile(outputs[i], string("output ") + names[i], false);
+    }
+
+    // The record of c, kept in a journal of its own to be torn
+    string scratch = temporaryDirectory();
+    {
+        BatchJournal journal(scratch);
+        journal.record(inputs[2], outputs[2]);
+    }
+    string record = readFile(scratch + "/" + BatchJournal::FILENAME);
+    removeDirectory(scratch);
+
+    string path = dir + "/" + BatchJournal::FILENAME;
+    bool skipped = true, resumed = true;
+    for (size_t cut = 1; cut < record.size(); cut++) {
+        unlink(path.c_str());
+        {
+            BatchJournal journal(dir);
+            journal.record(inputs[0], outputs[0]);
+            journal.record(inputs[1], outputs[1]);
+        }
+        writeFile(path, record.substr(0, cut), true);
+        {
+            BatchJournal journal(dir);
+            skipped = skipped && journal.size() == 2
+                    && journal.completed(inputs[0], outputs[0])
+                    && journal.completed(inputs[1], outputs[1])
+                    && !journal.completed(inputs[2], outputs[2]);
+            journal.record(inputs[2], outputs[2]);
+        }
+        BatchJournal journal(dir);
+        resumed = resumed && journal.size() == 3
+                && journal.completed(inputs[2], outputs[2]);
+    }
+    check(skipped, "only inputs recorded in full are skipped");
+    check(resumed, "record after a torn one is read");
+    removeDirectory(dir);
+}
+
+/**
+ * Write an output into a segment.
+ *  @return False if it could not be written.
+ */
+static bool writeOutput(SegmentWriter &writer, const string &name,
+        const string &text) {
+    long long length;
+    if (!writer.open(name))
+        return false;
+    writer.stream() << text;
+    return writer.close(length);
+}
+
+/** The bytes of an output in its segment; empty if it is not indexed. */
+static string readOutput(const SegmentIndex &index, const string &name) {
+    const SegmentIndex::Entry *entry = index.find(name);
+    if (entry == NULL)
+        return "";
+    MappedFile file(index.path(*entry));
+    if (!file.is_open() || entry->offset + entry->length
+            > (long long) file.size())
+        return "";
+    return string(file.begin() + entry->offset, entry->length);
+}
+
+/**
+ * A packed run resumed from a segment index whose last line was torn by a
+ * crash skips only the outputs that were committed and journaled, as the
+ * demo decides, whatever part of the line was written. Outputs committed
+ * after the torn line are indexed.
+ */
+static void testSegmentResume() {
+    // The index line of c, from a directory of its own to be torn; it
+    // points at the start of the first segment, like a's line
+    string scratch = temporaryDirectory();
+    {
+        SegmentWriter writer(scratch, COMPRESSION_NONE, 1 << 20);
+        writeOutput(writer, "c.srl", "output c");
+        writer.commit();
+    }
+    string line = readFile(scratch + "/" + SegmentIndex::FILENAME);
+    removeDirectory(scratch);
+
+    bool skipped = true, resumed = true;
+    for (size_t cut = 1; cut < line.size(); cut++) {
+        string dir = temporaryDirectory();
+        string inputs[3];
+        const char *names[] = { "a", "b", "c" };
+        for (int i = 0; i < 3; i++) {
+            inputs[i] = dir + "/" + names[i] + ".txt";
+            writeFile(inputs[i], string("input ") + names[i], false);
+        }
+        {
+            SegmentWriter writer(dir, COMPRESSION_NONE, 1 << 20);
+            writeOutput(writer, "a.srl", "output a");
+            writeOutput(writer, "b.srl", "output b");
+            writer.commit();
+            BatchJournal journal(dir);
+            journal.record(inputs[0], "a.srl", 8);
+            journal.record(inputs[1], "b.srl", 8);
+            journal.record(inputs[2], "c.srl", 8);
+        }
+        writeFile(dir + "/" + SegmentIndex::FILENAME, line.substr(0, cut),
+                true);
+
+        // c was journaled by another process, but never indexed here
+        {
+            SegmentIndex index(dir);
+            BatchJournal journal(dir);
+            for (int i = 0; i < 3; i++) {
+                string name = string(names[i]) + ".srl";
+                const SegmentIndex::Entry *entry = index.find(name);
+                bool skip = (entry != NULL)
+                        && journal.completed(inputs[i], name, entry->length);
+                skipped = skipped && skip == (i < 2);
+            }
+        }
+        {
+            SegmentWriter writer(dir, COMPRESSION_NONE, 1 << 20);
+            writeOutput(writer, "c.srl", "output C");
+            writer.commit();
+        }
+        SegmentIndex index(dir);
+        resumed = resumed && readOutput(index, "a.srl") == "output a"
+                && readOutput(index, "b.srl") == "output b"
+                && readOutput(index, "c.srl") == "output C";
+        removeDirectory(dir);
+    }
+    check(skipped, "only committed outputs are skipped");
+    check(resumed, "outputs committed after a torn index line are read");
+}
+
+/**
+ * Set the modification time of a file.
+ *  @param path Path of the file.
+ *  @param seconds The time, in seconds since the epoch.
+ */
+static void setModified(const string &path, time_t seconds) {
+    struct timespec times[2];
+    times[0].tv_sec = times[1].tv_sec = seconds;
+    times[0].tv_nsec = times[1].tv_nsec = 0;
+    utimensat(AT_FDCWD, path.c_str(), times, 0);
+}
+
+/**
+ * An index built from an annotation points at every sentence, and loads
+ * back from its sidecar until the annotation changes size or modification
+ * time; open() then indexes the annotation again.
+ */
+static void testSentenceIndex() {
+    string path = temporaryFile(largeDocument(200, 5));
+    setModified(path, 1000000000);
+    {
+        MappedFile file(path);
+        SentenceIndex index;
+        bool found = index.build(file) && index.size() == 200;
+        for (size_t i = 0; found && i < index.size(); i++) {
+            // From its "T" line to the end of its "EOS" line
+            string text(file.begin() + index.begin(i),
+                    index.end(i) - index.begin(i));
+            string::size_type last = text.rfind('\n', text.size() - 2);
+            found = text.compare(0, 2, "T\t") == 0 && last != string::npos
+                    && text.compare(last + 1, 3, "EOS") == 0
+                    && text[text.size() - 1] == '\n';
+        }
+        check(found, "index points at every sentence");
+        check(index.save(path), "index is saved");
+
+        SentenceIndex loaded;
+        bool same = loaded.load(path) && loaded.size() == index.size();
+        for (size_t i = 0; same && i < index.size(); i++)
+            same = loaded.begin(i) == index.begin(i)
+                    && loaded.end(i) == index.end(i);
+        check(same, "index loads back from its sidecar");
+    }
+
+    // A newer annotation of the same size
+    SentenceIndex stale;
+    setModified(path, 1000000001);
+    check(!stale.load(path), "index of a touched annotation is stale");
+
+    // A longer annotation with the stamped modification time
+    writeFile(path, "\n", true);
+    setModified(path, 1000000000);
+    check(!stale.load(path), "index of a grown annotation is stale");
+    MappedFile file(path);
+    check(stale.open(path, file) && stale.size() == 200,
+            "stale index is rebuilt");
+    unlink((path + SentenceIndex::SUFFIX).c_str());
+    unlink(path.c_str());
+}
+
+/**
+ * A range of sentences read through the index matches the same sentences
+ * of a full load, and ranges past the end are clamped.
+ */
+static void testRangedReader() {
+    string path = temporaryFile(largeDocument(200, 5));
+    {
+        MappedFile file(path);
+        SentenceIndex index;
+        index.build(file);
+
+        int ranges[][3] = {
+            { 10, 20, 10 }, { 0, 1, 1 }, { 150, -1, 50 }, { 195, 1000, 5 },
+            { 250, -1, 0 }
+        };
+        for (unsigned int i = 0; i < sizeof(ranges) / sizeof(*ranges); i++) {
+            SentenceReader reader(file, index, ranges[i][0], ranges[i][1]);
+            Document part;
+            DocumentSerializer::load(reader, part);
+
+            // The same sentences, taken out of a full load
+            Document full, expected;
+            DocumentSerializer::load(file, full);
+            expected.sentences.resize(ranges[i][2]);
+            for (int j = 0; j < ranges[i][2]; j++)
+                expected.sentences[j].swap(full.sentences[ranges[i][0] + j]);
+            bool same = reader.size() == ranges[i][2]
+                    && reader.first() == ranges[i][0]
+                    && savedText(part) == savedText(expected);
+            ostringstream what;
+            what << "range " << ranges[i][0] << "-" << ranges[i][1]
+                    << " reads the same sentences";
+            check(same, what.str());
+        }
+    }
+    unlink(path.c_str());
+}
+
+/** True if two string columns hold the same values. */
+static bool sameColumn(const StringColumn &a, const StringColumn &b) {
+    if (a.size() != b.size())
+        return false;
+    for (unsigned int i = 0; i < a.size(); i++) {
+        if (a[i].str() != b[i].str())
+            return false;
+    }
+    return true;
+}
+
+/**
+ * True if two sentences hold the same annotations. Unlike savedText(), this
+ * also compares sentences without offsets, which cannot be saved.
+ */
+static bool sameSentence(const Sentence &a, const Sentence &b) {
+    if (!sameColumn(a.words, b.words) || a.startOffsets != b.startOffsets
+            || a.endOffsets != b.endOffsets || a.tags != b.tags
+            || !sameColumn(a.lemmas, b.lemmas) || a.entities != b.entities
+            || !sameColumn(a.norms, b.norms) || a.chunks != b.chunks
+            || !samePredicates(a.predicates, b.predicates)
+            || a.dependencies != b.dependencies
+            || a.syntacticTree.nodes.size() != b.syntacticTree.nodes.size())
+        return false;
+    for (unsigned int i = 0; i < a.syntacticTree.nodes.size(); i++) {
+        const SyntacticTree::Node &x = a.syntacticTree.nodes[i];
+        const SyntacticTree::Node &y = b.syntacticTree.nodes[i];
+        if (x.value != y.value || x.head != y.head
+                || x.startOffset != y.startOffset
+                || x.endOffset != y.endOffset || x.children != y.children)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Clear the columns of a sentence that are not in a mask, as a projected
+ * load leaves them.
+ *  @param sentence The sentence.
+ *  @param columns Mask of DocumentSerializer::Column values to keep.
+ */
+static void keepColumns(Sentence &sentence, unsigned int columns) {
+    if (!(columns & DocumentSerializer::COLUMN_OFFSETS)) {
+        sentence.startOffsets.clear();
+        sentence.endOffsets.clear();
+    }
+    if (!(columns & DocumentSerializer::COLUMN_TAGS))
+        sentence.tags.clear();
+    if (!(columns & DocumentSerializer::COLUMN_LEMMAS))
+        sentence.lemmas.clear();
+    if (!(columns & DocumentSerializer::COLUMN_ENTITIES))
+        sentence.entities.clear();
+    if (!(columns & DocumentSerializer::COLUMN_NORMS))
+        sentence.norms.clear();
+    if (!(columns & DocumentSerializer::COLUMN_CHUNKS))
+        sentence.chunks.clear();
+    if (!(columns & DocumentSerializer::COLUMN_TREE))
+        sentence.syntacticTree.clear();
+    if (!(columns & DocumentSerializer::COLUMN_ROLES))
+        sentence.predicates.clear();
+    if (!(columns & DocumentSerializer::COLUMN_DEPENDENCIES))
+        sentence.dependencies.clear();
+}
+
+/**
+ * Loading only some columns gives the same sentences as a full load with
+ * the other columns cleared, for each column on its own, for all but one,
+ * and for the columns SwiRL reads.
+ */
+static void testColumns() {
+    // Annotated sentences between plain ones, some ending in "EOS" lines
+    // with more fields
+    string large = largeDocument(40, 3);
+    size_t body = large.find('\n') + 1;
+    string sentences = large.substr(body, large.size() - body - 4);
+    string path = temporaryFile("S\t83\n" + annotatedSentence() + sentences
+            + annotatedSentence() + sentences + annotatedSentence()
+            + "EOD\n");
+    {
+        MappedFile file(path);
+        Document full;
+        DocumentSerializer::load(file, full);
+        check(full.sentences.size() == 83
+                && !full.sentences[0].syntacticTree.empty()
+                && !full.sentences[0].predicates.empty()
+                && !full.sentences[0].dependencies.empty(),
+                "projection document is fully annotated");
+
+        vector<unsigned int> masks;
+        masks.push_back(DocumentSerializer::COLUMN_WORDS);
+        for (unsigned int column = DocumentSerializer::COLUMN_OFFSETS;
+                column < DocumentSerializer::COLUMN_ALL; column <<= 1) {
+            masks.push_back(DocumentSerializer::COLUMN_WORDS | column);
+            masks.push_back(DocumentSerializer::COLUMN_ALL & ~column);
+        }
+        masks.push_back(DocumentSerializer::COLUMN_WORDS
+                | DocumentSerializer::COLUMN_TAGS
+                | DocumentSerializer::COLUMN_ENTITIES);
+        for (unsigned int i = 0; i < masks.size(); i++) {
+            SentenceReader reader(file);
+            reader.setColumns(masks[i]);
+            Document projected, expected;
+            DocumentSerializer::load(reader, projected);
+            DocumentSerializer::load(file, expected);
+            bool same = projected.sentences.size() == expected.sentences.size();
+            for (unsigned int j = 0; same && j < expected.sentences.size();
+                    j++) {
+                keepColumns(expected.sentences[j], masks[i]);
+                same = sameSentence(projected.sentences[j],
+                        expected.sentences[j]);
+            }
+            ostringstream what;
+            what << "columns " << masks[i] << " load the same sentences";
+            check(same, what.str());
+        }
+    }
+    unlink(path.c_str());
+}
+
+/** Task handler that reports the process id of its worker. */
+static int reportPid(const string &, string &result, void *) {
+    ostringstream pid;
+    pid << getpid();
+    result = pid.str();
+    return 0;
+}
+
+/**
+ * A task sent to a worker that died while idle is not delivered, and the
+ * write does not raise SIGPIPE in the parent, which keeps its default
+ * disposition of the signal.
+ */
+static void testDeadWorker() {
+    struct sigaction before, after;
+    sigaction(SIGPIPE, NULL, &before);
+    WorkerPool pool(1, reportPid, NULL);
+    check(pool.start(), "worker pool starts");
+
+    long id;
+    int status;
+    string result;
+    bool ok = pool.submit(1, "pid") && pool.collect(id, status, result)
+            && status == 0;
+    check(ok, "worker reports its process id");
+    kill(atoi(result.c_str()), SIGKILL);
+    usleep(100000);
+
+    check(!pool.submit(2, string(1 << 20, 'x')) && pool.size() == 0,
+            "task is not sent to a dead worker");
+    sigset_t pending;
+    sigpending(&pending);
+    sigaction(SIGPIPE, NULL, &after);
+    check(!sigismember(&pending, SIGPIPE)
+            && after.sa_handler == before.sa_handler,
+            "SIGPIPE is neither left pending nor ignored");
+}
+
+/**
+ * Run the tests.
+ *  usage: tester
+ */
+int main(int argc, char ** argv) {
+    testCheckText();
+    testServer();
+    testExtractor();
+    testParallelLoad();
+    testStreamChecksum();
+    testBinary();
+    testJournalResume();
+    testSegmentResume();
+    testSentenceIndex();
+    testRangedReader();
+    testColumns();
+    testDeadWorker();
+    if (failures > 0) {
+        cerr << failures << " checks failed\n";
+        return 1;
+    }
+    cout << "All tests passed\n";
+    return 0;
+}
@@ -0,0 +1,74 @@
+/*
+ * convert.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#include <iostream>
+#include <fstream>
+#include <string>
+
+#include "CompressedStream.h"
+#include "DocumentSerializer.h"
+
+using namespace std;
+using namespace processors;
+
+/**
+ * Convert an NLP annotation between the text and binary formats.
+ * The format of the input is detected automatically.
+ *  usage: convert (--text|--binary) <input> <output>
+ */
+int main(int argc, char ** argv) {
+    if (argc != 4 || (string(argv[1]) != "--text"
+            && string(argv[1]) != "--binary")) {
+        cerr << "usage: " << argv[0] << " (--text|--binary) <input> <output>\n";
+        return 1;
+    }
+    bool toBinary = (string(argv[1]) == "--binary");
+
+    // Compression of either file follows its extension (.gz, .zst)
+    CompressedInputStream in(argv[2]);
+    if (!in.is_open()) {
+        cerr << "Failed to find annotation file!\n";
+        return 1;
+    }
+
+    // Sentences are swapped into place rather than copied
+    Document doc;
+    if (DocumentSerializer::isBinary(in)) {
+        if (!DocumentSerializer::loadBinary(in, doc)) {
+            cerr << "Corrupt binary annotation file!\n";
+            return 1;
+        }
+    } else if (compressionOf(argv[2]) == COMPRESSION_NONE) {
+        // Plain text is parsed straight from a mapping, on every CPU
+        MappedFile file(argv[2]);
+        DocumentSerializer::load(file, 0, doc);
+    } else {
+        DocumentSerializer::load(in, doc);
+    }
+    in.close();
+    if (in.fail()) {
+        cerr << "Corrupt compressed file!\n";
+        return 1;
+    }
+
+    CompressedOutputStream out(argv[3], compressionOf(argv[3]));
+    if (!out.is_open()) {
+        cerr << "Failed to open output file!\n";
+        return 1;
+    }
+    if (toBinary)
+        DocumentSerializer::saveBinary(doc, out);
+    else
+        DocumentSerializer::save(doc, out);
+    out.close();
+    if (out.fail()) {
+        cerr << "Failed to write output file!\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,130 @@
+/*
+ * segment_extract.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+#include "SegmentIndex.h"
+
+using namespace std;
+using namespace processors;
+
+typedef pair<string, const SegmentIndex::Entry *> Output;
+
+/**
+ * Segment order, then offset order, so that segments are read sequentially.
+ */
+static bool segmentOrder(const Output &a, const Output &b) {
+    if (a.second->segment != b.second->segment)
+        return a.second->segment < b.second->segment;
+    return a.second->offset < b.second->offset;
+}
+
+/**
+ * Copy outputs out of their segments, mapping each segment once.
+ * 	@param index The index of the segments.
+ * 	@param outputs The outputs, in segment order.
+ * 	@param destination Directory to write each output to a file of its own
+ * 	in, or empty for stdout.
+ * 	@return Number of outputs that could not be copied.
+ */
+static int extract(const SegmentIndex &index, const vector<Output> &outputs,
+        const string &destination) {
+    int failed = 0;
+    MappedFile *segment = NULL;
+    string current;
+    for (unsigned int i = 0; i < outputs.size(); i++) {
+        const SegmentIndex::Entry &entry = *outputs[i].second;
+        if (segment == NULL || entry.segment != current) {
+            delete segment;
+            segment = new MappedFile(index.path(entry));
+            current = entry.segment;
+        }
+        if (!segment->is_open()
+                || entry.offset + entry.length > (long long) segment->size()) {
+            cerr << "Failed to read segment: " << index.path(entry) << endl;
+            failed++;
+            continue;
+        }
+        const char *data = segment->begin() + entry.offset;
+        if (destination.empty()) {
+            cout.write(data, entry.length);
+            continue;
+        }
+        string path = destination + "/" + outputs[i].first;
+        ofstream out(path.c_str(), ios::binary);
+        out.write(data, entry.length);
+        out.close();
+        if (!out) {
+            cerr << "Failed to write output file: " << path << endl;
+            failed++;
+        }
+    }
+    delete segment;
+    return failed;
+}
+
+/**
+ * List the outputs packed into the segments of an output directory, print
+ * some of them, or unpack all of them into files of their own (identical to
+ * the files a run without --pack writes).
+ *  usage: segment_extract <output-dir>
+ *         segment_extract <output-dir> <name>...
+ *         segment_extract --unpack <output-dir> <destination-dir>
+ */
+int main(int argc, char ** argv) {
+    bool unpack = (argc == 4 && string(argv[1]) == "--unpack");
+    if (argc < 2 || (!unpack && string(argv[1]).compare(0, 2, "--") == 0)) {
+        cerr << "usage: " << argv[0] << " <output-dir> [<name>...]\n"
+                << "       " << argv[0]
+                << " --unpack <output-dir> <destination-dir>\n";
+        return 1;
+    }
+    string directory = unpack ? argv[2] : argv[1];
+    SegmentIndex index(directory);
+    if (!index.is_open()) {
+        cerr << "Failed to find segment index in: " << directory << endl;
+        return 1;
+    }
+
+    const map<string, SegmentIndex::Entry> &entries = index.entries();
+    map<string, SegmentIndex::Entry>::const_iterator it;
+    if (argc == 2) {
+        for (it = entries.begin(); it != entries.end(); ++it)
+            cout << it->first << "\t" << it->second.length << "\t"
+                    << it->second.segment << "\t" << it->second.offset
+                    << endl;
+        return 0;
+    }
+
+    vector<Output> outputs;
+    int missing = 0;
+    if (unpack) {
+        for (it = entries.begin(); it != entries.end(); ++it)
+            outputs.push_back(Output(it->first, &it->second));
+        sort(outputs.begin(), outputs.end(), segmentOrder);
+    } else {
+        // Printed in the order asked for
+        for (int i = 2; i < argc; i++) {
+            const SegmentIndex::Entry *entry = index.find(argv[i]);
+            if (entry == NULL) {
+                cerr << "No such output: " << argv[i] << endl;
+                missing++;
+            } else {
+                outputs.push_back(Output(argv[i], entry));
+            }
+        }
+    }
+    int failed = extract(index, outputs, unpack ? argv[3] : "");
+    if (unpack)
+        cerr << outputs.size() - failed << " outputs unpacked" << endl;
+    return (missing + failed > 0) ? 1 : 0;
+}
@@ -0,0 +1,71 @@
+/*
+ * sentence_index.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: trananh
+ */
+
+#include <iostream>
+#include <string>
+
+#include "DocumentSerializer.h"
+#include "MappedFile.h"
+#include "SentenceIndex.h"
+#include "SentenceReader.h"
+
+using namespace std;
+using namespace processors;
+
+/**
+ * Build the sidecar sentence index of annotation files (text format,
+ * uncompressed), or print a range of sentences of one file through it.
+ *  usage: sentence_index <annotation>...
+ *         sentence_index --show <annotation> N|N-M|N-
+ */
+int main(int argc, char ** argv) {
+    bool show = (argc == 4 && string(argv[1]) == "--show");
+    if (argc < 2 || (!show && string(argv[1]).compare(0, 2, "--") == 0)) {
+        cerr << "usage: " << argv[0] << " <annotation>...\n"
+                << "       " << argv[0] << " --show <annotation> N|N-M|N-\n";
+        return 1;
+    }
+
+    if (show) {
+        int first, last;
+        if (!SentenceIndex::parseRange(argv[3], first, last)) {
+            cerr << "Invalid range: " << argv[3] << endl;
+            return 1;
+        }
+        MappedFile file(argv[2]);
+        SentenceIndex index;
+        if (!file.is_open() || !index.open(argv[2], file)) {
+            cerr << "Failed to index annotation file: " << argv[2] << endl;
+            return 1;
+        }
+        SentenceReader reader(file, index, first, last);
+        Document doc;
+        DocumentSerializer::load(reader, doc);
+        DocumentSerializer::save(doc, cout);
+        if (reader.size() > 0)
+            cerr << "Sentences " << first << "-" << first + reader.size() - 1
+                    << " of " << index.size() << endl;
+        else
+            cerr << "No sentences in range (the file has " << index.size()
+                    << ")" << endl;
+        return 0;
+    }
+
+    int failed = 0;
+    for (int i = 1; i < argc; i++) {
+        MappedFile file(argv[i]);
+        SentenceIndex index;
+        if (!file.is_open() || !index.build(file) || !index.save(argv[i])) {
+            cerr << "Failed to index annotation file: " << argv[i] << endl;
+            failed++;
+            continue;
+        }
+        cout << argv[i] << SentenceIndex::SUFFIX << ": " << index.size()
+                << " sentences" << endl;
+    }
+    return failed > 0 ? 1 : 0;
+}